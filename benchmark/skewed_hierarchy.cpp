@@ -0,0 +1,213 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Benchmark of the engines on skewed coupled model hierarchies
+ *
+ * The top model has a couple of atomic models and a coupled model, which has a couple of atomic
+ * models and a coupled model, and so on, so most of the work is deep in a single branch of the tree.
+ * Every atomic model burns some CPU in its output and internal transition functions.
+ *
+ * Usage: skewed_hierarchy [steps [work [threads...]]]
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/message_bag.hpp>
+#include <cadmium/modeling/coupled_model.hpp>
+#include <cadmium/engine/pdevs_coordinator.hpp>
+#include <cadmium/engine/pdevs_flat_coordinator.hpp>
+#include <cadmium/engine/pdevs_parallel_coordinator.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+namespace {
+    //iterations of the busy loop run on each output and internal transition
+    std::uint64_t work_per_transition=20000;
+
+    std::uint64_t busy_loop(std::uint64_t seed) {
+        std::uint64_t x = seed | 1;
+        for (std::uint64_t i = 0; i < work_per_transition; ++i) { //xorshift
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+        }
+        return x;
+    }
+
+    struct busy_defs{
+        struct out : public cadmium::out_port<std::uint64_t>{};
+    };
+
+    //an atomic model scheduled every second, the LEVEL and ID make every model in the tree a different type
+    template<int LEVEL, int ID, typename TIME>
+    class busy_model {
+    public:
+        using state_type=std::uint64_t;
+        state_type state = LEVEL * 100 + ID;
+
+        using input_ports=std::tuple<>;
+        using output_ports=std::tuple<busy_defs::out>;
+
+        void internal_transition() {
+            state = busy_loop(state);
+        }
+
+        void external_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {}
+
+        void confluence_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {}
+
+        typename cadmium::make_message_bags<output_ports>::type output() const {
+            typename cadmium::make_message_bags<output_ports>::type bags;
+            cadmium::get_messages<busy_defs::out>(bags).push_back(busy_loop(state + 1));
+            return bags;
+        }
+
+        TIME time_advance() const {
+            return 1;
+        }
+    };
+
+    struct skewed_out : public cadmium::out_port<std::uint64_t>{};
+
+    //a level of the hierarchy, two atomic models and the next level
+    template<int LEVEL>
+    struct skewed_level {
+        template<typename TIME>
+        using first=busy_model<LEVEL, 0, TIME>;
+        template<typename TIME>
+        using second=busy_model<LEVEL, 1, TIME>;
+        template<typename TIME>
+        using next=typename skewed_level<LEVEL - 1>::template type<TIME>;
+
+        using submodels=cadmium::modeling::models_tuple<first, second, next>;
+        using eocs=std::tuple<
+            cadmium::modeling::EOC<first, busy_defs::out, skewed_out>,
+            cadmium::modeling::EOC<second, busy_defs::out, skewed_out>,
+            cadmium::modeling::EOC<next, skewed_out, skewed_out>
+        >;
+
+        template<typename TIME>
+        using type=cadmium::modeling::coupled_model<TIME, std::tuple<>, std::tuple<skewed_out>, submodels, std::tuple<>, eocs, std::tuple<>>;
+    };
+
+    //the deepest level has the widest set of atomic models
+    template<>
+    struct skewed_level<0> {
+        template<typename TIME>
+        using m0=busy_model<0, 0, TIME>;
+        template<typename TIME>
+        using m1=busy_model<0, 1, TIME>;
+        template<typename TIME>
+        using m2=busy_model<0, 2, TIME>;
+        template<typename TIME>
+        using m3=busy_model<0, 3, TIME>;
+        template<typename TIME>
+        using m4=busy_model<0, 4, TIME>;
+        template<typename TIME>
+        using m5=busy_model<0, 5, TIME>;
+
+        using submodels=cadmium::modeling::models_tuple<m0, m1, m2, m3, m4, m5>;
+        using eocs=std::tuple<
+            cadmium::modeling::EOC<m0, busy_defs::out, skewed_out>,
+            cadmium::modeling::EOC<m1, busy_defs::out, skewed_out>,
+            cadmium::modeling::EOC<m2, busy_defs::out, skewed_out>,
+            cadmium::modeling::EOC<m3, busy_defs::out, skewed_out>,
+            cadmium::modeling::EOC<m4, busy_defs::out, skewed_out>,
+            cadmium::modeling::EOC<m5, busy_defs::out, skewed_out>
+        >;
+
+        template<typename TIME>
+        using type=cadmium::modeling::coupled_model<TIME, std::tuple<>, std::tuple<skewed_out>, submodels, std::tuple<>, eocs, std::tuple<>>;
+    };
+
+    template<typename TIME>
+    using skewed_model=skewed_level<5>::type<TIME>;
+
+    //runs the steps and returns the seconds spent and the sum of the output messages as checksum
+    template<typename ENGINE>
+    double run(ENGINE& engine, int steps, std::uint64_t& checksum) {
+        auto start = std::chrono::steady_clock::now();
+        engine.init(0);
+        checksum = 0;
+        for (int i = 0; i < steps; ++i) {
+            double t = engine.next();
+            engine.collect_outputs(t);
+            for (auto m : cadmium::get_messages<skewed_out>(engine.outbox())) {
+                checksum += m;
+            }
+            engine.advance_simulation(t);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    }
+
+    void report(const std::string& engine, double seconds, double sequential, std::uint64_t checksum, std::uint64_t expected) {
+        std::cout << engine << ": " << seconds << "s, speedup " << sequential / seconds;
+        std::cout << (checksum == expected ? "" : " (WRONG OUTPUT)") << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    using not_logger=cadmium::logger::not_logger;
+    int steps = argc > 1 ? std::atoi(argv[1]) : 100;
+    if (argc > 2) {
+        work_per_transition = std::strtoull(argv[2], nullptr, 10);
+    }
+    std::vector<std::size_t> threads;
+    for (int i = 3; i < argc; ++i) {
+        threads.push_back(std::strtoul(argv[i], nullptr, 10));
+    }
+    if (threads.empty()) {
+        threads = {2, 4, std::thread::hardware_concurrency()};
+    }
+
+    std::cout << "Skewed hierarchy of 16 atomic models in 6 levels, " << steps << " steps, ";
+    std::cout << work_per_transition << " iterations per transition" << std::endl;
+
+    std::uint64_t expected;
+    cadmium::engine::coordinator<skewed_model, double, not_logger, cadmium::engine::heap_fel> sequential;
+    double sequential_time = run(sequential, steps, expected);
+    report("coordinator", sequential_time, sequential_time, expected, expected);
+
+    std::uint64_t checksum;
+    cadmium::engine::flat_coordinator<skewed_model, double, not_logger> flat;
+    double flat_time = run(flat, steps, checksum);
+    report("flat_coordinator", flat_time, sequential_time, checksum, expected);
+
+    for (auto n : threads) {
+        cadmium::engine::parallel_coordinator<skewed_model, double, not_logger> parallel(n);
+        double parallel_time = run(parallel, steps, checksum);
+        report("parallel_coordinator " + std::to_string(n) + " threads", parallel_time, sequential_time, checksum, expected);
+    }
+    return 0;
+}
@@ -34,6 +34,7 @@
 #include <cadmium/modeling/ports.hpp>
 #include <cadmium/concept/coupled_model_assert.hpp>
 #include <cadmium/engine/pdevs_runner.hpp>
+#include <cadmium/modeling/time.hpp>
 using namespace std;
 
 using hclock=chrono::high_resolution_clock;
@@ -44,6 +45,7 @@ using hclock=chrono::high_resolution_clock;
  * The generators are connected to 3 ports (H, M, S)
  *
  * The experiment runtime is measured using the chrono library.
+ * Time is counted in milliseconds, so the needles stay exact through the whole run, what float time can not do.
  */
 
 
@@ -58,8 +60,8 @@ using tick_generator_base=cadmium::basic_models::generator<tick, TIME>;
 
 template<typename TIME>
 struct hour_generator : public tick_generator_base<TIME> {
-    float period() const override {
-        return 3600.0f; //using float for time in this example
+    TIME period() const override {
+        return TIME{3600};
     }
     tick output_message() const override {
         return tick();
@@ -68,8 +70,8 @@ struct hour_generator : public tick_generator_base<TIME> {
 
 template<typename TIME>
 struct minute_generator : public tick_generator_base<TIME> {
-    float period() const override {
-        return 60.0f; //using float for time in this example
+    TIME period() const override {
+        return TIME{60};
     }
     tick output_message() const override {
         return tick();
@@ -78,8 +80,8 @@ struct minute_generator : public tick_generator_base<TIME> {
 
 template<typename TIME>
 struct second_generator : public tick_generator_base<TIME> {
-    float period() const override {
-        return 1.0f; //using float for time in this example
+    TIME period() const override {
+        return TIME{1};
     }
     tick output_message() const override {
         return tick();
@@ -108,8 +110,9 @@ using clock_model=cadmium::modeling::coupled_model<TIME, iports, oports, submode
 int main(){
     auto start = hclock::now(); //to measure simulation execution time
 
-    cadmium::engine::runner<float, clock_model> r{0.0};
-    r.runUntil(30000.0);
+    using clock_time=cadmium::time::ticks<std::milli>;
+    cadmium::engine::runner<clock_time, clock_model> r{clock_time{}};
+    r.runUntil(clock_time{30000});
 
     auto elapsed = std::chrono::duration_cast<std::chrono::duration<double, std::ratio<1>>>
                                                                                           (hclock::now() - start).count();
@@ -30,6 +30,7 @@
 #include<cadmium/modeling/ports.hpp>
 #include<cadmium/modeling/message_bag.hpp>
 #include<limits>
+#include<stdexcept>
 
 
 namespace cadmium {
@@ -0,0 +1,303 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CADMIUM_EVENT_TRACE_HPP
+#define CADMIUM_EVENT_TRACE_HPP
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cadmium/modeling/message_bag.hpp>
+
+/**
+ * Binary traces of input events
+ *
+ * Traces keep the messages in the input ports of a model for replaying them, or the messages in its output ports
+ * written as the simulation runs.
+ * A trace starts with a header: 8 bytes of magic, the size of TIME and the number of input ports, both as uint32.
+ * The records follow ordered by time, each is the time, the index of the port in the input ports of the model as
+ * uint32 and a message of the port in native layout. Messages are required to be trivially copyable, so reading
+ * a record is copying its bytes, and traces can only be read by builds with the same layout than the writer.
+ */
+namespace cadmium {
+    namespace engine {
+        constexpr char event_trace_magic[8]={'C', 'D', 'M', 'T', 'R', 'C', '0', '1'};
+
+        /**
+         * @brief trace_writer writes a trace of messages for the ports in INPUT_PORTS, which are the output
+         * ports of the model when writing its outputs
+         */
+        template<typename TIME, typename INPUT_PORTS>
+        class trace_writer {
+            using bags_type=typename make_message_bags<INPUT_PORTS>::type;
+
+            std::unique_ptr<char[]> _buffer;
+            std::ofstream _os;
+
+            template<typename PORT>
+            void write_bag(const TIME& t, const message_bag<PORT>& bag) {
+                for (const auto& m : bag.messages) {
+                    write<PORT>(t, m);
+                }
+            }
+
+            template<std::size_t... Is>
+            void write_bags(const TIME& t, const bags_type& bags, std::index_sequence<Is...>) {
+                int expand[] = {0, (write_bag(t, std::get<Is>(bags)), 0)...};
+                (void)expand;
+            }
+
+            void write_bytes(const void* data, std::size_t size) {
+                _os.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+                if (!_os) {
+                    throw std::runtime_error("Failed writing the trace");
+                }
+            }
+
+        public:
+            /**
+             * @brief trace_writer creates the trace in path
+             * @param buffer_size is the size of the buffer the records are written to before reaching the file
+             */
+            explicit trace_writer(const std::string& path, std::size_t buffer_size=1 << 20) : _buffer(new char[buffer_size]) {
+                _os.rdbuf()->pubsetbuf(_buffer.get(), static_cast<std::streamsize>(buffer_size));
+                _os.open(path, std::ios::binary | std::ios::trunc);
+                if (!_os) {
+                    throw std::runtime_error("Failed to create the trace " + path);
+                }
+                std::uint32_t header[2]={static_cast<std::uint32_t>(sizeof(TIME)), static_cast<std::uint32_t>(std::tuple_size<INPUT_PORTS>::value)};
+                write_bytes(event_trace_magic, sizeof(event_trace_magic));
+                write_bytes(header, sizeof(header));
+            }
+
+            /**
+             * @brief write adds a message for PORT at time t, the times written can not decrease
+             */
+            template<typename PORT>
+            void write(const TIME& t, const typename PORT::message_type& message) {
+                static_assert(std::is_trivially_copyable<typename PORT::message_type>::value, "Messages in traces need to be trivially copyable");
+                std::uint32_t port = port_index<PORT, bags_type>::value;
+                write_bytes(&t, sizeof(TIME));
+                write_bytes(&port, sizeof(port));
+                write_bytes(&message, sizeof(message));
+            }
+
+            /**
+             * @brief write_bags adds all the messages in the bags at time t, port by port
+             */
+            void write_bags(const TIME& t, const bags_type& bags) {
+                write_bags(t, bags, std::make_index_sequence<std::tuple_size<INPUT_PORTS>::value>{});
+            }
+
+            /**
+             * @brief close flushes the trace, the destructor closes it too but can not report failures
+             */
+            void close() {
+                _os.close();
+                if (!_os) {
+                    throw std::runtime_error("Failed writing the trace");
+                }
+            }
+        };
+
+        /**
+         * @brief trace_reader maps a trace file in memory and reads its records step by step, only the pages
+         * of the records read are loaded.
+         */
+        template<typename TIME, typename INPUT_PORTS>
+        class trace_reader {
+        public:
+            using bags_type=typename make_message_bags<INPUT_PORTS>::type;
+
+        private:
+            static constexpr std::size_t header_size=sizeof(event_trace_magic) + 2 * sizeof(std::uint32_t);
+            static constexpr std::size_t port_count=std::tuple_size<INPUT_PORTS>::value;
+
+            using message_reader=void(*)(bags_type&, const unsigned char*);
+
+            template<typename PORT>
+            static void read_message(bags_type& bags, const unsigned char* from, std::true_type) {
+                typename PORT::message_type m;
+                std::memcpy(&m, from, sizeof(m));
+                get_messages<PORT>(bags).push_back(m);
+            }
+
+            template<typename PORT>
+            static void read_message(bags_type&, const unsigned char*, std::false_type) {
+                throw std::domain_error("The trace has messages for a port whose messages are not trivially copyable");
+            }
+
+            template<typename PORT>
+            static void read_message(bags_type& bags, const unsigned char* from) {
+                read_message<PORT>(bags, from, std::is_trivially_copyable<typename PORT::message_type>{});
+            }
+
+            template<std::size_t... Is>
+            static const message_reader* readers(std::index_sequence<Is...>) {
+                static const message_reader table[]={nullptr, &read_message<typename std::tuple_element<Is, INPUT_PORTS>::type>...};
+                return table + 1;
+            }
+
+            template<std::size_t... Is>
+            static const std::size_t* message_sizes(std::index_sequence<Is...>) {
+                static const std::size_t table[]={0, sizeof(typename std::tuple_element<Is, INPUT_PORTS>::type::message_type)...};
+                return table + 1;
+            }
+
+            const unsigned char* _begin=nullptr;
+            std::size_t _size=0;
+            const unsigned char* _pos=nullptr; //next record
+            TIME _next_time{};
+
+            void read_next_time() {
+                if (_pos == _begin + _size) {
+                    return;
+                }
+                if (static_cast<std::size_t>(_begin + _size - _pos) < sizeof(TIME) + sizeof(std::uint32_t)) {
+                    throw std::domain_error("The trace ends in the middle of a record");
+                }
+                TIME t;
+                std::memcpy(&t, _pos, sizeof(TIME));
+                if (t < _next_time) {
+                    throw std::domain_error("The records of the trace are not ordered by time");
+                }
+                _next_time = t;
+            }
+
+        public:
+            /**
+             * @brief trace_reader maps the trace in path
+             * @throw std::system_error if the file can not be mapped, std::domain_error if it is not a trace for
+             * a model with INPUT_PORTS
+             */
+            explicit trace_reader(const std::string& path) {
+                int fd = ::open(path.c_str(), O_RDONLY);
+                if (fd < 0) {
+                    throw std::system_error(errno, std::generic_category(), "Failed to open the trace " + path);
+                }
+                struct stat st;
+                if (fstat(fd, &st) != 0) {
+                    int e = errno;
+                    ::close(fd);
+                    throw std::system_error(e, std::generic_category(), "Failed to open the trace " + path);
+                }
+                _size = static_cast<std::size_t>(st.st_size);
+                if (_size < header_size) {
+                    ::close(fd);
+                    throw std::domain_error("The file " + path + " is not a trace");
+                }
+                void* mapped = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+                int e = errno;
+                ::close(fd); //the mapping keeps the file
+                if (mapped == MAP_FAILED) {
+                    throw std::system_error(e, std::generic_category(), "Failed to map the trace " + path);
+                }
+                madvise(mapped, _size, MADV_SEQUENTIAL);
+                _begin = static_cast<const unsigned char*>(mapped);
+
+                std::uint32_t header[2];
+                std::memcpy(header, _begin + sizeof(event_trace_magic), sizeof(header));
+                if (std::memcmp(_begin, event_trace_magic, sizeof(event_trace_magic)) != 0
+                    || header[0] != sizeof(TIME) || header[1] != port_count) {
+                    munmap(const_cast<unsigned char*>(_begin), _size);
+                    throw std::domain_error("The file " + path + " is not a trace for this model");
+                }
+                rewind();
+            }
+
+            ~trace_reader() {
+                munmap(const_cast<unsigned char*>(_begin), _size);
+            }
+
+            trace_reader(const trace_reader&) = delete;
+            trace_reader& operator=(const trace_reader&) = delete;
+
+            /**
+             * @brief rewind goes back to the first record
+             */
+            void rewind() {
+                _pos = _begin + header_size;
+                if (_pos != _begin + _size) {
+                    std::memcpy(&_next_time, _pos, sizeof(TIME));
+                }
+                read_next_time();
+            }
+
+            /**
+             * @brief done tells if all the records were read
+             */
+            bool done() const noexcept {
+                return _pos == _begin + _size;
+            }
+
+            /**
+             * @brief next_time is the time of the next record, when not done
+             */
+            const TIME& next_time() const noexcept {
+                return _next_time;
+            }
+
+            /**
+             * @brief read_step adds the messages of all the records at next_time to the bags
+             * @throw std::domain_error if the trace is malformed
+             */
+            void read_step(bags_type& bags) {
+                const TIME t = _next_time;
+                while (!done() && !(t < _next_time)) {
+                    std::uint32_t port;
+                    std::memcpy(&port, _pos + sizeof(TIME), sizeof(port));
+                    if (port >= port_count) {
+                        throw std::domain_error("The trace has a record for a port the model does not have");
+                    }
+                    const unsigned char* message = _pos + sizeof(TIME) + sizeof(port);
+                    std::size_t size = message_sizes(std::make_index_sequence<port_count>{})[port];
+                    if (static_cast<std::size_t>(_begin + _size - message) < size) {
+                        throw std::domain_error("The trace ends in the middle of a record");
+                    }
+                    readers(std::make_index_sequence<port_count>{})[port](bags, message);
+                    _pos = message + size;
+                    read_next_time();
+                }
+            }
+        };
+    }
+}
+
+#endif // CADMIUM_EVENT_TRACE_HPP
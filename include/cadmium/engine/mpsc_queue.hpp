@@ -0,0 +1,105 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CADMIUM_MPSC_QUEUE_HPP
+#define CADMIUM_MPSC_QUEUE_HPP
+
+#include <atomic>
+#include <utility>
+
+namespace cadmium {
+    namespace engine {
+        /**
+         * @brief mpsc_queue is an unbounded lock free queue with many producers and a single consumer
+         *
+         * Nodes are linked from the oldest to the newest, producers swap themselves in as the newest with a single
+         * exchange and link the previous newest to them, so pushing never waits for other threads. The consumer
+         * owns the oldest node, which is a placeholder whose value was already taken, and pops by moving to the
+         * next one. A push is seen by the consumer once linked, a pop may miss a push that is half way done.
+         * Values need to be default constructible for the first placeholder.
+         */
+        template<typename T>
+        class mpsc_queue {
+            struct node {
+                std::atomic<node*> next{nullptr};
+                T value;
+
+                node() = default;
+                explicit node(T&& v) : value(std::move(v)) {}
+            };
+
+            std::atomic<node*> _newest;
+            node* _oldest; //only used by the consumer
+
+        public:
+            mpsc_queue() : _newest(new node()), _oldest(_newest.load()) {}
+
+            mpsc_queue(const mpsc_queue&) = delete;
+            mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+            ~mpsc_queue() {
+                while (_oldest) {
+                    node* next = _oldest->next.load(std::memory_order_relaxed);
+                    delete _oldest;
+                    _oldest = next;
+                }
+            }
+
+            /**
+             * @brief push adds a value at the end of the queue, it can be called from any thread
+             */
+            void push(T value) {
+                node* n = new node(std::move(value));
+                node* previous = _newest.exchange(n, std::memory_order_acq_rel);
+                previous->next.store(n, std::memory_order_release);
+            }
+
+            /**
+             * @brief pop takes the value at the front of the queue, only the consumer thread can call it
+             * @return false if there was no value to take
+             */
+            bool pop(T& value) {
+                node* next = _oldest->next.load(std::memory_order_acquire);
+                if (!next) {
+                    return false;
+                }
+                value = std::move(next->value);
+                delete _oldest;
+                _oldest = next;
+                return true;
+            }
+
+            /**
+             * @brief empty tells if the consumer has nothing to pop
+             */
+            bool empty() const noexcept {
+                return _oldest->next.load(std::memory_order_acquire) == nullptr;
+            }
+        };
+    }
+}
+
+#endif // CADMIUM_MPSC_QUEUE_HPP
@@ -0,0 +1,426 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CADMIUM_PDEVS_CONSERVATIVE_RUNNER_HPP
+#define CADMIUM_PDEVS_CONSERVATIVE_RUNNER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <cadmium/engine/pdevs_coordinator.hpp>
+#include <cadmium/engine/pdevs_engine_helpers.hpp>
+#include <cadmium/engine/pdevs_flattening.hpp>
+#include <cadmium/engine/pdevs_parallel_coordinator.hpp>
+#include <cadmium/modeling/lookahead.hpp>
+#include <cadmium/modeling/message_bag.hpp>
+#include <cadmium/logger/logger.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+namespace cadmium {
+    namespace engine {
+        /**
+         * @brief cmb_bound is a lower bound of the timestamps of the messages a partition can send in the future,
+         * all of them are after time if after is set, otherwise they are at time or after it.
+         */
+        template<typename TIME>
+        struct cmb_bound {
+            TIME time;
+            bool after;
+
+            bool operator<(const cmb_bound& other) const {
+                return time < other.time || (time == other.time && !after && other.after);
+            }
+        };
+
+        template<typename TIME>
+        cmb_bound<TIME> earliest(const cmb_bound<TIME>& a, const cmb_bound<TIME>& b) {
+            return b < a ? b : a;
+        }
+
+        /**
+         * @brief cmb_mailbox keeps the messages received by a partition and the bounds promised by the partitions
+         * sending messages to it.
+         */
+        template<typename TIME, typename BAGS>
+        struct cmb_mailbox {
+            std::mutex mutex;
+            std::condition_variable changed;
+            unsigned long version=0; //incremented on every change
+            std::vector<std::pair<TIME, BAGS>> messages;
+            std::vector<cmb_bound<TIME>> promises; //indexed by sender partition
+        };
+
+        /**
+         * @brief The conservative_runner class runs the submodels of the top coupled model in parallel,
+         * following the Chandy-Misra-Bryant conservative synchronization.
+         *
+         * Every submodel of the top model is a partition run in its own thread by a simulator or a coordinator.
+         * Partitions advance independently, exchanging timestamped messages by the ICs of the top model.
+         * When a partition can not advance it sends null messages promising the lowest timestamp of its future
+         * messages to the partitions coupled to its outputs.
+         *
+         * The promises are computed from the next internal event and from the lookahead of the partition, see
+         * lookahead.hpp, so declaring a positive lookahead lets partitions advance further ahead of each other.
+         * Partitions with zero lookahead are fine unless they are coupled in a cycle of partitions which have all
+         * zero lookahead, such a model is rejected when the runner is constructed.
+         *
+         * The states and messages of each model are the ones of the runner, messages arriving to the same port from
+         * different partitions may be in different order in the bag. The output ports of the top model are not
+         * collected, as in the runner. The logger is called from all the threads and must be parallel safe.
+         */
+        template <class TIME, template<class> class MODEL, typename LOGGER=cadmium::logger::not_logger, template<typename> class FEL=heap_fel>
+        class conservative_runner {
+            static_assert(parallel_safe_logger<LOGGER>::value, "The logger is called from the threads of all partitions, it needs to be parallel safe");
+
+            template<typename P>
+            using submodels_type=typename MODEL<TIME>::template models<P>;
+            using partitions_type=typename coordinate_tuple<TIME, submodels_type, LOGGER, FEL>::type;
+            using ics=typename MODEL<TIME>::internal_couplings;
+            static constexpr std::size_t partitions_count=std::tuple_size<partitions_type>::value;
+
+            template<std::size_t I>
+            using partition_model=typename std::tuple_element<I, partitions_type>::type::model_type;
+            template<std::size_t I>
+            using partition_bags=typename make_message_bags<typename partition_model<I>::input_ports>::type;
+
+            template<typename IS>
+            struct mailboxes_of;
+
+            template<std::size_t... Is>
+            struct mailboxes_of<std::index_sequence<Is...>> {
+                using type=std::tuple<cmb_mailbox<TIME, partition_bags<Is>>...>;
+            };
+            using mailboxes_type=typename mailboxes_of<std::make_index_sequence<partitions_count>>::type;
+
+            partitions_type _partitions;
+            mailboxes_type _mailboxes;
+            std::vector<std::vector<bool>> _connected; //_connected[i][j] if partition i sends messages to partition j
+            std::vector<TIME> _lookaheads;
+            std::unique_ptr<bool[]> _sent; //outputs of the next internal event of the partition were sent, a byte per partition thread
+            std::vector<cmb_bound<TIME>> _published; //last promise sent by each partition
+            std::atomic<bool> _failed{false};
+            std::exception_ptr _error;
+            std::mutex _error_mutex;
+
+            static constexpr TIME infinity() {
+                return std::numeric_limits<TIME>::infinity();
+            }
+
+            template<typename IC>
+            using ic_from=get_engine_index_by_model<typename IC::template from_model<TIME>, partitions_type>;
+            template<typename IC>
+            using ic_to=get_engine_index_by_model<typename IC::template to_model<TIME>, partitions_type>;
+
+            //sends the messages following an IC, only for the ICs leaving the partition sending
+            template<bool LEAVING, typename DUMMY=void>
+            struct ic_sender {
+                template<typename IC, typename OUT_BAGS>
+                static void send(conservative_runner&, const TIME&, const OUT_BAGS&) {}
+            };
+
+            template<typename DUMMY>
+            struct ic_sender<true, DUMMY> {
+                template<typename IC, typename OUT_BAGS>
+                static void send(conservative_runner& r, const TIME& t, const OUT_BAGS& outbox) {
+                    constexpr std::size_t to=ic_to<IC>::value;
+                    const auto& from_messages=get_messages<typename IC::from_model_output_port>(outbox);
+                    if (from_messages.empty()) {
+                        return;
+                    }
+                    partition_bags<to> bags;
+                    auto& to_messages=get_messages<typename IC::to_model_input_port>(bags);
+                    to_messages.insert(to_messages.end(), from_messages.begin(), from_messages.end());
+                    auto& mailbox=std::get<to>(r._mailboxes);
+                    {
+                        std::lock_guard<std::mutex> lock(mailbox.mutex);
+                        mailbox.messages.emplace_back(t, std::move(bags));
+                        ++mailbox.version;
+                    }
+                    mailbox.changed.notify_one();
+                }
+            };
+
+            template<std::size_t I>
+            void send_outputs(const TIME& t) {
+                const auto& outbox=std::get<I>(_partitions).outbox();
+                flat_for_each<ics>::apply([this, &t, &outbox](auto ic_tag) {
+                    using ic=typename decltype(ic_tag)::type;
+                    ic_sender<ic_from<ic>::value == I>::template send<ic>(*this, t, outbox);
+                });
+            }
+
+            //moves the messages received for time t into the inbox of partition I
+            template<std::size_t I>
+            static void merge_messages(partition_bags<I>& from, partition_bags<I>& to) {
+                flat_for_each<typename partition_model<I>::input_ports>::apply([&from, &to](auto port_tag) {
+                    using port=typename decltype(port_tag)::type;
+                    deliver_messages<true>::deliver(get_messages<port>(from), get_messages<port>(to));
+                });
+            }
+
+            template<std::size_t J>
+            void publish_to(std::size_t from, const cmb_bound<TIME>& promise) {
+                auto& mailbox=std::get<J>(_mailboxes);
+                {
+                    std::lock_guard<std::mutex> lock(mailbox.mutex);
+                    if (!(mailbox.promises[from] < promise)) {
+                        return;
+                    }
+                    mailbox.promises[from] = promise;
+                    ++mailbox.version;
+                }
+                mailbox.changed.notify_one();
+            }
+
+            template<std::size_t... Js>
+            void publish(std::size_t from, const cmb_bound<TIME>& promise, std::index_sequence<Js...>) {
+                if (!(_published[from] < promise)) {
+                    return;
+                }
+                _published[from] = promise;
+                int expand[] = {0, ((_connected[from][Js] && Js != from ? publish_to<Js>(from, promise) : void()), 0)...};
+                (void)expand;
+            }
+
+            template<std::size_t... Js>
+            void wake_all(std::index_sequence<Js...>) {
+                int expand[] = {0, (std::get<Js>(_mailboxes).changed.notify_all(), 0)...};
+                (void)expand;
+            }
+
+            void fail(std::exception_ptr e) {
+                {
+                    std::lock_guard<std::mutex> lock(_error_mutex);
+                    if (!_error) {
+                        _error = e;
+                    }
+                }
+                _failed = true;
+                //waking the partitions waiting, they find the failure under their own lock
+                auto all=std::make_index_sequence<partitions_count>{};
+                lock_and_wake_all(all);
+            }
+
+            template<std::size_t... Js>
+            void lock_and_wake_all(std::index_sequence<Js...>) {
+                int expand[] = {0, (std::lock_guard<std::mutex>(std::get<Js>(_mailboxes).mutex), 0)...};
+                (void)expand;
+                wake_all(std::index_sequence<Js...>{});
+            }
+
+            //runs partition I until all the events before t are processed
+            template<std::size_t I>
+            void run_partition(const TIME& t) {
+                try {
+                    run_partition_impl<I>(t);
+                } catch (...) {
+                    fail(std::current_exception());
+                }
+            }
+
+            template<std::size_t I>
+            void run_partition_impl(const TIME& end) {
+                auto& engine=std::get<I>(_partitions);
+                auto& mailbox=std::get<I>(_mailboxes);
+                const TIME lookahead=_lookaheads[I];
+                const bool self_coupled=_connected[I][I];
+                std::unique_lock<std::mutex> lock(mailbox.mutex);
+                while (!_failed) {
+                    const TIME next=engine.next();
+                    //lowest timestamp of the messages to be received from other partitions
+                    cmb_bound<TIME> promised{infinity(), false};
+                    for (std::size_t j = 0; j < partitions_count; ++j) {
+                        if (_connected[j][I] && j != I) {
+                            promised = earliest(promised, mailbox.promises[j]);
+                        }
+                    }
+                    TIME earliest_message=infinity();
+                    for (const auto& m : mailbox.messages) {
+                        earliest_message = std::min(earliest_message, m.first);
+                    }
+                    //lowest timestamp of the messages this partition can send in the future
+                    cmb_bound<TIME> inputs=earliest(promised, cmb_bound<TIME>{earliest_message, false});
+                    cmb_bound<TIME> own{next, _sent[I] && lookahead > TIME{}};
+                    cmb_bound<TIME> caused=(lookahead > TIME{} ? cmb_bound<TIME>{inputs.time + lookahead, false} : inputs);
+                    cmb_bound<TIME> promise=earliest(own, caused);
+                    //no message before safe can arrive
+                    cmb_bound<TIME> safe=(self_coupled ? earliest(promised, promise) : promised);
+                    TIME step=std::min(next, earliest_message);
+
+                    if (!_sent[I] && next < end && !(safe.time < next) && !(earliest_message < next)) {
+                        //no message before next can arrive, outputs do not depend on the messages at next
+                        lock.unlock();
+                        publish(I, promise, std::make_index_sequence<partitions_count>{});
+                        engine.collect_outputs(next);
+                        send_outputs<I>(next);
+                        lock.lock();
+                        _sent[I] = true;
+                    } else if (step < end && cmb_bound<TIME>{step, false} < safe) {
+                        //all the messages for step arrived
+                        partition_bags<I> inbox;
+                        bool received=false;
+                        for (auto it = mailbox.messages.begin(); it != mailbox.messages.end();) {
+                            if (it->first == step) {
+                                merge_messages<I>(it->second, inbox);
+                                received = true;
+                                it = mailbox.messages.erase(it);
+                            } else {
+                                ++it;
+                            }
+                        }
+                        lock.unlock();
+                        publish(I, promise, std::make_index_sequence<partitions_count>{});
+                        if (received) {
+                            engine.inbox(std::move(inbox));
+                        }
+                        engine.advance_simulation(step);
+                        lock.lock();
+                        _sent[I] = false;
+                    } else {
+                        unsigned long seen=mailbox.version;
+                        lock.unlock();
+                        publish(I, promise, std::make_index_sequence<partitions_count>{});
+                        if (!(step < end) && !(safe.time < end)) {
+                            return;
+                        }
+                        lock.lock();
+                        mailbox.changed.wait(lock, [this, &mailbox, seen]() { return mailbox.version != seen || _failed; });
+                    }
+                }
+            }
+
+            template<std::size_t... Is>
+            void run_partitions(const TIME& t, std::index_sequence<Is...>) {
+                std::vector<std::thread> threads;
+                int expand[] = {0, (threads.emplace_back(&conservative_runner::run_partition<Is>, this, t), 0)...};
+                (void)expand;
+                for (auto& th : threads) {
+                    th.join();
+                }
+            }
+
+            template<std::size_t... Is>
+            TIME next(std::index_sequence<Is...>) {
+                TIME ret=infinity();
+                for (TIME n : std::initializer_list<TIME>{std::get<Is>(_partitions).next()...}) {
+                    ret = std::min(ret, n);
+                }
+                auto earliest_in=[](const auto& mailbox) {
+                    TIME ret=std::numeric_limits<TIME>::infinity();
+                    for (const auto& m : mailbox.messages) {
+                        ret = std::min(ret, m.first);
+                    }
+                    return ret;
+                };
+                for (TIME n : std::initializer_list<TIME>{earliest_in(std::get<Is>(_mailboxes))...}) {
+                    ret = std::min(ret, n);
+                }
+                return ret;
+            }
+
+            template<std::size_t... Is>
+            void init_partitions(const TIME& init_time, std::index_sequence<Is...>) {
+                _lookaheads = {cadmium::modeling::model_lookahead<TIME, partition_model<Is>>::value()...};
+                int expand[] = {0, (std::get<Is>(_partitions).init(init_time), 0)...};
+                (void)expand;
+                int expand_mailboxes[] = {0, (std::get<Is>(_mailboxes).promises.assign(partitions_count, cmb_bound<TIME>{init_time, false}), 0)...};
+                (void)expand_mailboxes;
+            }
+
+            //rejects cycles of partitions without lookahead, they would wait for each other forever
+            void check_cycles() const {
+                std::vector<std::vector<bool>> reach(partitions_count, std::vector<bool>(partitions_count, false));
+                for (std::size_t i = 0; i < partitions_count; ++i) {
+                    for (std::size_t j = 0; j < partitions_count; ++j) {
+                        reach[i][j] = _connected[i][j] && !(_lookaheads[i] > TIME{}) && !(_lookaheads[j] > TIME{});
+                    }
+                }
+                for (std::size_t k = 0; k < partitions_count; ++k) {
+                    for (std::size_t i = 0; i < partitions_count; ++i) {
+                        for (std::size_t j = 0; j < partitions_count; ++j) {
+                            reach[i][j] = reach[i][j] || (reach[i][k] && reach[k][j]);
+                        }
+                    }
+                }
+                for (std::size_t i = 0; i < partitions_count; ++i) {
+                    if (reach[i][i]) {
+                        throw std::domain_error("Partitions coupled in a cycle need a positive lookahead in at least one of them");
+                    }
+                }
+            }
+
+        public:
+            /**
+             * @brief set the dynamic parameters for the simulation
+             * @param init_time is the initial time of the simulation.
+             */
+            explicit conservative_runner(const TIME& init_time) {
+                LOGGER::template log<cadmium::logger::logger_global_time, TIME>(init_time);
+                LOGGER::template log<cadmium::logger::logger_info, std::string>("Preparing model");
+                _connected.assign(partitions_count, std::vector<bool>(partitions_count, false));
+                flat_for_each<ics>::apply([this](auto ic_tag) {
+                    using ic=typename decltype(ic_tag)::type;
+                    _connected[ic_from<ic>::value][ic_to<ic>::value] = true;
+                });
+                init_partitions(init_time, std::make_index_sequence<partitions_count>{});
+                _sent.reset(new bool[partitions_count]());
+                _published.assign(partitions_count, cmb_bound<TIME>{init_time, false});
+                check_cycles();
+            }
+
+            conservative_runner(const conservative_runner&) = delete;
+            conservative_runner& operator=(const conservative_runner&) = delete;
+
+            /**
+             * @brief runUntil runs every partition in its own thread until all the events before t are processed.
+             * @param t is the limit time for the simulation.
+             * @return the TIME of the next event to happen when simulation stopped.
+             */
+            TIME runUntil(const TIME& t) {
+                LOGGER::template log<cadmium::logger::logger_info, std::string>("Starting run");
+                run_partitions(t, std::make_index_sequence<partitions_count>{});
+                if (_failed) {
+                    std::rethrow_exception(_error);
+                }
+                LOGGER::template log<cadmium::logger::logger_info, std::string>("Finished run");
+                return next(std::make_index_sequence<partitions_count>{});
+            }
+        };
+    }
+}
+
+#endif // CADMIUM_PDEVS_CONSERVATIVE_RUNNER_HPP
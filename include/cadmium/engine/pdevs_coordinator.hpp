@@ -28,6 +28,8 @@
 #ifndef CADMIUM_PDEVS_COORDINATOR_H
 #define CADMIUM_PDEVS_COORDINATOR_H
 #include <limits>
+#include <utility>
+#include <vector>
 #include <boost/type_index.hpp>
 
 #include <cadmium/engine/pdevs_engine_helpers.hpp>
@@ -41,6 +43,29 @@
 
 namespace cadmium {
     namespace engine {
+        /**
+         * @brief sequential_dispatch runs the subengines involved in a step one after the other in the calling thread
+         *
+         * A dispatch decides how a basic_coordinator runs the collect_outputs and advance_simulation calls of its
+         * subengines, it provides:
+         *   initializing(f)    runs f, initializing or loading the subengines, with the dispatch resources installed.
+         *   for_each<ARENA>(es, f)  calls f(e) for every engine index e in es, returning when all the calls finished.
+         *                           ARENA tells if some of the engines have boxes taking memory from the step arena.
+         */
+        struct sequential_dispatch {
+            template<typename F>
+            void initializing(F&& f) {
+                f();
+            }
+
+            template<bool ARENA, typename F>
+            void for_each(const std::vector<std::size_t>& engines, F&& f) {
+                for (auto e : engines) {
+                    f(e);
+                }
+            }
+        };
+
         /**
          * @brief The Coordinator class runs a PDEVS coupled model
          * The Coordinators are used to run the coupled models.
@@ -49,21 +74,27 @@ namespace cadmium {
          * model and then it coordinates the advance of all these coordinators and
          * simulators to provide its own outputs.
          * This kind of coordinator advances time by small certain steps.
-         * There is never a rollback.
+         * There is never a rollback, rollbacks are left to time_warp_runner, which runs partitions optimistically.
          * Each call to advanceSimulation advances internally a step and outputs are collected in separate method.
+         *
+         * The FEL keeps the next time of each subengine, only the imminent subengines are asked for output,
+         * and only those and the ones receiving messages are advanced in each step.
+         * The FEL is received as template parameter, heap_fel and linear_fel are provided in pdevs_fel.hpp.
+         * The DISPATCH runs the subengines involved in each phase, coordinator is the basic_coordinator using
+         * sequential_dispatch and parallel_coordinator the one using parallel_dispatch. Coupled submodels are run
+         * by coordinators with the same dispatch.
          */
-
-
-            //TODO: migrate specialization FEL behavior from CDBoost. At this point, there is no parametrized FEL.
-
-        template<template<typename T> class MODEL, typename TIME, typename LOGGER>
-        class coordinator {
+        template<template<typename T> class MODEL, typename TIME, typename LOGGER, template<typename> class FEL, typename DISPATCH>
+        class basic_coordinator {
             //types for subcoordination
             template<typename P>
             using submodels_type=typename MODEL<TIME>::template models<P>;
             using in_bags_type=typename make_message_bags<typename MODEL<TIME>::input_ports>::type;
             using out_bags_type=typename make_message_bags<typename MODEL<TIME>::output_ports>::type;
-            using subcoordinators_type=typename coordinate_tuple<TIME, submodels_type, LOGGER>::type;
+            template<template<typename> class M, typename T, typename L, template<typename> class F>
+            using same_engine=basic_coordinator<M, T, L, F, DISPATCH>;
+            using subcoordinators_type=typename coordinate_tuple<TIME, submodels_type, LOGGER, FEL, same_engine>::type;
+            using subengines=subengines_dispatch<TIME, subcoordinators_type>;
             using eic=typename MODEL<TIME>::external_input_couplings;
             using eoc=typename MODEL<TIME>::external_output_couplings;
             using ic=typename MODEL<TIME>::internal_couplings;
@@ -72,20 +103,46 @@ namespace cadmium {
             TIME _last; //last transition time
             TIME _next; // next transition scheduled
             subcoordinators_type _subcoordinators;
+            FEL<TIME> _fel; //next time of every subengine
+            active_set _active; //subengines involved in current step
+            std::vector<std::size_t> _imminent; //subengines scheduled for current step
+            bool _collected=false; //the imminent subengines at _next were found by collect_outputs
+            DISPATCH _dispatch;
+
+            void find_imminent(const TIME& t) {
+                _imminent.clear();
+                _fel.imminent(t, _imminent);
+                for (auto e : _imminent) {
+                    _active.mark(e);
+                }
+            }
 
         public://making boxes temporarily public
             //TODO: set boxes back to private
             in_bags_type _inbox;
             out_bags_type _outbox;
+            port_mask<in_bags_type> _inbox_dirty; //non empty ports in the inbox, set by whoever fills the inbox
+            port_mask<out_bags_type> _outbox_dirty; //non empty ports in the outbox
 
 
         public:
             using model_type=MODEL<TIME>;
+            //the boxes of the coordinator or of some engine in the subtree take memory from the step arena when installed
+            static constexpr bool uses_step_arena=bags_use_step_arena<in_bags_type>::value || bags_use_step_arena<out_bags_type>::value
+                                                  || engines_use_step_arena<subcoordinators_type>::value;
+
+            basic_coordinator() = default;
+
+            /**
+             * @brief constructs a coordinator running its subengines with the given dispatch
+             */
+            explicit basic_coordinator(DISPATCH dispatch) : _dispatch(std::move(dispatch)) {}
+
             /**
              * @brief init function sets the start time
              * @param t is the start time
              */
-            void init(TIME t) noexcept {
+            void init(TIME t) {
                 auto log_info_init = [](TIME t) -> std::string {
                      std::ostringstream oss;
                      oss << "Coordinator for model ";
@@ -98,12 +155,43 @@ namespace cadmium {
 
                 _last = t;
                 //init all subcoordinators and find next transition time.
-                cadmium::engine::init_subcoordinators<TIME, subcoordinators_type>(t, _subcoordinators);
-                //find the one with the lowest next time
-                _next = cadmium::engine::min_next_in_tuple<subcoordinators_type>(_subcoordinators);
+                _dispatch.initializing([this, &t]() {
+                    cadmium::engine::init_subcoordinators<TIME, subcoordinators_type>(t, _subcoordinators);
+                });
+                //schedule all of them and find the one with the lowest next time
+                _fel.init(cadmium::engine::nexts_in_tuple<TIME, subcoordinators_type>(_subcoordinators));
+                _active.init(std::tuple_size<subcoordinators_type>::value);
+                _collected = false;
+                _next = _fel.next();
                 return ;
             }
 
+            /**
+             * @brief save writes the times, the messages waiting in the inbox and the state of the subtree
+             */
+            void save(cadmium::checkpoint_writer& w) const {
+                w.write(_last);
+                w.write(_next);
+                w.write(_inbox);
+                cadmium::engine::save_subcoordinators(w, _subcoordinators);
+            }
+
+            /**
+             * @brief load restores what save wrote, in place of init, the FEL is rebuilt from the subengines
+             */
+            void load(cadmium::checkpoint_reader& r) {
+                r.read(_last);
+                r.read(_next);
+                r.read(_inbox);
+                _inbox_dirty = cadmium::non_empty_ports(_inbox);
+                cadmium::reset_message_bags(_outbox);
+                _outbox_dirty.reset();
+                _dispatch.initializing([this, &r]() { cadmium::engine::load_subcoordinators(r, _subcoordinators); });
+                _fel.init(cadmium::engine::nexts_in_tuple<TIME, subcoordinators_type>(_subcoordinators));
+                _active.init(std::tuple_size<subcoordinators_type>::value);
+                _collected = false;
+            }
+
             /**
              * @brief Coordinator expected next internal transition time
              */
@@ -111,11 +199,42 @@ namespace cadmium {
                 return _next;
             }
 
+            /**
+             * @brief imminent tells if some submodel has an internal transition scheduled at t
+             */
+            bool imminent(const TIME& t) const noexcept {
+                return _next == t;
+            }
+
+            /**
+             * @brief has_pending_input tells if messages were introduced in the inbox for next advance_simulation
+             */
+            bool has_pending_input() const noexcept {
+                return _inbox_dirty.any();
+            }
+
+            /**
+             * @brief inbox introduces messages for next advance_simulation
+             */
+            void inbox(in_bags_type in) {
+                //messages are moved into the bags of the inbox, keeping the memory they retained in last reset
+                cadmium::reset_message_bags(_inbox);
+                cadmium::append_message_bags(_inbox, in);
+                _inbox_dirty = cadmium::non_empty_ports(_inbox);
+            }
+
+            /**
+             * @brief active tells if advancing the simulation to t involves any submodel, otherwise the whole
+             * subtree is skipped
+             */
+            bool active(const TIME& t) const noexcept {
+                return imminent(t) || has_pending_input();
+            }
+
             /**
              * @brief Collects outputs ready for output before advancing the simulation
              * @param t time the simulation will be advanced to
-             * @todo At this point all messages are copied while routed form onelevel to the next, need to find a good
-             * strategy to lower copying, maybe.
+             * Messages are moved from one level to the next, they are copied only when a port has multiple destinations.
              * @todo Merge the Collect output calls into the advance simulation as done with ICs and EICs routing
              */
 
@@ -139,32 +258,43 @@ namespace cadmium {
 
                 if (_next < t) {
                     throw std::domain_error("Trying to obtain output when not internal event is scheduled");
-                } else if (_next == t) {
+                } else if (imminent(t)) {
                     //log EOC
                     LOGGER::template log<cadmium::logger::logger_message_routing,
                                          decltype(log_routing_collect)>(log_routing_collect);
 
                     //reset inboxes before populating outboxes and routing messages for preventing inconsistencies
-                    _inbox = in_bags_type{};
-                    //fill all outboxes and clean the inboxes in the lower levels recursively
-                    cadmium::engine::collect_outputs_in_subcoordinators<TIME, subcoordinators_type>(t, _subcoordinators);
+                    cadmium::reset_message_bags(_inbox);
+                    _inbox_dirty.reset();
+                    //fill the outboxes of imminent subengines and clean the inboxes in the lower levels recursively
+                    //outboxes of the other subengines are empty since their last advance
+                    _active.clear();
+                    find_imminent(t);
+                    _collected = true;
+                    _dispatch.template for_each<engines_use_step_arena<subcoordinators_type>::value>(_active.engines(), [this, &t](std::size_t e) {
+                        subengines::collect_outputs(e, t, _subcoordinators);
+                    });
                     //use the EOC mapping to compose current level output
-                    _outbox = collect_messages_by_eoc<TIME, eoc, out_bags_type, subcoordinators_type, LOGGER>(_subcoordinators);
+                    cadmium::reset_message_bags(_outbox);
+                    _outbox_dirty.reset();
+                    collect_messages_by_eoc<TIME, eoc, ic, out_bags_type, subcoordinators_type, LOGGER>(_subcoordinators, _outbox, _outbox_dirty);
                 } else {
-                    _outbox = out_bags_type{};
+                    cadmium::reset_message_bags(_outbox);
+                    _outbox_dirty.reset();
                 }
             }
 
             /**
              * @brief outbox keeps the output generated by the last call to collect_outputs
              */
-            out_bags_type outbox() const noexcept{
+            const out_bags_type& outbox() const noexcept{
                 return _outbox;
             }
 
             /**
              * @brief advanceSimulation advances the execution to t, at t introduces the messages into the system (if any).
              * @param t is the time the transition is expected to be run.
+             * Only imminent subengines and subengines receiving messages are advanced.
              */
             void advance_simulation(const TIME &t) {
                 auto log_info_advance = [](const TIME& from, const TIME& to) -> std::string {
@@ -177,11 +307,11 @@ namespace cadmium {
                      oss << to;
                      return oss.str();
                 };
-                LOGGER::template log<cadmium::logger::logger_info, decltype(log_info_advance), TIME>(log_info_advance, _last, t);
-
                 if (_next < t || t < _last ) {
                     throw std::domain_error("Trying to obtain output when out of the advance time scope");
-                } else {
+                } else if (active(t)) { //otherwise, nothing happens in the subtree at t
+                    LOGGER::template log<cadmium::logger::logger_info, decltype(log_info_advance), TIME>(log_info_advance, _last, t);
+
 
                     //Loggers for routing
                     auto log_routing_ic_collect = []() -> std::string {
@@ -197,21 +327,41 @@ namespace cadmium {
                          return oss.str();
                     };
 
+                    //imminent subengines are advanced even if collect_outputs was not called for t
+                    if (!(_collected && imminent(t))) {
+                        _active.clear();
+                        if (imminent(t)) {
+                            find_imminent(t);
+                        }
+                    }
+                    _collected = false;
+
                     //Route the messages standing in the outboxes to mapped inboxes following ICs and EICs
                     LOGGER::template log<cadmium::logger::logger_message_routing,
                                          decltype(log_routing_ic_collect)>(log_routing_ic_collect);
 
-                    cadmium::engine::route_internal_coupled_messages_on_subcoordinators<TIME, subcoordinators_type, ic, LOGGER>(t, _subcoordinators);
+                    cadmium::engine::route_internal_coupled_messages_on_subcoordinators<TIME, subcoordinators_type, ic, eoc, LOGGER>(t, _subcoordinators, _active);
 
                     LOGGER::template log<cadmium::logger::logger_message_routing,
                                          decltype(log_routing_eic_collect)>(log_routing_eic_collect);
 
-                    cadmium::engine::route_external_input_coupled_messages_on_subcoordinators<TIME, in_bags_type, subcoordinators_type, eic, LOGGER>(t, _inbox, _subcoordinators);
-                    //recurse on advance_simulation
-                    cadmium::engine::advance_simulation_in_subengines<TIME, subcoordinators_type>(t, _subcoordinators);
+                    cadmium::engine::route_external_input_coupled_messages_on_subcoordinators<TIME, in_bags_type, subcoordinators_type, eic, LOGGER>(t, _inbox, _inbox_dirty, _subcoordinators, _active);
+                    //recurse on advance_simulation of the active subengines and reschedule them
+                    _dispatch.template for_each<engines_use_step_arena<subcoordinators_type>::value>(_active.engines(), [this, &t](std::size_t e) {
+                        subengines::advance_simulation(e, t, _subcoordinators);
+                    });
+                    //rescheduling is done after all of them finished, the FEL is not shared with the dispatch
+                    for (auto e : _active.engines()) {
+                        _fel.update(e, subengines::next(e, _subcoordinators));
+                    }
                     //set _last and _next
                     _last = t;
-                    _next = cadmium::engine::min_next_in_tuple<subcoordinators_type>(_subcoordinators);
+                    _next = _fel.next();
+                    //messages were delivered, the boxes are emptied for next step keeping their memory
+                    cadmium::reset_message_bags(_inbox);
+                    cadmium::reset_message_bags(_outbox);
+                    _inbox_dirty.reset();
+                    _outbox_dirty.reset();
                 }
             }
         };
@@ -30,20 +30,30 @@
 
 #include <type_traits>
 #include <tuple>
+#include <utility>
+#include <iterator>
+#include <vector>
+#include <stdexcept>
 #include <algorithm>
 #include <iostream>
 #include <numeric>
 #include <boost/type_index.hpp>
 #include <cadmium/concept/concept_helpers.hpp>
 #include <cadmium/modeling/message_bag.hpp>
+#include <cadmium/modeling/checkpoint.hpp>
 #include <cadmium/logger/common_loggers.hpp>
+#include <cadmium/engine/pdevs_fel.hpp>
 
 
 namespace cadmium {
     namespace engine {
         //forward declaration
-        template<template<typename T> class MODEL, typename TIME, typename LOGGER>
-        class coordinator;        //forward declaration
+        struct sequential_dispatch;
+        template<template<typename T> class MODEL, typename TIME, typename LOGGER, template<typename> class FEL, typename DISPATCH>
+        class basic_coordinator;
+        //coordinator runs the subengines of each step one after the other
+        template<template<typename T> class MODEL, typename TIME, typename LOGGER, template<typename> class FEL=heap_fel>
+        using coordinator=basic_coordinator<MODEL, TIME, LOGGER, FEL, sequential_dispatch>;
         template<template<typename T> class MODEL, typename TIME, typename LOGGER>
         class simulator;
 
@@ -85,64 +95,134 @@ namespace cadmium {
         };
 
 
-        template<typename T>
-        std::ostream& implode(std::ostream& os, const T& collection){
+        template<typename IT>
+        std::ostream& implode(std::ostream& os, IT first, IT last){
+             using value_type=typename std::iterator_traits<IT>::value_type;
              os << "{";
-             auto it = std::begin(collection);
-             if (it != std::end(collection)) {
-                value_or_name<typename T::value_type>::print(os, *it);
+             auto it = first;
+             if (it != last) {
+                value_or_name<value_type>::print(os, *it);
                 ++it;
              }
-             while (it != std::end(collection)){
+             while (it != last){
                 os << ", ";
-                value_or_name<typename T::value_type>::print(os, *it);
+                value_or_name<value_type>::print(os, *it);
                 ++it;
              }
              os << "}";
              return os;
         }
 
-        //finding the min next from a tuple of coordinators and simulators
-        template<typename T, std::size_t S>
-        struct min_next_in_tuple_impl {
-            static auto value(T& t) {
-                return std::min(std::get<S - 1>(t).next(), min_next_in_tuple_impl<T, S - 1>::value(t));
-            }
-        };
-
-        template<typename T>
-        struct min_next_in_tuple_impl<T, 1> {
-            static auto value(T& t) {
-                return std::get<0>(t).next();
-            }
-        };
-
         template<typename T>
-        auto min_next_in_tuple(T& t) {
-            return min_next_in_tuple_impl<T, std::tuple_size<T>::value>::value(t);
+        std::ostream& implode(std::ostream& os, const T& collection){
+             return implode(os, std::begin(collection), std::end(collection));
         }
 
         //We use COS to accumulate coordinators and simulators while iterating MT using the S index
-        template<typename TIME, template<typename> class MT, std::size_t S, typename LOGGER, typename... COS> //COS accumulates coords or sims
+        //COORDINATOR is the engine used for the coupled submodels
+        template<typename TIME, template<typename> class MT, std::size_t S, typename LOGGER, template<typename> class FEL,
+                 template<template<typename> class, typename, typename, template<typename> class> class COORDINATOR, typename... COS> //COS accumulates coords or sims
         struct coordinate_tuple_impl {
             template<typename T>
             using current=typename std::tuple_element<S - 1, MT<T>>::type;
-            using current_coordinated=typename std::conditional<cadmium::concept::is_atomic<current>::value(), simulator<current, TIME, LOGGER>, coordinator<current, TIME, LOGGER>>::type;
-            using type=typename coordinate_tuple_impl<TIME, MT, S - 1, LOGGER, current_coordinated, COS...>::type;
+            using current_coordinated=typename std::conditional<cadmium::concept::is_atomic<current>::value(), simulator<current, TIME, LOGGER>, COORDINATOR<current, TIME, LOGGER, FEL>>::type;
+            using type=typename coordinate_tuple_impl<TIME, MT, S - 1, LOGGER, FEL, COORDINATOR, current_coordinated, COS...>::type;
         };
 
         //When the S reaches 0, all coordinators and simulators are put into a tuple for return
-        template<typename TIME, template<typename> class MT, typename LOGGER, typename... COS>
-        struct coordinate_tuple_impl<TIME, MT, 0, LOGGER, COS...> {
+        template<typename TIME, template<typename> class MT, typename LOGGER, template<typename> class FEL,
+                 template<template<typename> class, typename, typename, template<typename> class> class COORDINATOR, typename... COS>
+        struct coordinate_tuple_impl<TIME, MT, 0, LOGGER, FEL, COORDINATOR, COS...> {
             using type=std::tuple<COS...>;
         };
 
-        template<typename TIME, template<typename> class MT, typename LOGGER>
+        template<typename TIME, template<typename> class MT, typename LOGGER, template<typename> class FEL=heap_fel,
+                 template<template<typename> class, typename, typename, template<typename> class> class COORDINATOR=coordinator>
         struct coordinate_tuple {
             //the size should not be affected by the type used for TIME, simplifying passing float
-            using type=typename coordinate_tuple_impl<TIME, MT, std::tuple_size<MT<float>>::value, LOGGER>::type;
+            using type=typename coordinate_tuple_impl<TIME, MT, std::tuple_size<MT<float>>::value, LOGGER, FEL, COORDINATOR>::type;
+        };
+
+        //tells if any engine in a tuple of coordinators and simulators has boxes taking memory from the step arena
+        template<typename CST>
+        struct engines_use_step_arena;
+
+        template<>
+        struct engines_use_step_arena<std::tuple<>> : std::false_type{};
+
+        template<typename E, typename... Es>
+        struct engines_use_step_arena<std::tuple<E, Es...>>
+        : std::integral_constant<bool, E::uses_step_arena || engines_use_step_arena<std::tuple<Es...>>::value>{};
+
+        //access by runtime index to the engines in a tuple of coordinators and simulators
+        template<typename TIME, typename CST, typename IS=std::make_index_sequence<std::tuple_size<CST>::value>>
+        struct subengines_dispatch;
+
+        template<typename TIME, typename CST, std::size_t... Is>
+        struct subengines_dispatch<TIME, CST, std::index_sequence<Is...>> {
+        private:
+            template<std::size_t I>
+            static TIME next_impl(const CST& cst) {
+                return std::get<I>(cst).next();
+            }
+
+            template<std::size_t I>
+            static void collect_outputs_impl(const TIME& t, CST& cst) {
+                std::get<I>(cst).collect_outputs(t);
+            }
+
+            template<std::size_t I>
+            static void advance_simulation_impl(const TIME& t, CST& cst) {
+                std::get<I>(cst).advance_simulation(t);
+            }
+
+        public:
+            static TIME next(std::size_t engine, const CST& cst) {
+                using next_ptr=TIME (*)(const CST&);
+                static constexpr next_ptr table[] = {&next_impl<Is>...};
+                return table[engine](cst);
+            }
+
+            static void collect_outputs(std::size_t engine, const TIME& t, CST& cst) {
+                using collect_ptr=void (*)(const TIME&, CST&);
+                static constexpr collect_ptr table[] = {&collect_outputs_impl<Is>...};
+                table[engine](t, cst);
+            }
+
+            static void advance_simulation(std::size_t engine, const TIME& t, CST& cst) {
+                using advance_ptr=void (*)(const TIME&, CST&);
+                static constexpr advance_ptr table[] = {&advance_simulation_impl<Is>...};
+                table[engine](t, cst);
+            }
+        };
+
+        //an empty coupled model has no engines to access
+        template<typename TIME, typename CST>
+        struct subengines_dispatch<TIME, CST, std::index_sequence<>> {
+            static TIME next(std::size_t engine, const CST& cst) {
+                throw std::out_of_range("There are no subengines to dispatch");
+            }
+
+            static void collect_outputs(std::size_t engine, const TIME& t, CST& cst) {
+                throw std::out_of_range("There are no subengines to dispatch");
+            }
+
+            static void advance_simulation(std::size_t engine, const TIME& t, CST& cst) {
+                throw std::out_of_range("There are no subengines to dispatch");
+            }
         };
 
+        //the next time of every engine in the tuple, in the tuple order
+        template<typename TIME, typename CST>
+        std::vector<TIME> nexts_in_tuple(const CST& cst) {
+            std::vector<TIME> nexts;
+            nexts.reserve(std::tuple_size<CST>::value);
+            for (std::size_t i = 0; i < std::tuple_size<CST>::value; i++) {
+                nexts.push_back(subengines_dispatch<TIME, CST>::next(i, cst));
+            }
+            return nexts;
+        }
+
         //init every subcooridnator in the coordination tuple
         template <typename TIME, typename  CST, std::size_t S>
         struct init_subcoordinators_impl{
@@ -166,23 +246,27 @@ namespace cadmium {
             init_subcoordinators_impl<TIME, CST, std::tuple_size<CST>::value>::value(t, cs);
         }
 
-        //populate the outbox of every subcoordinator recursively
-        template<typename TIME, typename CST, std::size_t S>
-        struct collect_outputs_in_subcoordinators_impl{
-            static void run(const TIME& t, CST& cs){
-                std::get<S-1>(cs).collect_outputs(t);
-                collect_outputs_in_subcoordinators_impl<TIME, CST, S-1>::run(t, cs);
-            }
-        };
+        //write or read the state of every subcoordinator in the coordination tuple, in tuple order
+        template<typename CST, std::size_t... Is>
+        void save_subcoordinators(cadmium::checkpoint_writer& w, const CST& cs, std::index_sequence<Is...>) {
+            int expand[] = {0, (std::get<Is>(cs).save(w), 0)...};
+            (void)expand;
+        }
 
-        template<typename TIME, typename CST>
-        struct collect_outputs_in_subcoordinators_impl<TIME, CST, 0>{
-            static void run(const TIME& t, CST& cs){}
-        };
+        template<typename CST>
+        void save_subcoordinators(cadmium::checkpoint_writer& w, const CST& cs) {
+            save_subcoordinators(w, cs, std::make_index_sequence<std::tuple_size<CST>::value>{});
+        }
 
-        template<typename TIME, typename CST>
-        void collect_outputs_in_subcoordinators(const TIME& t, CST& cs){
-            collect_outputs_in_subcoordinators_impl<TIME, CST, std::tuple_size<CST>::value>::run(t, cs);
+        template<typename CST, std::size_t... Is>
+        void load_subcoordinators(cadmium::checkpoint_reader& r, CST& cs, std::index_sequence<Is...>) {
+            int expand[] = {0, (std::get<Is>(cs).load(r), 0)...};
+            (void)expand;
+        }
+
+        template<typename CST>
+        void load_subcoordinators(cadmium::checkpoint_reader& r, CST& cs) {
+            load_subcoordinators(r, cs, std::make_index_sequence<std::tuple_size<CST>::value>{});
         }
 
         //get the engine  from a tuple of engines that is simulating the model provided
@@ -213,22 +297,133 @@ namespace cadmium {
             return std::get<typename get_engine_type_by_model<TIMED_MODEL, CST>::type>(cst);
         }
 
+        //get the position in a tuple of engines of the engine simulating the model provided
+        template<typename TIMED_MODEL, typename CST, size_t S>
+        struct get_engine_index_by_model_impl{
+            using current_model=typename std::tuple_element<S-1, CST>::type::model_type;
+            static constexpr std::size_t value=(std::is_same<current_model, TIMED_MODEL>::value ? S-1 : get_engine_index_by_model_impl<TIMED_MODEL, CST, S-1>::value);
+        };
+
+        template<typename TIMED_MODEL, typename CST>
+        struct get_engine_index_by_model_impl<TIMED_MODEL, CST, 0>{
+            static constexpr std::size_t value=0;
+        };
+
+        template<typename TIMED_MODEL, typename CST>
+        struct get_engine_index_by_model{
+            static constexpr std::size_t value=get_engine_index_by_model_impl<TIMED_MODEL, CST, std::tuple_size<CST>::value>::value;
+        };
+
+        //count the couplings taking messages from the port of a submodel, or from an input port of the coupled model
+        template<typename TIME, typename TIMED_MODEL, typename PORT, typename ICs, std::size_t S>
+        struct count_ic_from_port_impl{
+            using current_IC=typename std::tuple_element<S-1, ICs>::type;
+            static constexpr std::size_t value=(std::is_same<typename current_IC::template from_model<TIME>, TIMED_MODEL>::value
+                                                && std::is_same<typename current_IC::from_model_output_port, PORT>::value ? 1 : 0)
+                                               + count_ic_from_port_impl<TIME, TIMED_MODEL, PORT, ICs, S-1>::value;
+        };
+
+        template<typename TIME, typename TIMED_MODEL, typename PORT, typename ICs>
+        struct count_ic_from_port_impl<TIME, TIMED_MODEL, PORT, ICs, 0>{
+            static constexpr std::size_t value=0;
+        };
+
+        template<typename TIME, typename TIMED_MODEL, typename PORT, typename EOCs, std::size_t S>
+        struct count_eoc_from_port_impl{
+            using current_EOC=typename std::tuple_element<S-1, EOCs>::type;
+            static constexpr std::size_t value=(std::is_same<typename current_EOC::template submodel<TIME>, TIMED_MODEL>::value
+                                                && std::is_same<typename current_EOC::submodel_output_port, PORT>::value ? 1 : 0)
+                                               + count_eoc_from_port_impl<TIME, TIMED_MODEL, PORT, EOCs, S-1>::value;
+        };
+
+        template<typename TIME, typename TIMED_MODEL, typename PORT, typename EOCs>
+        struct count_eoc_from_port_impl<TIME, TIMED_MODEL, PORT, EOCs, 0>{
+            static constexpr std::size_t value=0;
+        };
+
+        template<typename PORT, typename EICs, std::size_t S>
+        struct count_eic_from_port_impl{
+            using current_EIC=typename std::tuple_element<S-1, EICs>::type;
+            static constexpr std::size_t value=(std::is_same<typename current_EIC::external_input_port, PORT>::value ? 1 : 0)
+                                               + count_eic_from_port_impl<PORT, EICs, S-1>::value;
+        };
+
+        template<typename PORT, typename EICs>
+        struct count_eic_from_port_impl<PORT, EICs, 0>{
+            static constexpr std::size_t value=0;
+        };
+
+        //messages leaving a submodel port can go through ICs and EOCs
+        template<typename TIME, typename TIMED_MODEL, typename PORT, typename ICs, typename EOCs>
+        struct count_destinations_from_port{
+            static constexpr std::size_t value=count_ic_from_port_impl<TIME, TIMED_MODEL, PORT, ICs, std::tuple_size<ICs>::value>::value
+                                               + count_eoc_from_port_impl<TIME, TIMED_MODEL, PORT, EOCs, std::tuple_size<EOCs>::value>::value;
+        };
+
+        //messages entering a coupled model input port can go only through EICs
+        template<typename PORT, typename EICs>
+        struct count_destinations_from_input_port{
+            static constexpr std::size_t value=count_eic_from_port_impl<PORT, EICs, std::tuple_size<EICs>::value>::value;
+        };
+
+        //append the messages from one bag to another, when the messages have a single destination they are moved
+        //instead of copied, and the source is left empty
+        template<bool SINGLE_DESTINATION>
+        struct deliver_messages;
+
+        template<>
+        struct deliver_messages<false>{
+            template<typename FROM, typename TO>
+            static void deliver(FROM& from, TO& to){
+                to.insert(to.end(), from.begin(), from.end());
+            }
+        };
+
+        template<>
+        struct deliver_messages<true>{
+            template<typename B>
+            static void deliver_impl(B& from, B& to, std::true_type){
+                if (to.empty()) {
+                    using std::swap;
+                    swap(from, to); //taking the buffer of the source bag
+                    return;
+                }
+                deliver_impl(from, to, std::false_type{});
+            }
+
+            template<typename FROM, typename TO>
+            static void deliver_impl(FROM& from, TO& to, std::false_type){
+                to.insert(to.end(), std::make_move_iterator(from.begin()), std::make_move_iterator(from.end()));
+                from.clear();
+            }
+
+            template<typename FROM, typename TO>
+            static void deliver(FROM& from, TO& to){
+                deliver_impl(from, to, typename std::is_same<FROM, TO>::type{});
+            }
+        };
+
         //map the messages in the outboxes of subengines to the messages in the outbox of current coordinator
-        template<typename TIME, typename EOC, std::size_t S, typename OUT_BAG, typename CST, typename LOGGER>
+        template<typename TIME, typename EOC, typename ICs, std::size_t S, typename OUT_BAG, typename CST, typename LOGGER>
         struct collect_messages_by_eoc_impl{
             using external_output_port=typename std::tuple_element<S-1, EOC>::type::external_output_port;
             using submodel_from = typename std::tuple_element<S-1, EOC>::type::template submodel<TIME>;
             using submodel_output_port=typename std::tuple_element<S-1, EOC>::type::submodel_output_port;
-            using submodel_out_messages_type=typename make_message_bags<typename std::tuple<submodel_output_port>>::type;
+            static constexpr bool single_destination=count_destinations_from_port<TIME, submodel_from, submodel_output_port, ICs, EOC>::value == 1;
 
-            static void fill(OUT_BAG& messages, CST& cst){
-                //process one coupling
-                auto from_bag = get_engine_by_model<submodel_from, CST>(cst).outbox();
-                auto& from_messages = get_messages<submodel_output_port>(from_bag);
+            static void fill(OUT_BAG& messages, port_mask<OUT_BAG>& dirty, CST& cst){
+                //process one coupling, skipping the bag if the port is clean
+                auto& from_engine = get_engine_by_model<submodel_from, CST>(cst);
+                using from_bags=typename std::decay<decltype(from_engine._outbox)>::type;
+                auto& from_messages = get_messages<submodel_output_port>(from_engine._outbox);
                 auto& to_messages = get_messages<external_output_port>(messages);
-                to_messages.insert(to_messages.end(), from_messages.begin(), from_messages.end());
-                //log
-                auto log_routing_collect = [](decltype(from_messages) from, decltype(to_messages) to) -> std::string {
+                std::size_t previous_size = to_messages.size();
+                if (from_engine._outbox_dirty.test(port_index<submodel_output_port, from_bags>::value) && !from_messages.empty()) {
+                    deliver_messages<single_destination>::deliver(from_messages, to_messages);
+                    dirty.set(port_index<external_output_port, OUT_BAG>::value);
+                }
+                //log, the messages routed are the ones appended to the destination
+                auto log_routing_collect = [](decltype(to_messages) to, std::size_t from) -> std::string {
                      std::ostringstream oss;
                      oss << " in port ";
                      oss << boost::typeindex::type_id<external_output_port>().pretty_name();
@@ -239,77 +434,63 @@ namespace cadmium {
                      oss << " of model ";
                      oss << boost::typeindex::type_id<submodel_from>().pretty_name();
                      oss << " with messages ";
-                     implode(oss, from);
+                     implode(oss, std::next(to.begin(), from), to.end());
                      return oss.str();
                 };
                 LOGGER::template log<cadmium::logger::logger_message_routing,
                                      decltype(log_routing_collect),
-                                     decltype(from_messages),
-                                     decltype(to_messages)>(log_routing_collect, from_messages, to_messages);
+                                     decltype(to_messages),
+                                     std::size_t>(log_routing_collect, to_messages, previous_size);
 
                 //iterate
-                collect_messages_by_eoc_impl<TIME, EOC, S-1, OUT_BAG, CST, LOGGER>::fill(messages, cst);
-            }
-        };
-
-        template<typename TIME, typename EOC, typename OUT_BAG, typename CST, typename LOGGER>
-        struct collect_messages_by_eoc_impl<TIME, EOC, 0, OUT_BAG, CST, LOGGER>{
-            static void fill(OUT_BAG& messages, CST& cst){} //nothing to do here
-        };
-
-        template<typename TIME, typename EOC, typename OUT_BAG, typename CST,typename LOGGER>
-        OUT_BAG collect_messages_by_eoc(CST& cst){
-            OUT_BAG ret;//if the subcoordinators active are not connected by EOC, no output is generated
-            collect_messages_by_eoc_impl<TIME, EOC, std::tuple_size<EOC>::value, OUT_BAG, CST, LOGGER>::fill(ret, cst);
-            return ret;
-        }
-
-        //advance the simulation in every subengine
-        template <typename TIME, typename CST, std::size_t S>
-        struct advance_simulation_in_subengines_impl{
-            static void run(const TIME& t, CST& cst){
-                std::get<S-1>(cst).advance_simulation(t);
-                advance_simulation_in_subengines_impl<TIME, CST, S-1>::run(t, cst);
+                collect_messages_by_eoc_impl<TIME, EOC, ICs, S-1, OUT_BAG, CST, LOGGER>::fill(messages, dirty, cst);
             }
         };
 
-        template <typename TIME, typename CST>
-        struct advance_simulation_in_subengines_impl<TIME, CST, 0>{
-            static void run(const TIME& t, CST& cst){
-                //nothing to do here
-            }
+        template<typename TIME, typename EOC, typename ICs, typename OUT_BAG, typename CST, typename LOGGER>
+        struct collect_messages_by_eoc_impl<TIME, EOC, ICs, 0, OUT_BAG, CST, LOGGER>{
+            static void fill(OUT_BAG& messages, port_mask<OUT_BAG>& dirty, CST& cst){} //nothing to do here
         };
 
-        template <typename TIME, typename CST>
-        void advance_simulation_in_subengines(const TIME& t, CST& subcoordinators){
-            advance_simulation_in_subengines_impl<TIME, CST, std::tuple_size<CST>::value>::run(t, subcoordinators);
-            return;
+        //the ICs are required for finding out which messages have no other destination and can be moved
+        //messages are appended to the bags received, if the subcoordinators active are not connected by EOC, no output is generated
+        //the ports receiving messages are set in dirty
+        template<typename TIME, typename EOC, typename ICs, typename OUT_BAG, typename CST,typename LOGGER>
+        void collect_messages_by_eoc(CST& cst, OUT_BAG& messages, port_mask<OUT_BAG>& dirty){
+            collect_messages_by_eoc_impl<TIME, EOC, ICs, std::tuple_size<EOC>::value, OUT_BAG, CST, LOGGER>::fill(messages, dirty, cst);
         }
 
-
-        //route messages following ICs
-        template<typename TIME, typename CST, typename ICs, std::size_t S, typename LOGGER>
+        //route messages following ICs, the engines receiving messages are marked in the active set
+        template<typename TIME, typename CST, typename ICs, typename EOCs, std::size_t S, typename LOGGER>
         struct route_internal_coupled_messages_on_subcoordinators_impl{
             using current_IC=typename std::tuple_element<S-1, ICs>::type;
             using from_model=typename current_IC::template from_model<TIME>;
             using from_port=typename current_IC::from_model_output_port;
             using to_model=typename current_IC::template to_model<TIME>;
             using to_port=typename current_IC::to_model_input_port;
+            static constexpr bool single_destination=count_destinations_from_port<TIME, from_model, from_port, ICs, EOCs>::value == 1;
 
             using from_model_type=typename get_engine_type_by_model<from_model, CST>::type;
             using to_model_type=typename get_engine_type_by_model<to_model, CST>::type;
-            static void route(const TIME& t, CST& engines){
+            static void route(const TIME& t, CST& engines, active_set& receivers){
                 //route messages for 1 coupling
                 from_model_type& from_engine = get_engine_by_model<from_model, CST>(engines);
                 to_model_type& to_engine=get_engine_by_model<to_model, CST>(engines);
 
                 //add the messages
+                using from_bags=typename std::decay<decltype(from_engine._outbox)>::type;
+                using to_bags=typename std::decay<decltype(to_engine._inbox)>::type;
                 auto& from_messages = cadmium::get_messages<from_port>(from_engine._outbox);
                 auto& to_messages = cadmium::get_messages<to_port>(to_engine._inbox);
-                to_messages.insert(to_messages.end(), from_messages.begin(), from_messages.end());
-
-                //log
-                auto log_routing_collect = [](decltype(from_messages) from, decltype(to_messages) to) -> std::string {
+                std::size_t previous_size = to_messages.size();
+                if (from_engine._outbox_dirty.test(port_index<from_port, from_bags>::value) && !from_messages.empty()) {
+                    deliver_messages<single_destination>::deliver(from_messages, to_messages);
+                    to_engine._inbox_dirty.set(port_index<to_port, to_bags>::value);
+                    receivers.mark(get_engine_index_by_model<to_model, CST>::value);
+                }
+
+                //log, the messages routed are the ones appended to the destination
+                auto log_routing_collect = [](decltype(to_messages) to, std::size_t from) -> std::string {
                      std::ostringstream oss;
                      oss << " in port ";
                      oss << boost::typeindex::type_id<to_port>().pretty_name();
@@ -322,47 +503,56 @@ namespace cadmium {
                      oss << " of model ";
                      oss << boost::typeindex::type_id<from_model>().pretty_name();
                      oss << " with messages ";
-                     implode(oss, from);
+                     implode(oss, std::next(to.begin(), from), to.end());
                      return oss.str();
                 };
                 LOGGER::template log<cadmium::logger::logger_message_routing,
                                      decltype(log_routing_collect),
-                                     decltype(from_messages),
-                                     decltype(to_messages)>(log_routing_collect, from_messages, to_messages);
+                                     decltype(to_messages),
+                                     std::size_t>(log_routing_collect, to_messages, previous_size);
 
                 //iterate
-                route_internal_coupled_messages_on_subcoordinators_impl<TIME, CST, ICs, S-1, LOGGER>::route(t, engines);
+                route_internal_coupled_messages_on_subcoordinators_impl<TIME, CST, ICs, EOCs, S-1, LOGGER>::route(t, engines, receivers);
             }
         };
 
-        template<typename TIME, typename CST, typename ICs, typename LOGGER>
-        struct route_internal_coupled_messages_on_subcoordinators_impl<TIME, CST, ICs, 0, LOGGER>{
-            static void route(const TIME& t, CST& subcoordinators){
+        template<typename TIME, typename CST, typename ICs, typename EOCs, typename LOGGER>
+        struct route_internal_coupled_messages_on_subcoordinators_impl<TIME, CST, ICs, EOCs, 0, LOGGER>{
+            static void route(const TIME& t, CST& subcoordinators, active_set& receivers){
             //nothing to do here
             }
         };
 
-        template <typename TIME, typename CST, typename ICs, typename LOGGER >
-        void route_internal_coupled_messages_on_subcoordinators(const TIME& t, CST& cst){
-            route_internal_coupled_messages_on_subcoordinators_impl<TIME, CST, ICs, std::tuple_size<ICs>::value, LOGGER>::route(t, cst);
+        //the EOCs are required for finding out which messages have no other destination and can be moved
+        template <typename TIME, typename CST, typename ICs, typename EOCs, typename LOGGER >
+        void route_internal_coupled_messages_on_subcoordinators(const TIME& t, CST& cst, active_set& receivers){
+            route_internal_coupled_messages_on_subcoordinators_impl<TIME, CST, ICs, EOCs, std::tuple_size<ICs>::value, LOGGER>::route(t, cst, receivers);
             return;
         };
 
+        //route messages following EICs, the engines receiving messages are marked in the active set
         template<typename TIME, typename INBAGS, typename CST, typename EICs, size_t S, typename LOGGER>
         struct route_external_input_coupled_messages_on_subcoordinators_impl{
             using current_EIC=typename std::tuple_element<S-1, EICs>::type;
-            using from_port=typename current_EIC::from_port;
-            using to_model=typename current_EIC::template to_model<TIME>;
-            using to_port=typename current_EIC::to_model_input_port;
-
-            static void route(TIME t, const INBAGS& inbox, CST& engines){
-                auto to_engine=get_engine_by_model<to_model, CST>(engines);
+            using from_port=typename current_EIC::external_input_port;
+            using to_model=typename current_EIC::template submodel<TIME>;
+            using to_port=typename current_EIC::submodel_input_port;
+            static constexpr bool single_destination=count_destinations_from_input_port<from_port, EICs>::value == 1;
+
+            static void route(const TIME& t, INBAGS& inbox, const port_mask<INBAGS>& dirty, CST& engines, active_set& receivers){
+                auto& to_engine=get_engine_by_model<to_model, CST>(engines);
+                using to_bags=typename std::decay<decltype(to_engine._inbox)>::type;
                 auto& from_messages = cadmium::get_messages<from_port>(inbox);
                 auto& to_messages = cadmium::get_messages<to_port>(to_engine._inbox);
-                to_messages.insert(to_messages.end(), from_messages.begin(), from_messages.end());
-
-                //log
-                auto log_routing_collect = [](decltype(from_messages) from, decltype(to_messages) to) -> std::string {
+                std::size_t previous_size = to_messages.size();
+                if (dirty.test(port_index<from_port, INBAGS>::value) && !from_messages.empty()) {
+                    deliver_messages<single_destination>::deliver(from_messages, to_messages);
+                    to_engine._inbox_dirty.set(port_index<to_port, to_bags>::value);
+                    receivers.mark(get_engine_index_by_model<to_model, CST>::value);
+                }
+
+                //log, the messages routed are the ones appended to the destination
+                auto log_routing_collect = [](decltype(to_messages) to, std::size_t from) -> std::string {
                      std::ostringstream oss;
                      oss << " in port ";
                      oss << boost::typeindex::type_id<to_port>().pretty_name();
@@ -373,57 +563,35 @@ namespace cadmium {
                      oss << " routed from ";
                      oss << boost::typeindex::type_id<from_port>().pretty_name();
                      oss << " with messages ";
-                     implode(oss, from);
+                     implode(oss, std::next(to.begin(), from), to.end());
                      return oss.str();
                 };
                 LOGGER::template log<cadmium::logger::logger_message_routing,
                                      decltype(log_routing_collect),
-                                     decltype(from_messages),
-                                     decltype(to_messages)>(log_routing_collect, from_messages, to_messages);
+                                     decltype(to_messages),
+                                     std::size_t>(log_routing_collect, to_messages, previous_size);
 
                 //iterate
-                route_external_input_coupled_messages_on_subcoordinators_impl<TIME, INBAGS, CST, EICs, std::tuple_size<EICs>::value, LOGGER>::route(t, inbox, engines);
+                route_external_input_coupled_messages_on_subcoordinators_impl<TIME, INBAGS, CST, EICs, S-1, LOGGER>::route(t, inbox, dirty, engines, receivers);
 
             }
         };
 
         template<typename TIME, typename INBAGS, typename CST, typename EICs, typename LOGGER>
         struct route_external_input_coupled_messages_on_subcoordinators_impl<TIME, INBAGS, CST, EICs, 0, LOGGER>{
-            static void route(TIME T, const INBAGS& inbox, CST& engines){
+            static void route(const TIME& t, INBAGS& inbox, const port_mask<INBAGS>& dirty, CST& engines, active_set& receivers){
             //nothing to do here
             }
         };
 
 
+        //messages having a single destination are moved out of the inbox, ports not set in dirty are skipped
         template <typename TIME, typename INBAGS, typename CST, typename EICs, typename LOGGER >
-        void route_external_input_coupled_messages_on_subcoordinators(const TIME& t, const INBAGS& inbox, CST& cst){
-                route_external_input_coupled_messages_on_subcoordinators_impl<TIME, INBAGS, CST, EICs, std::tuple_size<EICs>::value, LOGGER>::route(t, inbox, cst);
+        void route_external_input_coupled_messages_on_subcoordinators(const TIME& t, INBAGS& inbox, const port_mask<INBAGS>& dirty, CST& cst, active_set& receivers){
+                route_external_input_coupled_messages_on_subcoordinators_impl<TIME, INBAGS, CST, EICs, std::tuple_size<EICs>::value, LOGGER>::route(t, inbox, dirty, cst, receivers);
             return;
         };
 
-        //auxiliary
-        template<size_t I, typename... Ps>
-        struct all_bags_empty_impl {
-            static bool check(std::tuple<Ps...> t) {
-                if (!std::get<I - 1>(t).messages.empty()) return false;
-                return all_bags_empty_impl<I - 1, Ps...>::check(t);
-            }
-        };
-
-        template<typename... Ps>
-        struct all_bags_empty_impl<0, Ps...> {
-            static bool check(std::tuple<Ps...> t) {
-                return true;
-            }
-        };
-
-        template<typename... Ps>
-        bool all_bags_empty(std::tuple<Ps...> t) {
-            return (std::tuple_size < std::tuple < Ps...>>() == 0 )
-            || all_bags_empty_impl<std::tuple_size<decltype(t)>::value, Ps...>::check(t);
-        }
-
-
         //priting messages
         template<size_t s, typename... T>
         struct print_messages_by_port_impl{
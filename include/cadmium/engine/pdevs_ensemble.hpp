@@ -0,0 +1,190 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CADMIUM_PDEVS_ENSEMBLE_HPP
+#define CADMIUM_PDEVS_ENSEMBLE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <boost/optional.hpp>
+
+#include <cadmium/engine/pdevs_runner.hpp>
+#include <cadmium/engine/task_scheduler.hpp>
+#include <cadmium/modeling/replication.hpp>
+#include <cadmium/modeling/step_arena.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+namespace cadmium {
+    namespace engine {
+        /**
+         * @brief The ensemble class runs many independent replications of a model in parallel.
+         *
+         * Each replication builds its own runner in a thread of a task_scheduler, with current_replication()
+         * set to its index and seed while the runner is built and run, so models can seed their random
+         * generators in their constructor. Replications are independent of the thread running them, the results
+         * depend only on the seed of the ensemble.
+         *
+         * Optionally, the ensemble keeps a step arena per thread reused by all the replications it runs, see use_step_arenas.
+         * The logger is called from all the threads, it needs to be parallel safe.
+         */
+        template <class TIME, template<class> class MODEL, typename LOGGER=cadmium::logger::not_logger, template<typename> class FEL=heap_fel,
+                  template<template<typename> class, typename, typename, template<typename> class> class ENGINE=coordinator>
+        class ensemble {
+            static_assert(parallel_safe_logger<LOGGER>::value, "The logger is called from the threads of all replications, it needs to be parallel safe");
+
+        public:
+            using runner_type=runner<TIME, MODEL, LOGGER, FEL, ENGINE>;
+
+        private:
+            std::unique_ptr<task_scheduler> _own_scheduler;
+            task_scheduler* _scheduler;
+            std::uint64_t _seed;
+
+            struct thread_arena {
+                std::unique_ptr<cadmium::step_arena> arena;
+                std::atomic<bool> in_use{false};
+            };
+            std::vector<thread_arena> _arenas; //one per thread of the scheduler, empty allocates from the heap
+
+            //lends the arena of current thread to a replication, a replication started in a thread while other
+            //one is running there (waiting for the tasks of a parallel engine) allocates from the heap.
+            //The flag is atomic as the threads out of a shared scheduler all take the index 0.
+            class arena_lease {
+                thread_arena* _lent=nullptr;
+            public:
+                arena_lease(std::vector<thread_arena>& arenas, std::size_t thread) noexcept {
+                    if (thread < arenas.size() && !arenas[thread].in_use.exchange(true, std::memory_order_acquire)) {
+                        _lent = &arenas[thread];
+                    }
+                }
+
+                ~arena_lease() {
+                    if (_lent) {
+                        _lent->in_use.store(false, std::memory_order_release);
+                    }
+                }
+
+                arena_lease(const arena_lease&) = delete;
+                arena_lease& operator=(const arena_lease&) = delete;
+
+                cadmium::step_arena* arena() const noexcept {
+                    return _lent ? _lent->arena.get() : nullptr;
+                }
+            };
+
+        public:
+            /**
+             * @brief ensemble runs the replications in a scheduler of its own
+             * @param threads is the number of threads of the scheduler
+             * @param seed is the seed the seeds of the replications are derived from
+             */
+            explicit ensemble(std::size_t threads=std::thread::hardware_concurrency(), std::uint64_t seed=0)
+            : _own_scheduler(new task_scheduler(threads)), _scheduler(_own_scheduler.get()), _seed(seed) {}
+
+            /**
+             * @brief ensemble runs the replications in a scheduler shared with other users
+             */
+            explicit ensemble(task_scheduler& scheduler, std::uint64_t seed=0) noexcept
+            : _scheduler(&scheduler), _seed(seed) {}
+
+            ensemble(const ensemble&) = delete;
+            ensemble& operator=(const ensemble&) = delete;
+
+            /**
+             * @brief use_step_arenas makes the runners take the memory of their steps from an arena per thread
+             * of the scheduler, owned by the ensemble. Only the ports using arena_vector_bag_policy take their
+             * messages from the arenas, the other ports keep allocating from the heap. See runner::use_step_arena
+             * for the restrictions on models.
+             */
+            void use_step_arenas(std::size_t chunk_size=cadmium::step_arena::default_chunk_size) {
+                std::vector<thread_arena> arenas(_scheduler->size());
+                for (auto& a : arenas) {
+                    a.arena.reset(new cadmium::step_arena(chunk_size));
+                }
+                _arenas.swap(arenas);
+            }
+
+            /**
+             * @brief replication_of tells the index and seed of the i-th replication
+             */
+            cadmium::replication replication_of(std::size_t i) const noexcept {
+                return cadmium::replication{i, cadmium::replication_seed(_seed, i)};
+            }
+
+            /**
+             * @brief run runs the replications and gathers their results
+             * @param replications is the number of replications
+             * @param init_time is the initial time of every runner
+             * @param f is called as f(replication, runner) in the thread of each replication, it runs the
+             * runner as needed and returns the result of the replication.
+             * @return the results in the order of the replications
+             * @throw the first exception thrown by a replication, after all of them finished
+             */
+            template<typename F>
+            auto run(std::size_t replications, const TIME& init_time, F&& f)
+            -> std::vector<typename std::decay<decltype(f(std::declval<const cadmium::replication&>(), std::declval<runner_type&>()))>::type> {
+                using result_type=typename std::decay<decltype(f(std::declval<const cadmium::replication&>(), std::declval<runner_type&>()))>::type;
+                std::vector<boost::optional<result_type>> results(replications);
+                _scheduler->for_each_index(replications, [this, &init_time, &f, &results](std::size_t i) {
+                    cadmium::replication r = replication_of(i);
+                    cadmium::replication_scope scope(r);
+                    arena_lease lease(_arenas, _scheduler->thread_index());
+                    runner_type runner(init_time);
+                    if (lease.arena()) {
+                        runner.use_step_arena(*lease.arena());
+                    }
+                    results[i] = f(static_cast<const cadmium::replication&>(r), runner);
+                });
+                std::vector<result_type> ret;
+                ret.reserve(replications);
+                for (auto& r : results) {
+                    ret.push_back(std::move(*r));
+                }
+                return ret;
+            }
+
+            /**
+             * @brief reduce runs the replications and combines their results in the order of the replications,
+             * so the reduction is the same for any number of threads.
+             * @return combine(...combine(combine(identity, result_0), result_1)..., result_n-1)
+             */
+            template<typename F, typename R, typename COMBINE>
+            R reduce(std::size_t replications, const TIME& init_time, F&& f, R identity, COMBINE&& combine) {
+                R ret=std::move(identity);
+                for (auto& r : run(replications, init_time, std::forward<F>(f))) {
+                    ret = combine(std::move(ret), std::move(r));
+                }
+                return ret;
+            }
+        };
+    }
+}
+
+#endif // CADMIUM_PDEVS_ENSEMBLE_HPP
@@ -0,0 +1,230 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CADMIUM_PDEVS_FEL_HPP
+#define CADMIUM_PDEVS_FEL_HPP
+
+#include <vector>
+#include <limits>
+#include <cstddef>
+#include <algorithm>
+#include <iterator>
+
+/**
+ * Future Event Lists (FEL) used by coordinators for scheduling their subengines.
+ *
+ * A FEL keeps the next scheduled time of each subengine, identified by its index in the
+ * coordinated tuple, and answers which ones are imminent at a given time.
+ * Every FEL provides:
+ *   init(nexts)        sets the next time of every subengine, nexts[i] is the time of engine i.
+ *   update(i, next)    changes the next time of the engine i.
+ *   next()             lowest next time in the list, infinity if there are no engines.
+ *   imminent(t, out)   appends to out the index of every engine scheduled at t.
+ */
+namespace cadmium {
+    namespace engine {
+
+        /**
+         * @brief linear_fel keeps the next times in a plain vector and scans all of them on every query.
+         * It is the scheduling the coordinator used before introducing the heap, and it is still the
+         * cheapest choice for coupled models having only a few submodels.
+         */
+        template<typename TIME>
+        class linear_fel {
+            std::vector<TIME> _nexts;
+
+        public:
+            void init(const std::vector<TIME>& nexts) {
+                _nexts = nexts;
+            }
+
+            void update(std::size_t engine, const TIME& next) {
+                _nexts[engine] = next;
+            }
+
+            TIME next() const {
+                if (_nexts.empty()) {
+                    return std::numeric_limits<TIME>::infinity();
+                }
+                return *std::min_element(_nexts.begin(), _nexts.end());
+            }
+
+            void imminent(const TIME& t, std::vector<std::size_t>& engines) const {
+                for (std::size_t i = 0; i < _nexts.size(); i++) {
+                    if (_nexts[i] == t) {
+                        engines.push_back(i);
+                    }
+                }
+            }
+        };
+
+        /**
+         * @brief heap_fel keeps the engines in an indexed binary min-heap ordered by their next time.
+         * Updating an engine costs O(log n) and finding the k imminent engines costs O(k), then the cost
+         * of a simulation step depends on the amount of engines involved and not in the model width.
+         * Asking for imminent engines at a time later than next() visits every engine scheduled before it.
+         */
+        template<typename TIME>
+        class heap_fel {
+            std::vector<TIME> _nexts; //next time by engine index
+            std::vector<std::size_t> _heap; //engine indexes in heap order
+            std::vector<std::size_t> _position; //position in _heap by engine index
+
+            bool before(std::size_t a, std::size_t b) const {
+                return _nexts[_heap[a]] < _nexts[_heap[b]];
+            }
+
+            void swap_positions(std::size_t a, std::size_t b) {
+                std::swap(_heap[a], _heap[b]);
+                _position[_heap[a]] = a;
+                _position[_heap[b]] = b;
+            }
+
+            void sift_up(std::size_t p) {
+                while (p > 0 && before(p, (p - 1) / 2)) {
+                    swap_positions(p, (p - 1) / 2);
+                    p = (p - 1) / 2;
+                }
+            }
+
+            void sift_down(std::size_t p) {
+                for (;;) {
+                    std::size_t lowest = p;
+                    std::size_t left = 2 * p + 1;
+                    std::size_t right = left + 1;
+                    if (left < _heap.size() && before(left, lowest)) lowest = left;
+                    if (right < _heap.size() && before(right, lowest)) lowest = right;
+                    if (lowest == p) return;
+                    swap_positions(p, lowest);
+                    p = lowest;
+                }
+            }
+
+            //the subtree rooted at p is skipped as soon as its root is scheduled later than t
+            void imminent_from(std::size_t p, const TIME& t, std::vector<std::size_t>& engines) const {
+                if (p >= _heap.size() || t < _nexts[_heap[p]]) return;
+                if (_nexts[_heap[p]] == t) {
+                    engines.push_back(_heap[p]);
+                }
+                imminent_from(2 * p + 1, t, engines);
+                imminent_from(2 * p + 2, t, engines);
+            }
+
+        public:
+            void init(const std::vector<TIME>& nexts) {
+                _nexts = nexts;
+                _heap.resize(_nexts.size());
+                _position.resize(_nexts.size());
+                for (std::size_t i = 0; i < _nexts.size(); i++) {
+                    _heap[i] = i;
+                    _position[i] = i;
+                }
+                for (std::size_t p = _heap.size() / 2; p > 0; p--) {
+                    sift_down(p - 1);
+                }
+            }
+
+            void update(std::size_t engine, const TIME& next) {
+                TIME previous = _nexts[engine];
+                _nexts[engine] = next;
+                if (next < previous) {
+                    sift_up(_position[engine]);
+                } else if (previous < next) {
+                    sift_down(_position[engine]);
+                }
+            }
+
+            TIME next() const {
+                if (_heap.empty()) {
+                    return std::numeric_limits<TIME>::infinity();
+                }
+                return _nexts[_heap[0]];
+            }
+
+            void imminent(const TIME& t, std::vector<std::size_t>& engines) const {
+                imminent_from(0, t, engines);
+            }
+        };
+
+        /**
+         * @brief active_set collects, without repetitions, the indexes of the subengines involved in a step.
+         * Those are the imminent engines and the ones that received messages while routing.
+         */
+        class active_set {
+            std::vector<bool> _marked;
+            std::vector<std::size_t> _engines;
+            std::vector<std::size_t> _merged; //room for merging the engines marked since last sorted
+            std::size_t _sorted=0; //engines at the front of _engines already in order
+
+            static bool before(std::size_t a, std::size_t b) noexcept {
+                return a > b;
+            }
+
+        public:
+            void init(std::size_t size) {
+                _marked.assign(size, false);
+                _engines.clear();
+                _engines.reserve(size);
+                _merged.clear();
+                _merged.reserve(size);
+                _sorted = 0;
+            }
+
+            void mark(std::size_t engine) {
+                if (!_marked[engine]) {
+                    _marked[engine] = true;
+                    _engines.push_back(engine);
+                }
+            }
+
+            //engines are listed from the last to the first in the tuple, the order used by the helpers iterating tuples
+            //only the engines marked since the last call are sorted, then merged with the ones already in order
+            const std::vector<std::size_t>& engines() {
+                if (_sorted < _engines.size()) {
+                    auto middle = _engines.begin() + _sorted;
+                    std::sort(middle, _engines.end(), &active_set::before);
+                    if (_sorted > 0) {
+                        _merged.clear();
+                        std::merge(_engines.begin(), middle, middle, _engines.end(), std::back_inserter(_merged), &active_set::before);
+                        _engines.swap(_merged);
+                    }
+                    _sorted = _engines.size();
+                }
+                return _engines;
+            }
+
+            void clear() {
+                for (auto e : _engines) {
+                    _marked[e] = false;
+                }
+                _engines.clear();
+                _sorted = 0;
+            }
+        };
+    }
+}
+
+#endif // CADMIUM_PDEVS_FEL_HPP
@@ -0,0 +1,418 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CADMIUM_PDEVS_FLAT_COORDINATOR_HPP
+#define CADMIUM_PDEVS_FLAT_COORDINATOR_HPP
+
+#include <limits>
+#include <sstream>
+#include <type_traits>
+#include <vector>
+#include <boost/type_index.hpp>
+
+#include <cadmium/engine/pdevs_engine_helpers.hpp>
+#include <cadmium/engine/pdevs_flattening.hpp>
+#include <cadmium/engine/pdevs_fel.hpp>
+#include <cadmium/engine/pdevs_simulator.hpp>
+#include <cadmium/modeling/message_bag.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+namespace cadmium {
+    namespace engine {
+        //phases of the step, the outputs of the top model are routed when collecting and the rest when advancing
+        struct flat_collect_phase{};
+        struct flat_advance_phase{};
+
+        //a simulator for each atomic model in the tree
+        template<template<typename> class MODEL, typename TIME, typename LOGGER, typename PATHS>
+        struct flat_simulators;
+
+        template<template<typename> class MODEL, typename TIME, typename LOGGER, typename... PATHS>
+        struct flat_simulators<MODEL, TIME, LOGGER, std::tuple<PATHS...>>{
+            using type=std::tuple<simulator<flat_leaf_model<MODEL, PATHS>::template type, TIME, LOGGER>...>;
+        };
+
+        /**
+         * @brief The flat_coordinator class runs a PDEVS coupled model as a single level of simulators
+         *
+         * The coupled model tree is flattened at compile time, a simulator is created for every atomic model
+         * and the couplings are resolved into direct routes from the output ports of atomic models to the input
+         * ports of atomic models or to the output ports of the top model.
+         * Messages are moved once from source to destination, or copied once per destination on fan-out, no
+         * matter how many levels they cross, and a single FEL schedules all the simulators.
+         *
+         * The observable behaviour is the one of the coordinator: same interface, same outputs and same
+         * states. The routing logs show the resolved routes instead of every coupling in the hierarchy, and
+         * messages arriving to the same port from different sources may be in a different order in the bag.
+         */
+        template<template<typename T> class MODEL, typename TIME, typename LOGGER, template<typename> class FEL=heap_fel>
+        class flat_coordinator {
+        public:
+            using model_type=MODEL<TIME>;
+
+        private:
+            using in_bags_type=typename make_message_bags<typename MODEL<TIME>::input_ports>::type;
+            using out_bags_type=typename make_message_bags<typename MODEL<TIME>::output_ports>::type;
+            using leaves_paths=typename flat_leaves<TIME, model_type, std::tuple<>>::type;
+            using simulators_type=typename flat_simulators<MODEL, TIME, LOGGER, leaves_paths>::type;
+            using simulators=subengines_dispatch<TIME, simulators_type>;
+            static constexpr std::size_t leaves_count=std::tuple_size<simulators_type>::value;
+
+            TIME _last; //last transition time
+            TIME _next; //next transition scheduled
+            simulators_type _simulators;
+            FEL<TIME> _fel; //next time of every simulator
+            active_set _active; //simulators involved in current step
+            std::vector<std::size_t> _imminent; //simulators scheduled for current step
+            bool _collected=false; //the imminent subengines at _next were found by collect_outputs
+
+        public://making boxes temporarily public
+            //TODO: set boxes back to private
+            in_bags_type _inbox;
+            out_bags_type _outbox;
+            port_mask<in_bags_type> _inbox_dirty; //non empty ports in the inbox, set by whoever fills the inbox
+            port_mask<out_bags_type> _outbox_dirty; //non empty ports in the outbox
+
+        private:
+            void find_imminent(const TIME& t) {
+                _imminent.clear();
+                _fel.imminent(t, _imminent);
+                for (auto e : _imminent) {
+                    _active.mark(e);
+                }
+            }
+
+            //delivery of messages to a single destination, each route is used only in one of the phases
+            template<bool SINGLE_DESTINATION, typename FROM_MODEL, typename FROM_PORT, typename BAG, typename PATH, typename TO_PORT>
+            void deliver(BAG& from_messages, flat_tag<flat_leaf_destination<PATH, TO_PORT>>, flat_advance_phase) {
+                constexpr std::size_t to_leaf=flat_type_index<PATH, leaves_paths>::value;
+                auto& to_engine=std::get<to_leaf>(_simulators);
+                using to_model=typename std::decay<decltype(to_engine)>::type::model_type;
+                using to_bags=typename std::decay<decltype(to_engine._inbox)>::type;
+                auto& to_messages=get_messages<TO_PORT>(to_engine._inbox);
+                std::size_t previous_size=to_messages.size();
+                deliver_messages<SINGLE_DESTINATION>::deliver(from_messages, to_messages);
+                to_engine._inbox_dirty.set(port_index<TO_PORT, to_bags>::value);
+                _active.mark(to_leaf);
+
+                auto log_routing = [](decltype(to_messages) to, std::size_t from) -> std::string {
+                     std::ostringstream oss;
+                     oss << " in port ";
+                     oss << boost::typeindex::type_id<TO_PORT>().pretty_name();
+                     oss << " of model ";
+                     oss << boost::typeindex::type_id<to_model>().pretty_name();
+                     oss << " has ";
+                     implode(oss, to);
+                     oss << " routed from ";
+                     oss << boost::typeindex::type_id<FROM_PORT>().pretty_name();
+                     oss << " of model ";
+                     oss << boost::typeindex::type_id<FROM_MODEL>().pretty_name();
+                     oss << " with messages ";
+                     implode(oss, std::next(to.begin(), from), to.end());
+                     return oss.str();
+                };
+                LOGGER::template log<cadmium::logger::logger_message_routing,
+                                     decltype(log_routing),
+                                     decltype(to_messages),
+                                     std::size_t>(log_routing, to_messages, previous_size);
+            }
+
+            template<bool SINGLE_DESTINATION, typename FROM_MODEL, typename FROM_PORT, typename BAG, typename TO_PORT>
+            void deliver(BAG& from_messages, flat_tag<flat_top_destination<TO_PORT>>, flat_collect_phase) {
+                auto& to_messages=get_messages<TO_PORT>(_outbox);
+                std::size_t previous_size=to_messages.size();
+                deliver_messages<SINGLE_DESTINATION>::deliver(from_messages, to_messages);
+                _outbox_dirty.set(port_index<TO_PORT, out_bags_type>::value);
+
+                auto log_routing = [](decltype(to_messages) to, std::size_t from) -> std::string {
+                     std::ostringstream oss;
+                     oss << " in port ";
+                     oss << boost::typeindex::type_id<TO_PORT>().pretty_name();
+                     oss << " has ";
+                     implode(oss, to);
+                     oss << " routed from ";
+                     oss << boost::typeindex::type_id<FROM_PORT>().pretty_name();
+                     oss << " of model ";
+                     oss << boost::typeindex::type_id<FROM_MODEL>().pretty_name();
+                     oss << " with messages ";
+                     implode(oss, std::next(to.begin(), from), to.end());
+                     return oss.str();
+                };
+                LOGGER::template log<cadmium::logger::logger_message_routing,
+                                     decltype(log_routing),
+                                     decltype(to_messages),
+                                     std::size_t>(log_routing, to_messages, previous_size);
+            }
+
+            template<bool SINGLE_DESTINATION, typename FROM_MODEL, typename FROM_PORT, typename BAG, typename DESTINATION, typename PHASE>
+            void deliver(BAG&, flat_tag<DESTINATION>, PHASE) {
+                //the destination is served in the other phase
+            }
+
+            //route the messages in the outbox of the simulator at position I
+            template<std::size_t I, typename PHASE>
+            static void route_from_simulator(flat_coordinator& c) {
+                using path=typename std::tuple_element<I, leaves_paths>::type;
+                auto& from_engine=std::get<I>(c._simulators);
+                using from_model=typename std::decay<decltype(from_engine)>::type::model_type;
+                using from_bags=typename std::decay<decltype(from_engine._outbox)>::type;
+                flat_for_each<typename from_model::output_ports>::apply([&c, &from_engine](auto port_tag) {
+                    using from_port=typename decltype(port_tag)::type;
+                    using destinations=typename flat_routes_from_leaf<TIME, model_type, path, from_port>::type;
+                    using single_destination=std::integral_constant<bool, std::tuple_size<destinations>::value == 1>;
+                    auto& from_messages=get_messages<from_port>(from_engine._outbox);
+                    if (from_engine._outbox_dirty.test(port_index<from_port, from_bags>::value) && !from_messages.empty()) {
+                        flat_for_each<destinations>::apply([&c, &from_messages](auto destination_tag) {
+                            c.template deliver<single_destination::value, from_model, from_port>(from_messages, destination_tag, PHASE{});
+                        });
+                    }
+                });
+            }
+
+            template<typename PHASE, std::size_t... Is>
+            void route_from_simulator(std::size_t simulator, std::index_sequence<Is...>) {
+                using route_ptr=void (*)(flat_coordinator&);
+                static constexpr route_ptr table[] = {&flat_coordinator::route_from_simulator<Is, PHASE>...};
+                table[simulator](*this);
+            }
+
+            template<typename PHASE>
+            void route_from_simulator(std::size_t, std::index_sequence<>) {
+                //no simulators
+            }
+
+            //route the messages in the inbox of the top model
+            void route_from_inbox() {
+                flat_for_each<typename model_type::input_ports>::apply([this](auto port_tag) {
+                    using from_port=typename decltype(port_tag)::type;
+                    using destinations=typename flat_routes_from_input<TIME, model_type, from_port>::type;
+                    using single_destination=std::integral_constant<bool, std::tuple_size<destinations>::value == 1>;
+                    auto& from_messages=get_messages<from_port>(_inbox);
+                    if (_inbox_dirty.test(port_index<from_port, in_bags_type>::value) && !from_messages.empty()) {
+                        flat_for_each<destinations>::apply([this, &from_messages](auto destination_tag) {
+                            this->template deliver<single_destination::value, model_type, from_port>(from_messages, destination_tag, flat_advance_phase{});
+                        });
+                    }
+                });
+            }
+
+        public:
+            /**
+             * @brief init function sets the start time
+             * @param t is the start time
+             */
+            void init(TIME t) {
+                auto log_info_init = [](TIME t) -> std::string {
+                     std::ostringstream oss;
+                     oss << "Coordinator for model ";
+                     oss << boost::typeindex::type_id<model_type>().pretty_name();
+                     oss << " initialized to time ";
+                     oss << t;
+                     return oss.str();
+                 };
+                LOGGER::template log<cadmium::logger::logger_info, decltype(log_info_init), TIME>(log_info_init, t);
+
+                _last = t;
+                init_subcoordinators<TIME, simulators_type>(t, _simulators);
+                _fel.init(nexts_in_tuple<TIME, simulators_type>(_simulators));
+                _active.init(leaves_count);
+                _collected = false;
+                _next = _fel.next();
+            }
+
+            /**
+             * @brief save writes the times, the messages waiting in the inbox and the state of the subtree
+             */
+            void save(cadmium::checkpoint_writer& w) const {
+                w.write(_last);
+                w.write(_next);
+                w.write(_inbox);
+                cadmium::engine::save_subcoordinators(w, _simulators);
+            }
+
+            /**
+             * @brief load restores what save wrote, in place of init, the FEL is rebuilt from the subengines
+             */
+            void load(cadmium::checkpoint_reader& r) {
+                r.read(_last);
+                r.read(_next);
+                r.read(_inbox);
+                _inbox_dirty = cadmium::non_empty_ports(_inbox);
+                cadmium::reset_message_bags(_outbox);
+                _outbox_dirty.reset();
+                cadmium::engine::load_subcoordinators(r, _simulators);
+                _fel.init(cadmium::engine::nexts_in_tuple<TIME, simulators_type>(_simulators));
+                _active.init(std::tuple_size<simulators_type>::value);
+                _collected = false;
+            }
+
+            /**
+             * @brief Coordinator expected next internal transition time
+             */
+            TIME next() const noexcept {
+                return _next;
+            }
+
+            /**
+             * @brief imminent tells if some atomic model has an internal transition scheduled at t
+             */
+            bool imminent(const TIME& t) const noexcept {
+                return _next == t;
+            }
+
+            /**
+             * @brief has_pending_input tells if messages were introduced in the inbox for next advance_simulation
+             */
+            bool has_pending_input() const noexcept {
+                return _inbox_dirty.any();
+            }
+
+            /**
+             * @brief active tells if advancing the simulation to t involves any atomic model
+             */
+            bool active(const TIME& t) const noexcept {
+                return imminent(t) || has_pending_input();
+            }
+
+            /**
+             * @brief inbox introduces messages for next advance_simulation
+             */
+            void inbox(in_bags_type in) {
+                //messages are moved into the bags of the inbox, keeping the memory they retained in last reset
+                cadmium::reset_message_bags(_inbox);
+                cadmium::append_message_bags(_inbox, in);
+                _inbox_dirty = cadmium::non_empty_ports(_inbox);
+            }
+
+            /**
+             * @brief outbox keeps the output generated by the last call to collect_outputs
+             */
+            const out_bags_type& outbox() const noexcept {
+                return _outbox;
+            }
+
+            /**
+             * @brief Collects outputs ready for output before advancing the simulation
+             * @param t time the simulation will be advanced to
+             */
+            void collect_outputs(const TIME& t) {
+                auto log_info_collect = [](TIME t) -> std::string {
+                     std::ostringstream oss;
+                     oss << "Coordinator for model ";
+                     oss << boost::typeindex::type_id<model_type>().pretty_name();
+                     oss << " collecting output at time ";
+                     oss << t;
+                     return oss.str();
+                };
+                LOGGER::template log<cadmium::logger::logger_info, decltype(log_info_collect), TIME>(log_info_collect, t);
+
+                if (_next < t) {
+                    throw std::domain_error("Trying to obtain output when not internal event is scheduled");
+                }
+                cadmium::reset_message_bags(_outbox);
+                _outbox_dirty.reset();
+                if (imminent(t)) {
+                    auto log_routing_collect = []() -> std::string {
+                         std::ostringstream oss;
+                         oss << "Flat routes to output for model ";
+                         oss << boost::typeindex::type_id<model_type>().pretty_name();
+                         return oss.str();
+                    };
+                    LOGGER::template log<cadmium::logger::logger_message_routing,
+                                         decltype(log_routing_collect)>(log_routing_collect);
+
+                    _active.clear();
+                    find_imminent(t);
+                    _collected = true;
+                    for (auto e : _imminent) {
+                        simulators::collect_outputs(e, t, _simulators);
+                    }
+                    for (auto e : _imminent) {
+                        route_from_simulator<flat_collect_phase>(e, std::make_index_sequence<leaves_count>{});
+                    }
+                }
+            }
+
+            /**
+             * @brief advanceSimulation advances the execution to t, at t introduces the messages into the system (if any).
+             * @param t is the time the transition is expected to be run.
+             * Only imminent simulators and simulators receiving messages are advanced.
+             */
+            void advance_simulation(const TIME& t) {
+                auto log_info_advance = [](const TIME& from, const TIME& to) -> std::string {
+                     std::ostringstream oss;
+                     oss << "Coordinator for model ";
+                     oss << boost::typeindex::type_id<model_type>().pretty_name();
+                     oss << " advancing simulation from time ";
+                     oss << from;
+                     oss << " to ";
+                     oss << to;
+                     return oss.str();
+                };
+                if (_next < t || t < _last) {
+                    throw std::domain_error("Trying to obtain output when out of the advance time scope");
+                } else if (active(t)) {
+                    LOGGER::template log<cadmium::logger::logger_info, decltype(log_info_advance), TIME>(log_info_advance, _last, t);
+                    auto log_routing_advance = []() -> std::string {
+                         std::ostringstream oss;
+                         oss << "Flat routes between atomic models for model ";
+                         oss << boost::typeindex::type_id<model_type>().pretty_name();
+                         return oss.str();
+                    };
+                    LOGGER::template log<cadmium::logger::logger_message_routing,
+                                         decltype(log_routing_advance)>(log_routing_advance);
+
+                    //the imminent simulators found by collect_outputs for t are reused
+                    if (!(_collected && imminent(t))) {
+                        _active.clear();
+                        _imminent.clear();
+                        if (imminent(t)) {
+                            find_imminent(t);
+                        }
+                    }
+                    _collected = false;
+                    //only imminent simulators can have output
+                    for (auto e : _imminent) {
+                        route_from_simulator<flat_advance_phase>(e, std::make_index_sequence<leaves_count>{});
+                    }
+                    route_from_inbox();
+                    for (auto e : _active.engines()) {
+                        simulators::advance_simulation(e, t, _simulators);
+                        _fel.update(e, simulators::next(e, _simulators));
+                    }
+                    _last = t;
+                    _next = _fel.next();
+                    cadmium::reset_message_bags(_inbox);
+                    cadmium::reset_message_bags(_outbox);
+                    _inbox_dirty.reset();
+                    _outbox_dirty.reset();
+                }
+            }
+        };
+    }
+}
+
+#endif // CADMIUM_PDEVS_FLAT_COORDINATOR_HPP
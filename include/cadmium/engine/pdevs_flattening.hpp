@@ -0,0 +1,262 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CADMIUM_PDEVS_FLATTENING_HPP
+#define CADMIUM_PDEVS_FLATTENING_HPP
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+
+/**
+ * Compile time flattening of a coupled model tree.
+ *
+ * The atomic models in the tree (leaves) are identified by their path, a tuple of std::integral_constant
+ * with the position of the submodel at each level starting from the top model. The path is required
+ * because the same atomic model can be used in many coupled models.
+ * The couplings are followed from every output port of every leaf until reaching input ports of other
+ * leaves or output ports of the top model, giving the direct routes used by the flat coordinator.
+ *
+ * All the metafunctions receive the models already instantiated with the TIME.
+ */
+namespace cadmium {
+    namespace engine {
+        //a type carried as value for iterating tuples of types with generic lambdas
+        template<typename T>
+        struct flat_tag{
+            using type=T;
+        };
+
+        //calls f with a flat_tag of every type in the tuple, in order
+        template<typename TUPLE>
+        struct flat_for_each;
+
+        template<typename... Ts>
+        struct flat_for_each<std::tuple<Ts...>>{
+            template<typename F>
+            static void apply(F&& f){
+                int expand[] = {0, (f(flat_tag<Ts>{}), 0)...};
+                (void)expand;
+            }
+        };
+
+        //concatenation of the tuples obtained applying MAPPER::apply to every type in the tuple
+        template<typename MAPPER, typename TUPLE>
+        struct flat_concat_map;
+
+        template<typename MAPPER, typename... Ts>
+        struct flat_concat_map<MAPPER, std::tuple<Ts...>>{
+            using type=decltype(std::tuple_cat(std::declval<typename MAPPER::template apply<Ts>::type>()...));
+        };
+
+        //position of the first T in a tuple
+        template<typename T, typename TUPLE>
+        struct flat_type_index;
+
+        template<typename T, typename... Ts>
+        struct flat_type_index<T, std::tuple<T, Ts...>> : std::integral_constant<std::size_t, 0>{};
+
+        template<typename T, typename U, typename... Ts>
+        struct flat_type_index<T, std::tuple<U, Ts...>> : std::integral_constant<std::size_t, 1+flat_type_index<T, std::tuple<Ts...>>::value>{};
+
+        //detection of coupled models, only coupled models define submodels
+        template<typename M, typename=void>
+        struct flat_is_coupled : std::false_type{};
+
+        template<typename M>
+        struct flat_is_coupled<M, decltype(void(std::declval<typename M::template models<float>>()))> : std::true_type{};
+
+        //paths
+        template<typename PATH, std::size_t I>
+        struct flat_path_push;
+
+        template<typename... Is, std::size_t I>
+        struct flat_path_push<std::tuple<Is...>, I>{
+            using type=std::tuple<Is..., std::integral_constant<std::size_t, I>>;
+        };
+
+        template<typename PATH, typename IS=std::make_index_sequence<std::tuple_size<PATH>::value - 1>>
+        struct flat_path_parent;
+
+        template<typename PATH, std::size_t... Is>
+        struct flat_path_parent<PATH, std::index_sequence<Is...>>{
+            using type=std::tuple<typename std::tuple_element<Is, PATH>::type...>;
+            static constexpr std::size_t last=std::tuple_element<std::tuple_size<PATH>::value - 1, PATH>::type::value;
+        };
+
+        //model found following the path from M
+        template<typename TIME, typename M, typename PATH>
+        struct flat_model_at;
+
+        template<typename TIME, typename M>
+        struct flat_model_at<TIME, M, std::tuple<>>{
+            using type=M;
+        };
+
+        template<typename TIME, typename M, typename I, typename... Is>
+        struct flat_model_at<TIME, M, std::tuple<I, Is...>>{
+            using submodel=typename std::tuple_element<I::value, typename M::template models<TIME>>::type;
+            using type=typename flat_model_at<TIME, submodel, std::tuple<Is...>>::type;
+        };
+
+        //the leaf model as a template on TIME, for being simulated
+        template<template<typename> class TOP, typename PATH>
+        struct flat_leaf_model{
+            template<typename T>
+            using type=typename flat_model_at<T, TOP<T>, PATH>::type;
+        };
+
+        //paths of all the leaves under M, in depth first order
+        template<typename TIME, typename M, typename PATH, bool COUPLED=flat_is_coupled<M>::value>
+        struct flat_leaves{
+            using type=std::tuple<PATH>;
+        };
+
+        template<typename TIME, typename M, typename PATH, typename IS>
+        struct flat_leaves_of_submodels;
+
+        template<typename TIME, typename M, typename PATH, std::size_t... Is>
+        struct flat_leaves_of_submodels<TIME, M, PATH, std::index_sequence<Is...>>{
+            using submodels=typename M::template models<TIME>;
+            using type=decltype(std::tuple_cat(std::declval<typename flat_leaves<TIME, typename std::tuple_element<Is, submodels>::type, typename flat_path_push<PATH, Is>::type>::type>()...));
+        };
+
+        template<typename TIME, typename M, typename PATH>
+        struct flat_leaves<TIME, M, PATH, true>{
+            using type=typename flat_leaves_of_submodels<TIME, M, PATH, std::make_index_sequence<std::tuple_size<typename M::template models<TIME>>::value>>::type;
+        };
+
+        //destinations of messages after following the couplings
+        template<typename PATH, typename PORT>
+        struct flat_leaf_destination{
+            using path=PATH;
+            using port=PORT;
+        };
+
+        template<typename PORT>
+        struct flat_top_destination{
+            using port=PORT;
+        };
+
+        //destinations of messages arriving to an input port of the model at PATH
+        template<typename TIME, typename M, typename PATH, typename PORT, bool COUPLED=flat_is_coupled<M>::value>
+        struct flat_descend_input{
+            using type=std::tuple<flat_leaf_destination<PATH, PORT>>;
+        };
+
+        template<typename TIME, typename M, typename PATH, typename PORT, typename EIC, bool MATCH=std::is_same<typename EIC::external_input_port, PORT>::value>
+        struct flat_descend_eic{
+            using type=std::tuple<>;
+        };
+
+        template<typename TIME, typename M, typename PATH, typename PORT, typename EIC>
+        struct flat_descend_eic<TIME, M, PATH, PORT, EIC, true>{
+            using submodels=typename M::template models<TIME>;
+            using submodel=typename EIC::template submodel<TIME>;
+            using type=typename flat_descend_input<TIME, submodel, typename flat_path_push<PATH, flat_type_index<submodel, submodels>::value>::type, typename EIC::submodel_input_port>::type;
+        };
+
+        template<typename TIME, typename M, typename PATH, typename PORT>
+        struct flat_descend_input<TIME, M, PATH, PORT, true>{
+            struct mapper{
+                template<typename EIC>
+                using apply=flat_descend_eic<TIME, M, PATH, PORT, EIC>;
+            };
+            using type=typename flat_concat_map<mapper, typename M::external_input_couplings>::type;
+        };
+
+        //destinations of messages leaving the output port of the submodel at position SUB in the model at PATH
+        template<typename TIME, typename TOP, typename PATH, std::size_t SUB, typename PORT>
+        struct flat_ascend_output;
+
+        template<typename TIME, typename C, typename PATH, typename SUBMODEL, typename PORT, typename IC,
+                 bool MATCH=std::is_same<typename IC::template from_model<TIME>, SUBMODEL>::value && std::is_same<typename IC::from_model_output_port, PORT>::value>
+        struct flat_ascend_ic{
+            using type=std::tuple<>;
+        };
+
+        template<typename TIME, typename C, typename PATH, typename SUBMODEL, typename PORT, typename IC>
+        struct flat_ascend_ic<TIME, C, PATH, SUBMODEL, PORT, IC, true>{
+            using submodels=typename C::template models<TIME>;
+            using to_model=typename IC::template to_model<TIME>;
+            using type=typename flat_descend_input<TIME, to_model, typename flat_path_push<PATH, flat_type_index<to_model, submodels>::value>::type, typename IC::to_model_input_port>::type;
+        };
+
+        template<typename TIME, typename TOP, typename PATH, typename EXTERNAL_PORT, bool IS_TOP=std::tuple_size<PATH>::value == 0>
+        struct flat_leave_coupled{
+            using type=std::tuple<flat_top_destination<EXTERNAL_PORT>>;
+        };
+
+        template<typename TIME, typename TOP, typename PATH, typename EXTERNAL_PORT>
+        struct flat_leave_coupled<TIME, TOP, PATH, EXTERNAL_PORT, false>{
+            using parent=flat_path_parent<PATH>;
+            using type=typename flat_ascend_output<TIME, TOP, typename parent::type, parent::last, EXTERNAL_PORT>::type;
+        };
+
+        template<typename TIME, typename TOP, typename PATH, typename SUBMODEL, typename PORT, typename EOC,
+                 bool MATCH=std::is_same<typename EOC::template submodel<TIME>, SUBMODEL>::value && std::is_same<typename EOC::submodel_output_port, PORT>::value>
+        struct flat_ascend_eoc{
+            using type=std::tuple<>;
+        };
+
+        template<typename TIME, typename TOP, typename PATH, typename SUBMODEL, typename PORT, typename EOC>
+        struct flat_ascend_eoc<TIME, TOP, PATH, SUBMODEL, PORT, EOC, true>{
+            using type=typename flat_leave_coupled<TIME, TOP, PATH, typename EOC::external_output_port>::type;
+        };
+
+        template<typename TIME, typename TOP, typename PATH, std::size_t SUB, typename PORT>
+        struct flat_ascend_output{
+            using coupled=typename flat_model_at<TIME, TOP, PATH>::type;
+            using submodel=typename std::tuple_element<SUB, typename coupled::template models<TIME>>::type;
+            struct ic_mapper{
+                template<typename IC>
+                using apply=flat_ascend_ic<TIME, coupled, PATH, submodel, PORT, IC>;
+            };
+            struct eoc_mapper{
+                template<typename EOC>
+                using apply=flat_ascend_eoc<TIME, TOP, PATH, submodel, PORT, EOC>;
+            };
+            using type=decltype(std::tuple_cat(std::declval<typename flat_concat_map<ic_mapper, typename coupled::internal_couplings>::type>(),
+                                               std::declval<typename flat_concat_map<eoc_mapper, typename coupled::external_output_couplings>::type>()));
+        };
+
+        //destinations of the messages leaving the port of the leaf at PATH
+        template<typename TIME, typename TOP, typename PATH, typename PORT>
+        struct flat_routes_from_leaf{
+            using parent=flat_path_parent<PATH>;
+            using type=typename flat_ascend_output<TIME, TOP, typename parent::type, parent::last, PORT>::type;
+        };
+
+        //destinations of the messages arriving to an input port of the top model
+        template<typename TIME, typename TOP, typename PORT>
+        struct flat_routes_from_input{
+            using type=typename flat_descend_input<TIME, TOP, std::tuple<>, PORT>::type;
+        };
+    }
+}
+
+#endif // CADMIUM_PDEVS_FLATTENING_HPP
@@ -0,0 +1,442 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CADMIUM_PDEVS_MULTIPROCESS_RUNNER_HPP
+#define CADMIUM_PDEVS_MULTIPROCESS_RUNNER_HPP
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cadmium/engine/pdevs_coordinator.hpp>
+#include <cadmium/engine/pdevs_engine_helpers.hpp>
+#include <cadmium/engine/shared_memory_ring.hpp>
+#include <cadmium/modeling/message_bag.hpp>
+#include <cadmium/logger/logger.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+namespace cadmium {
+    namespace engine {
+        /**
+         * @brief The multiprocess_runner class runs each submodel of the top coupled model in its own process.
+         *
+         * The processes are forked by the constructor, each one builds only the simulator or coordinator of its
+         * partition, so partitions do not share memory or allocators. The messages following the ICs of the top
+         * model are written to a shared_memory_ring per IC, so the messages crossing partitions need to be
+         * trivially copyable, and so does TIME.
+         *
+         * The process of the runner coordinates global time, all processes run every step in lockstep:
+         * the partitions imminent at the next time collect their outputs and write them to the rings, then every
+         * partition reads its rings and advances, and reports its next time. The states and messages of each model
+         * are the ones of the runner, messages arriving to a port from different partitions may be in different
+         * order in the bag.
+         *
+         * Each process logs by itself, sinks need to be shared with care, std::cout is flushed before forking.
+         * An exception thrown in a partition stops all the processes and is rethrown by the runner as a
+         * std::runtime_error with the same message. A partition process dying, as killed by a signal, is noticed
+         * while the runner waits for it, the other processes are killed and the runner throws std::runtime_error.
+         * Linux only.
+         */
+        template <class TIME, template<class> class MODEL, typename LOGGER=cadmium::logger::not_logger, template<typename> class FEL=heap_fel>
+        class multiprocess_runner {
+            static_assert(std::is_trivially_copyable<TIME>::value, "TIME is shared between processes, it needs to be trivially copyable");
+
+            template<typename P>
+            using submodels_type=typename MODEL<TIME>::template models<P>;
+            using engines_type=typename coordinate_tuple<TIME, submodels_type, LOGGER, FEL>::type;
+            using ics=typename MODEL<TIME>::internal_couplings;
+            static constexpr std::size_t partitions_count=std::tuple_size<engines_type>::value;
+            static constexpr std::size_t ics_count=std::tuple_size<ics>::value;
+
+            template<std::size_t I>
+            using partition_engine=typename std::tuple_element<I, engines_type>::type;
+            template<std::size_t I>
+            using partition_bags=typename make_message_bags<typename partition_engine<I>::model_type::input_ports>::type;
+            template<std::size_t K>
+            using ic=typename std::tuple_element<K, ics>::type;
+            template<std::size_t K>
+            using ic_from=get_engine_index_by_model<typename ic<K>::template from_model<TIME>, engines_type>;
+            template<std::size_t K>
+            using ic_to=get_engine_index_by_model<typename ic<K>::template to_model<TIME>, engines_type>;
+
+            //lives in the shared memory, followed by the rings.
+            //The partitions post arrived when they finish a phase of a step, the runner waits for all of them
+            //and then posts the next phase once per partition. The runner waits with a timeout to notice dead
+            //partitions, the partitions wait without one as they are killed when the runner dies.
+            struct control_block {
+                sem_t arrived; //a partition reported its next or wrote its outputs
+                sem_t start; //time of next step is set
+                sem_t exchanged; //outputs are in the rings
+                TIME time;
+                int stop;
+                std::atomic<int> failed;
+                char error[256];
+                std::array<TIME, partitions_count> nexts;
+            };
+
+            static constexpr std::size_t ring_offset=(sizeof(control_block) + 63) / 64 * 64;
+
+            void* _memory=MAP_FAILED;
+            std::size_t _memory_size=0;
+            std::size_t _ring_size=0;
+            control_block* _control=nullptr;
+            std::vector<pid_t> _children;
+            bool _running=false;
+            TIME _next;
+
+            shared_memory_ring& ring(std::size_t k) noexcept {
+                return *reinterpret_cast<shared_memory_ring*>(static_cast<unsigned char*>(_memory) + ring_offset + k * _ring_size);
+            }
+
+            static constexpr long partition_check_nanoseconds=10000000; //how often a waiting runner checks partitions
+
+            //the partition waits for the runner to post the next phase
+            static void wait_phase(sem_t& phase) noexcept {
+                while (sem_wait(&phase) == -1 && errno == EINTR) {}
+            }
+
+            //the partition tells the runner it finished a phase and waits for the next one
+            static void arrive_and_wait(control_block& control, sem_t& phase) noexcept {
+                sem_post(&control.arrived);
+                wait_phase(phase);
+            }
+
+            //the runner posts a phase for every partition
+            void post_phase(sem_t& phase) noexcept {
+                for (std::size_t i = 0; i < partitions_count; ++i) {
+                    sem_post(&phase);
+                }
+            }
+
+            //the runner waits for every partition to arrive, checking none of them died meanwhile
+            void wait_arrivals() {
+                for (std::size_t i = 0; i < partitions_count; ++i) {
+                    while (true) {
+                        timespec deadline;
+                        clock_gettime(CLOCK_REALTIME, &deadline);
+                        deadline.tv_nsec += partition_check_nanoseconds;
+                        if (deadline.tv_nsec >= 1000000000) {
+                            deadline.tv_nsec -= 1000000000;
+                            ++deadline.tv_sec;
+                        }
+                        if (sem_timedwait(&_control->arrived, &deadline) == 0) {
+                            break;
+                        }
+                        if (errno == ETIMEDOUT) {
+                            check_partitions_alive();
+                        }
+                    }
+                }
+            }
+
+            //kills every partition and throws if any of them ended
+            void check_partitions_alive() {
+                for (auto it = _children.begin(); it != _children.end(); ++it) {
+                    int status;
+                    if (waitpid(*it, &status, WNOHANG) == *it) {
+                        _children.erase(it); //reaped, its pid may be reused
+                        kill_partitions();
+                        std::string what="The process of a partition ended unexpectedly";
+                        if (WIFSIGNALED(status)) {
+                            what += ", killed by signal " + std::to_string(WTERMSIG(status));
+                        }
+                        throw std::runtime_error(what);
+                    }
+                }
+            }
+
+            void fail(const char* what) noexcept {
+                int expected=0;
+                if (_control->failed.compare_exchange_strong(expected, 1)) {
+                    std::strncpy(_control->error, what, sizeof(_control->error) - 1);
+                    _control->error[sizeof(_control->error) - 1] = '\0';
+                }
+            }
+
+            //writes the messages of the ICs leaving partition I to their rings
+            template<std::size_t I, std::size_t K, bool LEAVING=(ic_from<K>::value == I)>
+            struct ic_sender {
+                template<typename ENGINE>
+                static void send(multiprocess_runner&, const ENGINE&) {}
+            };
+
+            template<std::size_t I, std::size_t K>
+            struct ic_sender<I, K, true> {
+                template<typename ENGINE>
+                static void send(multiprocess_runner& r, const ENGINE& engine) {
+                    const auto& messages=get_messages<typename ic<K>::from_model_output_port>(engine.outbox());
+                    if (!messages.empty()) {
+                        r.ring(K).push(messages);
+                    }
+                }
+            };
+
+            //reads the messages of the ICs arriving to partition I from their rings
+            template<std::size_t I, std::size_t K, bool ARRIVING=(ic_to<K>::value == I)>
+            struct ic_receiver {
+                static bool receive(multiprocess_runner&, partition_bags<I>&) {
+                    return false;
+                }
+            };
+
+            template<std::size_t I, std::size_t K>
+            struct ic_receiver<I, K, true> {
+                static bool receive(multiprocess_runner& r, partition_bags<I>& bags) {
+                    bool received=false;
+                    while (!r.ring(K).empty()) {
+                        r.ring(K).pop(get_messages<typename ic<K>::to_model_input_port>(bags));
+                        received = true;
+                    }
+                    return received;
+                }
+            };
+
+            template<std::size_t I, typename ENGINE, std::size_t... Ks>
+            void send_outputs(const ENGINE& engine, std::index_sequence<Ks...>) {
+                int expand[] = {0, (ic_sender<I, Ks>::send(*this, engine), 0)...};
+                (void)expand;
+            }
+
+            template<std::size_t I, std::size_t... Ks>
+            bool receive_inputs(partition_bags<I>& bags, std::index_sequence<Ks...>) {
+                bool received=false;
+                for (bool r : std::initializer_list<bool>{false, ic_receiver<I, Ks>::receive(*this, bags)...}) {
+                    received = received || r;
+                }
+                return received;
+            }
+
+            //the loop of the process of partition I, it never returns
+            template<std::size_t I>
+            [[noreturn]] static void run_partition(multiprocess_runner* r, const TIME* init_time) {
+                prctl(PR_SET_PDEATHSIG, SIGKILL); //do not outlive the runner
+                control_block& control=*r->_control;
+                bool failed=false;
+                auto guarded=[r, &failed](auto&& f) {
+                    if (failed) {
+                        return;
+                    }
+                    try {
+                        f();
+                    } catch (const std::exception& e) {
+                        r->fail(e.what());
+                        failed = true;
+                    } catch (...) {
+                        r->fail("Unknown exception in partition");
+                        failed = true;
+                    }
+                };
+
+                partition_engine<I> engine;
+                guarded([&]() {
+                    engine.init(*init_time);
+                    control.nexts[I] = engine.next();
+                });
+                arrive_and_wait(control, control.start);
+                while (true) {
+                    if (control.stop) {
+                        break;
+                    }
+                    TIME t=control.time;
+                    guarded([&]() {
+                        if (engine.next() == t) {
+                            engine.collect_outputs(t);
+                            r->send_outputs<I>(engine, std::make_index_sequence<ics_count>{});
+                        }
+                    });
+                    arrive_and_wait(control, control.exchanged);
+                    guarded([&]() {
+                        partition_bags<I> inbox;
+                        if (r->receive_inputs<I>(inbox, std::make_index_sequence<ics_count>{})) {
+                            engine.inbox(std::move(inbox));
+                        }
+                        engine.advance_simulation(t);
+                        control.nexts[I] = engine.next();
+                    });
+                    arrive_and_wait(control, control.start);
+                }
+                std::cout.flush();
+                std::cerr.flush();
+                _exit(failed ? EXIT_FAILURE : EXIT_SUCCESS);
+            }
+
+            template<std::size_t... Is>
+            void fork_partitions(const TIME& init_time, std::index_sequence<Is...>) {
+                using partition_main=void(*)(multiprocess_runner*, const TIME*);
+                constexpr partition_main mains[] = {&multiprocess_runner::run_partition<Is>...};
+                for (std::size_t i = 0; i < partitions_count; ++i) {
+                    pid_t pid=fork();
+                    if (pid == -1) {
+                        std::error_code ec(errno, std::generic_category());
+                        kill_partitions();
+                        throw std::system_error(ec, "Forking the process of a partition");
+                    } else if (pid == 0) {
+                        mains[i](this, &init_time);
+                    }
+                    _children.push_back(pid);
+                }
+            }
+
+            void kill_partitions() noexcept {
+                for (pid_t pid : _children) {
+                    kill(pid, SIGKILL);
+                    waitpid(pid, nullptr, 0);
+                }
+                _children.clear();
+                _running = false;
+            }
+
+            void stop_partitions() noexcept {
+                if (_running) {
+                    _control->stop = 1;
+                    post_phase(_control->start);
+                    for (pid_t pid : _children) {
+                        waitpid(pid, nullptr, 0);
+                    }
+                    _children.clear();
+                    _running = false;
+                }
+            }
+
+            void release_memory() noexcept {
+                if (_memory != MAP_FAILED) {
+                    sem_destroy(&_control->arrived);
+                    sem_destroy(&_control->start);
+                    sem_destroy(&_control->exchanged);
+                    munmap(_memory, _memory_size);
+                    _memory = MAP_FAILED;
+                }
+            }
+
+            //all the partitions reported their next, the lowest is next step
+            void read_nexts() {
+                if (_control->failed) {
+                    stop_partitions();
+                    throw std::runtime_error(_control->error);
+                }
+                _next = *std::min_element(_control->nexts.begin(), _control->nexts.end());
+            }
+
+            void setup(const TIME& init_time, std::size_t ring_capacity) {
+                _ring_size = (shared_memory_ring::bytes_for(ring_capacity) + 63) / 64 * 64;
+                _memory_size = ring_offset + ics_count * _ring_size;
+                _memory = mmap(nullptr, _memory_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+                if (_memory == MAP_FAILED) {
+                    throw std::system_error(errno, std::generic_category(), "Mapping the memory shared by partitions");
+                }
+                _control = new (_memory) control_block;
+                _control->stop = 0;
+                _control->failed = 0;
+                _control->error[0] = '\0';
+                sem_init(&_control->arrived, 1, 0);
+                sem_init(&_control->start, 1, 0);
+                sem_init(&_control->exchanged, 1, 0);
+                for (std::size_t k = 0; k < ics_count; ++k) {
+                    new (&ring(k)) shared_memory_ring(_ring_size - sizeof(shared_memory_ring));
+                }
+
+                std::cout.flush(); //buffered output would be written by every process
+                std::cerr.flush();
+                fork_partitions(init_time, std::make_index_sequence<partitions_count>{});
+                _running = true;
+                wait_arrivals();
+                read_nexts();
+            }
+
+        public:
+            static constexpr std::size_t default_ring_capacity=1 << 20;
+
+            /**
+             * @brief set the dynamic parameters for the simulation and starts the processes of the partitions
+             * @param init_time is the initial time of the simulation.
+             * @param ring_capacity is the size in bytes of the ring of each IC, it keeps the messages of a step
+             */
+            explicit multiprocess_runner(const TIME& init_time, std::size_t ring_capacity=default_ring_capacity) : _next(init_time) {
+                LOGGER::template log<cadmium::logger::logger_global_time, TIME>(init_time);
+                LOGGER::template log<cadmium::logger::logger_info, std::string>("Preparing model");
+                try {
+                    setup(init_time, ring_capacity);
+                } catch (...) {
+                    release_memory();
+                    throw;
+                }
+            }
+
+            multiprocess_runner(const multiprocess_runner&) = delete;
+            multiprocess_runner& operator=(const multiprocess_runner&) = delete;
+
+            ~multiprocess_runner() {
+                stop_partitions();
+                release_memory();
+            }
+
+            /**
+             * @brief runUntil runs the partitions in lockstep and stops when the next event is scheduled after t.
+             * @param t is the limit time for the simulation.
+             * @return the TIME of the next event to happen when simulation stopped.
+             */
+            TIME runUntil(const TIME& t) {
+                if (!_running) {
+                    throw std::domain_error("The processes of the partitions were stopped by a failure");
+                }
+                LOGGER::template log<cadmium::logger::logger_info, std::string>("Starting run");
+                while (_next < t) {
+                    LOGGER::template log<cadmium::logger::logger_global_time, TIME>(_next);
+                    _control->time = _next;
+                    post_phase(_control->start);
+                    wait_arrivals();
+                    post_phase(_control->exchanged);
+                    wait_arrivals();
+                    read_nexts();
+                }
+                LOGGER::template log<cadmium::logger::logger_info, std::string>("Finished run");
+                return _next;
+            }
+        };
+    }
+}
+
+#endif // CADMIUM_PDEVS_MULTIPROCESS_RUNNER_HPP
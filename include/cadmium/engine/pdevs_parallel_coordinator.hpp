@@ -0,0 +1,136 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CADMIUM_PDEVS_PARALLEL_COORDINATOR_HPP
+#define CADMIUM_PDEVS_PARALLEL_COORDINATOR_HPP
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include <cadmium/engine/pdevs_coordinator.hpp>
+#include <cadmium/engine/pdevs_fel.hpp>
+#include <cadmium/engine/task_scheduler.hpp>
+#include <cadmium/modeling/step_arena.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+namespace cadmium {
+    namespace engine {
+        /**
+         * @brief parallel_safe_logger tells if LOGGER can be called from several threads at the same time
+         * keeping a meaningful log. Only the not_logger is known to be safe, specialize it for other loggers.
+         */
+        template<typename LOGGER>
+        struct parallel_safe_logger : std::is_same<LOGGER, cadmium::logger::not_logger>{};
+
+        /**
+         * @brief parallel_dispatch runs the subengines involved in a step as tasks in a task_scheduler
+         *
+         * Every phase ends when all the subengines finished it, routing and scheduling are done by the calling
+         * thread between phases, so the results are the ones of the sequential_dispatch. The scheduler is the one
+         * given to the constructor, the one installed by the parent coordinator, or a new one with a thread per core.
+         * The coordinators of the coupled submodels are initialized with the scheduler installed, so all the levels
+         * share it and the threads idle in a small subtree steal the tasks of the busy ones.
+         *
+         * The subengines are run sequentially in the calling thread when the logger is not parallel safe, so logs
+         * keep their order, and no scheduler is taken. They are also run sequentially in the steps run with a
+         * step_arena installed when some of them has ports using arena_vector_bag_policy, since arenas are used
+         * from one thread. Other bags never take memory from arenas.
+         */
+        template<typename LOGGER>
+        class parallel_dispatch {
+            static constexpr bool parallel_logger=parallel_safe_logger<LOGGER>::value;
+
+            std::unique_ptr<task_scheduler> _own_scheduler; //only set if no scheduler was provided
+            task_scheduler* _scheduler=nullptr;
+
+            void take_scheduler() {
+                if (!_scheduler) {
+                    _scheduler = current_task_scheduler();
+                }
+                if (!_scheduler) {
+                    _own_scheduler.reset(new task_scheduler());
+                    _scheduler = _own_scheduler.get();
+                }
+            }
+
+        public:
+            parallel_dispatch() = default;
+
+            /**
+             * @brief runs the subengines in a scheduler of its own
+             * @param threads is the size of the scheduler, including the thread running the coordinator
+             */
+            parallel_dispatch(std::size_t threads) : _own_scheduler(new task_scheduler(threads)), _scheduler(_own_scheduler.get()) {}
+
+            /**
+             * @brief runs the subengines in a scheduler shared with other engines
+             */
+            parallel_dispatch(task_scheduler& scheduler) noexcept : _scheduler(&scheduler) {}
+
+            template<typename F>
+            void initializing(F&& f) {
+                if (!parallel_logger) { //the subengines will be run in the calling thread
+                    f();
+                    return;
+                }
+                take_scheduler();
+                task_scheduler* previous = current_task_scheduler();
+                current_task_scheduler() = _scheduler;
+                try {
+                    f();
+                } catch (...) {
+                    current_task_scheduler() = previous;
+                    throw;
+                }
+                current_task_scheduler() = previous;
+            }
+
+            template<bool ARENA, typename F>
+            void for_each(const std::vector<std::size_t>& engines, F&& f) {
+                if (parallel_logger && !(ARENA && cadmium::current_step_arena() != nullptr)) {
+                    _scheduler->for_each_index(engines.size(), [&engines, &f](std::size_t i) { f(engines[i]); });
+                } else {
+                    for (auto e : engines) {
+                        f(e);
+                    }
+                }
+            }
+        };
+
+        /**
+         * @brief The parallel_coordinator runs a PDEVS coupled model advancing its submodels in parallel
+         *
+         * It is the basic_coordinator using parallel_dispatch, constructing it from a number of threads or a
+         * task_scheduler sets the scheduler of the dispatch. Models must not share mutable data between them.
+         */
+        template<template<typename T> class MODEL, typename TIME, typename LOGGER, template<typename> class FEL=heap_fel>
+        using parallel_coordinator=basic_coordinator<MODEL, TIME, LOGGER, FEL, parallel_dispatch<LOGGER>>;
+    }
+}
+
+#endif // CADMIUM_PDEVS_PARALLEL_COORDINATOR_HPP
@@ -0,0 +1,97 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CADMIUM_PDEVS_PROCESS_BRANCH_HPP
+#define CADMIUM_PDEVS_PROCESS_BRANCH_HPP
+
+#include <cerrno>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * Branches of a simulation run in child processes
+ *
+ * The child process starts as a copy on write image of the parent, so creating a branch costs the same
+ * no matter how large the state of the simulation is, and only the pages a branch modifies are copied.
+ * Branches report their results through files, pipes or shared memory, as they share nothing with the parent.
+ * Only threads calling fork exist in the child, runners using the parallel_coordinator can not be branched
+ * this way, runner::fork creates in process branches for them.
+ */
+namespace cadmium {
+    namespace engine {
+        /**
+         * @brief fork_process_branch runs branch(r) in a child process continuing from the current state of r
+         * @param r is the runner to branch, it is not modified in the parent
+         * @param branch is called in the child with the copy of the runner, the child exits when it returns,
+         * with failure status if it throws.
+         * @return the process id of the branch, for waiting it with wait_process_branch
+         */
+        template<typename RUNNER, typename BRANCH>
+        pid_t fork_process_branch(RUNNER& r, BRANCH&& branch) {
+            std::cout.flush(); //buffered output would be written by every process
+            std::cerr.flush();
+            pid_t pid = fork();
+            if (pid < 0) {
+                throw std::system_error(errno, std::generic_category(), "Failed to fork a simulation branch");
+            } else if (pid == 0) {
+                bool failed = false;
+                try {
+                    branch(r);
+                } catch (...) {
+                    failed = true;
+                }
+                std::cout.flush();
+                std::cerr.flush();
+                _exit(failed ? EXIT_FAILURE : EXIT_SUCCESS);
+            }
+            return pid;
+        }
+
+        /**
+         * @brief wait_process_branch waits for a branch to finish
+         * @throw std::runtime_error if the branch failed
+         */
+        inline void wait_process_branch(pid_t pid) {
+            int status;
+            while (waitpid(pid, &status, 0) < 0) {
+                if (errno != EINTR) {
+                    throw std::system_error(errno, std::generic_category(), "Failed to wait a simulation branch");
+                }
+            }
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+                throw std::runtime_error("The simulation branch failed");
+            }
+        }
+    }
+}
+
+#endif // CADMIUM_PDEVS_PROCESS_BRANCH_HPP
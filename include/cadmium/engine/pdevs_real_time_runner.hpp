@@ -0,0 +1,273 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CADMIUM_PDEVS_REAL_TIME_RUNNER_HPP
+#define CADMIUM_PDEVS_REAL_TIME_RUNNER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <initializer_list>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include <cadmium/engine/pdevs_runner.hpp>
+
+/**
+ * Real time runner, the simulation advances with the wall clock
+ *
+ * Each step waits until the wall clock reaches the time of the step. The runner sleeps until shortly before
+ * the deadline and spins the rest of the wait, as waking from a sleep takes longer than the precision wanted.
+ * Events posted from other threads are handed to the runner through its lock-free queue, stamped with the
+ * simulated time matching the wall clock when they are posted.
+ */
+namespace cadmium {
+    namespace engine {
+        /**
+         * @brief real_time_stats tells how late the steps were run compared to their deadline on the wall clock
+         */
+        struct real_time_stats {
+            std::size_t steps=0;
+            std::size_t missed=0; //steps run later than the tolerance
+            std::chrono::nanoseconds max_lateness{0};
+            std::chrono::nanoseconds total_lateness{0};
+
+            std::chrono::nanoseconds mean_lateness() const noexcept {
+                return steps == 0 ? std::chrono::nanoseconds{0} : total_lateness / static_cast<std::chrono::nanoseconds::rep>(steps);
+            }
+        };
+
+        /**
+         * @brief real_time_runner runs a model synchronized to the wall clock
+         *
+         * @param TIME is the time used by the model, it is converted to and from seconds with static_cast to double
+         * and the other template parameters are the ones of the runner.
+         */
+        template <class TIME, template<class> class MODEL, typename LOGGER=default_logger, template<typename> class FEL=heap_fel,
+                  template<template<typename> class, typename, typename, template<typename> class> class ENGINE=coordinator>
+        class real_time_runner {
+        public:
+            using runner_type=runner<TIME, MODEL, LOGGER, FEL, ENGINE>;
+            using clock=std::chrono::steady_clock;
+
+        private:
+            runner_type _runner;
+            double _seconds_per_unit;
+            clock::duration _tolerance;
+            clock::duration _spin;
+            TIME _last; //time of the last step run
+
+            //the wall clock time matching a simulated time, set when each run starts
+            clock::time_point _wall_origin;
+            TIME _sim_origin;
+            //copies of the origin read by the threads posting events, the wall origin is not_running between runs
+            static constexpr clock::rep not_running=std::numeric_limits<clock::rep>::min();
+            std::atomic<clock::rep> _posting_wall_origin{not_running};
+            std::atomic<double> _posting_sim_origin{0.0};
+
+            std::mutex _mutex; //only guards the waits on _cv, posted events go through the queue of the runner
+            std::condition_variable _cv;
+            std::atomic<bool> _interrupted{false}; //events were posted or stop was called, read while spinning
+            bool _stopping=false;
+            real_time_stats _stats;
+
+            clock::time_point deadline(const TIME& t) const {
+                if (t == std::numeric_limits<TIME>::infinity()) {
+                    return clock::time_point::max();
+                }
+                std::chrono::duration<double> wait((static_cast<double>(t) - static_cast<double>(_sim_origin)) * _seconds_per_unit);
+                return _wall_origin + std::chrono::duration_cast<clock::duration>(wait);
+            }
+
+            //the simulated time matching the wall clock, it is called from the threads posting events. Events posted
+            //between runs are stamped with the lowest time, the runner receives them right away in the next run.
+            TIME posting_time() const {
+                clock::rep origin = _posting_wall_origin.load(std::memory_order_acquire);
+                if (origin == not_running) {
+                    return std::numeric_limits<TIME>::lowest();
+                }
+                std::chrono::duration<double> elapsed = clock::now() - clock::time_point(clock::duration(origin));
+                return static_cast<TIME>(_posting_sim_origin.load(std::memory_order_relaxed) + elapsed.count() / _seconds_per_unit);
+            }
+
+            //wakes the running runUntil, the flag is set under the lock to not miss a wait starting
+            void interrupt() {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _interrupted.store(true);
+                }
+                _cv.notify_one();
+            }
+
+            //waits for the wall clock to reach the deadline, it returns false if interrupted before
+            bool wait_until(clock::time_point deadline) {
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    if (deadline == clock::time_point::max()) {
+                        _cv.wait(lock, [this]() { return _interrupted.load(); });
+                        return false;
+                    }
+                    clock::time_point wake = deadline - _spin;
+                    while (!_interrupted.load() && clock::now() < wake) {
+                        _cv.wait_until(lock, wake);
+                    }
+                }
+                while (!_interrupted.load(std::memory_order_relaxed)) {
+                    if (clock::now() >= deadline) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            void record_lateness(clock::time_point deadline) {
+                auto lateness = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - deadline);
+                ++_stats.steps;
+                _stats.total_lateness += lateness;
+                _stats.max_lateness = std::max(_stats.max_lateness, lateness);
+                if (lateness > _tolerance) {
+                    ++_stats.missed;
+                }
+            }
+
+            //clears the interruption, the posted events are taken by the runner in its next step,
+            //it returns false if stop was called
+            bool take_interruption() {
+                std::lock_guard<std::mutex> lock(_mutex);
+                bool stopping = _stopping;
+                _stopping = false;
+                _interrupted.store(false);
+                return !stopping;
+            }
+
+        public:
+            /**
+             * @brief real_time_runner prepares the model as the runner does
+             * @param init_time is the initial time of the simulation
+             * @param seconds_per_unit is the wall clock seconds a unit of simulated time takes
+             * @param tolerance is the lateness for counting a step as a missed deadline
+             * @param spin is how long before the deadline the runner stops sleeping and spins
+             */
+            explicit real_time_runner(const TIME& init_time, double seconds_per_unit=1.0,
+                                      clock::duration tolerance=std::chrono::microseconds(100),
+                                      clock::duration spin=std::chrono::microseconds(200))
+            : _runner(init_time), _seconds_per_unit(seconds_per_unit), _tolerance(tolerance), _spin(spin),
+              _last(init_time), _sim_origin(init_time) {}
+
+            real_time_runner(const real_time_runner&) = delete;
+            real_time_runner& operator=(const real_time_runner&) = delete;
+
+            /**
+             * @brief post sends messages to an input port of the top model from any thread through runner::post,
+             * they are received at the simulated time matching the moment they are posted, or right away in the
+             * next run if posted between runs.
+             */
+            template<typename PORT, typename MESSAGES>
+            void post(const MESSAGES& messages) {
+                _runner.template post<PORT>(posting_time(), messages);
+                interrupt();
+            }
+
+            template<typename PORT>
+            void post(std::initializer_list<typename PORT::message_type> messages) {
+                post<PORT, std::initializer_list<typename PORT::message_type>>(messages);
+            }
+
+            /**
+             * @brief stop makes the running runUntil return, it can be called from any thread
+             */
+            void stop() {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _stopping = true;
+                }
+                interrupt();
+            }
+
+            /**
+             * @brief stats tells the lateness of the steps run so far
+             */
+            const real_time_stats& stats() const noexcept {
+                return _stats;
+            }
+
+            /**
+             * @brief runUntil runs the simulation on the wall clock until the next event is scheduled after t,
+             * or stop is called. Passive models wait for posted events until t.
+             * The wall clock is matched to the time of the last step when the run starts.
+             * @return the TIME of the next event to happen when simulation stopped.
+             */
+            TIME runUntil(const TIME& t) {
+                return runUntil(t, [](const TIME&, const auto&) {});
+            }
+
+            /**
+             * @brief runUntil runs as above, handing the outputs of the top model to on_output as they are produced
+             */
+            template<typename OUTPUT_HANDLER>
+            TIME runUntil(const TIME& t, OUTPUT_HANDLER&& on_output) {
+                LOGGER::template log<cadmium::logger::logger_info, std::string>("Starting real time run");
+                _wall_origin = clock::now();
+                _sim_origin = _last;
+                _posting_sim_origin.store(static_cast<double>(_sim_origin), std::memory_order_relaxed);
+                _posting_wall_origin.store(_wall_origin.time_since_epoch().count(), std::memory_order_release);
+                TIME next = _last;
+                while (true) {
+                    bool reached = false;
+                    next = _runner.runWhile([this, &t, &reached](const TIME& step) {
+                        if (!(step < t)) {
+                            reached = true;
+                            return false;
+                        }
+                        clock::time_point d = deadline(step);
+                        if (!wait_until(d)) {
+                            return false;
+                        }
+                        record_lateness(d);
+                        _last = step;
+                        return true;
+                    }, on_output);
+                    //passive models wait for the events posted until t
+                    if (!_interrupted.load() && (reached || wait_until(deadline(t)))) {
+                        break;
+                    }
+                    if (!take_interruption()) {
+                        break;
+                    }
+                }
+                _posting_wall_origin.store(not_running, std::memory_order_release);
+                LOGGER::template log<cadmium::logger::logger_info, std::string>("Finished real time run");
+                return next;
+            }
+        };
+    }
+}
+
+#endif // CADMIUM_PDEVS_REAL_TIME_RUNNER_HPP
@@ -26,9 +26,25 @@
 
 #ifndef CADMIUM_PDEVS_RUNNER_HPP
 #define CADMIUM_PDEVS_RUNNER_HPP
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <type_traits>
+#include <boost/type_index.hpp>
 #include <cadmium/engine/pdevs_coordinator.hpp>
+#include <cadmium/engine/pdevs_flat_coordinator.hpp>
+#include <cadmium/engine/pdevs_parallel_coordinator.hpp>
+#include <cadmium/engine/mpsc_queue.hpp>
+#include <cadmium/engine/event_trace.hpp>
+#include <cadmium/modeling/step_arena.hpp>
+#include <cadmium/modeling/checkpoint.hpp>
 #include <cadmium/concept/atomic_model_assert.hpp>
+#include <cadmium/concept/concept_helpers.hpp>
 #include <cadmium/logger/logger.hpp>
 #include <cadmium/logger/common_loggers.hpp>
 
@@ -41,21 +57,153 @@ namespace cadmium {
          * conditions, the ending conditions and the loggers, then it runs the simulation and
          * displays the results.
          *
-         * @param Model The model to be simulated
+         * @param Model The model to be simulated, atomic models are run by a simulator with no coordinator on top
          * @param Time Representation of time to be used to run the simualtion
          * @param Logger what, where and how to log from the simulation
+         * @param FEL the future event list used by the coordinators for scheduling their submodels
+         * @param ENGINE the engine running the top model, coordinator, flat_coordinator or parallel_coordinator,
+         * not used when the model is atomic. parallel_coordinator runs the submodels in parallel only with a parallel
+         * safe Logger, such as not_logger, see parallel_safe_logger. With the default logger it runs them sequentially.
+         *
+         * Optionally, the messages created in each step for ports using arena_vector_bag_policy can be allocated
+         * from an arena owned by the runner and released all together at the end of the step, see use_step_arena.
+         *
+         * Messages can be injected in the input ports of the top model, and a runner can be forked into
+         * branches continuing from its current time, for exploring alternatives without simulating the
+         * common prefix again.
          */
 
         //by default state changes get verbatim formatted and logged to cout
         using default_logger=cadmium::logger::logger<cadmium::logger::logger_state, cadmium::logger::verbatim_formatter, cadmium::logger::cout_sink_provider>;
 
-        //TODO: migrate specialization FEL behavior from CDBoost. At this point, there is no parametrized FEL.
-        template <class TIME, template<class> class MODEL, typename LOGGER=default_logger>
+        template <class TIME, template<class> class MODEL, typename LOGGER=default_logger, template<typename> class FEL=heap_fel,
+                  template<template<typename> class, typename, typename, template<typename> class> class ENGINE=coordinator>
         class runner{
+            template<typename L>
+            using engine_logging_to=typename std::conditional<cadmium::concept::is_atomic<MODEL>::value(),
+                                                              simulator<MODEL, TIME, L>,
+                                                              ENGINE<MODEL, TIME, L, FEL>>::type;
+            using engine_type=engine_logging_to<LOGGER>;
+            using in_bags_type=typename make_message_bags<typename MODEL<TIME>::input_ports>::type;
+
+        public:
+            using output_bags_type=typename make_message_bags<typename MODEL<TIME>::output_ports>::type;
+            using output_sink=std::function<void(const TIME&, const output_bags_type&)>;
+
+        private:
+
+            struct posted_input {
+                TIME time;
+                in_bags_type bags;
+            };
+
+            TIME _last; //time of the last step run
             TIME _next; //next scheduled event
 
-            //TODO: handle the case that the model received is an atomic model.
-            cadmium::engine::coordinator<MODEL, TIME, LOGGER> top_coordinator; //this only works for coupled models.
+            engine_type top_coordinator; //a simulator when the model is atomic
+            std::unique_ptr<cadmium::step_arena> _own_arena;
+            cadmium::step_arena* _arena=nullptr; //memory for the messages of a step, nullptr uses the heap
+            std::map<TIME, in_bags_type> _injected; //inputs for the top model waiting for their time
+            std::unique_ptr<mpsc_queue<posted_input>> _posted{new mpsc_queue<posted_input>()}; //inputs sent by other threads
+            trace_reader<TIME, typename MODEL<TIME>::input_ports>* _trace=nullptr; //trace replayed, not owned
+            output_sink _sink; //receives the outputs of the runs not given a handler
+
+            static constexpr char checkpoint_magic[8]={'C', 'D', 'M', 'C', 'K', 'P', 'T', '1'};
+
+            //the model and the engine tree saved, the same for any logger
+            static std::string checkpoint_signature() {
+                return boost::typeindex::type_id<engine_logging_to<cadmium::logger::not_logger>>().pretty_name();
+            }
+
+            //handler of the runs not given one
+            struct sink_outputs {
+                runner* r;
+
+                template<typename BAGS>
+                void operator()(const TIME& t, const BAGS& bags) const {
+                    if (r->_sink) {
+                        r->_sink(t, bags);
+                    }
+                }
+            };
+
+            //engines without copy, as the ones owning threads, are copied through a checkpoint
+            static void copy_engine(const engine_type& from, engine_type& to, std::true_type) {
+                to = from;
+            }
+
+            static void copy_engine(const engine_type& from, engine_type& to, std::false_type) {
+                std::stringstream ss;
+                cadmium::checkpoint_writer w(ss);
+                from.save(w);
+                cadmium::checkpoint_reader r(ss);
+                to.load(r);
+            }
+
+            struct branch_tag {};
+
+            static bool passive(const TIME& t) {
+                return t == std::numeric_limits<TIME>::infinity();
+            }
+
+            //inputs posted from other threads join the injected ones, the late ones are received right away
+            void take_posted_inputs() {
+                posted_input input;
+                while (_posted->pop(input)) {
+                    TIME t = input.time < _last ? _last : input.time;
+                    cadmium::append_message_bags(_injected[t], input.bags);
+                }
+            }
+
+            //runs steps while keep_running(time of the step, steps run) holds, the modes of running only differ on it
+            template<typename KEEP_RUNNING, typename OUTPUT_HANDLER>
+            TIME run_steps(KEEP_RUNNING&& keep_running, OUTPUT_HANDLER&& on_output) {
+                LOGGER::template log<cadmium::logger::logger_info, std::string>("Starting run");
+                for (std::size_t done = 0; ; ++done) {
+                    take_posted_inputs();
+                    //steps happen at the next event of the model, injected input or record of the trace replayed
+                    TIME step = _next;
+                    if (!_injected.empty() && _injected.begin()->first < step) {
+                        step = _injected.begin()->first;
+                    }
+                    bool has_trace = _trace && !_trace->done();
+                    TIME trace_time = has_trace && _last < _trace->next_time() ? _trace->next_time() : _last;
+                    if (has_trace && trace_time < step) {
+                        step = trace_time;
+                    }
+                    bool has_input = !_injected.empty() && !(step < _injected.begin()->first);
+                    has_trace = has_trace && !(step < trace_time);
+                    if (!keep_running(step, done)) {
+                        break;
+                    }
+                    LOGGER::template log<cadmium::logger::logger_global_time, TIME>(step);
+                    cadmium::step_arena_scope step_scope(_arena);
+                    top_coordinator.collect_outputs(step);
+                    if (top_coordinator._outbox_dirty.any()) {
+                        on_output(step, top_coordinator.outbox());
+                    }
+                    if (has_input) {
+                        top_coordinator.inbox(std::move(_injected.begin()->second));
+                        _injected.erase(_injected.begin());
+                    }
+                    if (has_trace) {
+                        //the records are read straight into the inbox of the top model
+                        _trace->read_step(top_coordinator._inbox);
+                        top_coordinator._inbox_dirty = cadmium::non_empty_ports(top_coordinator._inbox);
+                    }
+                    top_coordinator.advance_simulation(step);
+                    _last = step;
+                    _next = top_coordinator.next();
+                }
+                LOGGER::template log<cadmium::logger::logger_info, std::string>("Finished run");
+                return _next;
+            }
+
+            runner(const runner& other, branch_tag)
+            : _last(other._last), _next(other._next), _injected(other._injected) { //the trace and the sink are not shared
+                LOGGER::template log<cadmium::logger::logger_info, std::string>("Forking model");
+                copy_engine(other.top_coordinator, top_coordinator, std::is_copy_assignable<engine_type>{});
+            }
 
         public:
             //contructors
@@ -63,44 +211,224 @@ namespace cadmium {
              * @brief set the dynamic parameters for the simulation
              * @param init_time is the initial time of the simulation.
              */
-            explicit runner(const TIME& init_time){
+            explicit runner(const TIME& init_time) : _last(init_time) {
                 LOGGER::template log<cadmium::logger::logger_global_time, TIME>(init_time);
                 LOGGER::template log<cadmium::logger::logger_info, std::string>("Preparing model");
                 top_coordinator.init(init_time);
                 _next = top_coordinator.next();
             }
 
+            /**
+             * @brief restores a simulation from a snapshot written by save
+             * The runner is rebuilt with the same state and time of the saved runner, the runner type must be the same.
+             * @param snapshot is the binary stream the snapshot is read from
+             * @throw std::domain_error if the snapshot is from another model or engine, or it is truncated
+             */
+            explicit runner(std::istream& snapshot){
+                LOGGER::template log<cadmium::logger::logger_info, std::string>("Restoring model");
+                cadmium::checkpoint_reader r(snapshot);
+                char magic[sizeof(checkpoint_magic)];
+                r.read_bytes(magic, sizeof(magic));
+                std::string signature;
+                r.read(signature);
+                if (std::memcmp(magic, checkpoint_magic, sizeof(magic)) != 0 || signature != checkpoint_signature()) {
+                    throw std::domain_error("The checkpoint was not saved by a runner of this model and engine");
+                }
+                top_coordinator.load(r);
+                r.read(_last);
+                std::uint64_t injected;
+                r.read(injected);
+                for (std::uint64_t i = 0; i < injected; ++i) {
+                    TIME t;
+                    r.read(t);
+                    r.read(_injected[t]);
+                }
+                _next = top_coordinator.next();
+            }
+
+            /**
+             * @brief save writes a binary snapshot of the simulation: the state, last and next times and pending
+             * messages of every engine, and the injected inputs not received yet. The inputs posted from other
+             * threads are saved once taken by a step. The model states need to be serializable, see checkpoint_serializer.
+             * @param snapshot is the binary stream the snapshot is written to
+             */
+            void save(std::ostream& snapshot) const {
+                cadmium::checkpoint_writer w(snapshot);
+                w.write_bytes(checkpoint_magic, sizeof(checkpoint_magic));
+                w.write(checkpoint_signature());
+                top_coordinator.save(w);
+                w.write(_last);
+                w.write(static_cast<std::uint64_t>(_injected.size()));
+                for (const auto& input : _injected) {
+                    w.write(input.first);
+                    w.write(input.second);
+                }
+            }
+
+            /**
+             * @brief fork creates a branch of the simulation: a runner continuing from the current time with
+             * a copy of the state of every model, the injected inputs not consumed yet included.
+             * The branch and the original can run and receive inputs independently from there.
+             * The branch takes the memory for the messages from the heap until use_step_arena is called on it.
+             */
+            runner fork() const {
+                return runner(*this, branch_tag{});
+            }
+
+            /**
+             * @brief inject introduces messages in an input port of the top model, they are received at time t
+             * by the models connected to the port. Injecting at the same time many times adds up the messages.
+             * @param t is the time of the input, it can not be before the last event processed.
+             * @param messages are the messages for the port
+             */
+            template<typename PORT, typename MESSAGES>
+            void inject(const TIME& t, const MESSAGES& messages) {
+                auto& bag = cadmium::get_messages<PORT>(_injected[t]);
+                for (const auto& m : messages) {
+                    bag.push_back(m);
+                }
+            }
+
+            template<typename PORT>
+            void inject(const TIME& t, std::initializer_list<typename PORT::message_type> messages) {
+                inject<PORT, std::initializer_list<typename PORT::message_type>>(t, messages);
+            }
+
+            /**
+             * @brief replay feeds the records of a trace to the input ports of the top model as the simulation reaches
+             * their times, records before the last step run are received right away. The trace is read as it is
+             * needed, it must outlive the runs and it is not copied by fork or saved by save.
+             */
+            void replay(trace_reader<TIME, typename MODEL<TIME>::input_ports>& trace) noexcept {
+                _trace = &trace;
+            }
+
+            /**
+             * @brief output_to makes the runs not given a handler hand the messages in the output ports of the top
+             * model to sink, as sink(time, bags) for each step with outputs. The bags are only valid during the call.
+             * The sink is not copied by fork, so branches do not write to the same destination.
+             */
+            void output_to(output_sink sink) {
+                _sink = std::move(sink);
+            }
+
+            /**
+             * @brief output_to writes the outputs of the runs not given a handler to a binary trace, the writer
+             * must outlive the runs.
+             */
+            void output_to(trace_writer<TIME, typename MODEL<TIME>::output_ports>& writer) {
+                _sink = [&writer](const TIME& t, const output_bags_type& bags) {
+                    writer.write_bags(t, bags);
+                };
+            }
+
+            /**
+             * @brief post sends messages to an input port of the top model from any thread, while the runner is
+             * running in another one. The messages are taken at the start of the next step, without locks, and
+             * received at time t, or right away if the simulation is past t by then.
+             */
+            template<typename PORT, typename MESSAGES>
+            void post(const TIME& t, const MESSAGES& messages) {
+                posted_input input{t, in_bags_type{}};
+                auto& bag = cadmium::get_messages<PORT>(input.bags);
+                for (const auto& m : messages) {
+                    bag.push_back(m);
+                }
+                _posted->push(std::move(input));
+            }
+
+            template<typename PORT>
+            void post(const TIME& t, std::initializer_list<typename PORT::message_type> messages) {
+                post<PORT, std::initializer_list<typename PORT::message_type>>(t, messages);
+            }
+
+            /**
+             * @brief use_step_arena makes the bags of ports using arena_vector_bag_policy created in each step take
+             * their memory from an arena that is released at the end of the step, after a few steps no more memory
+             * is requested to the system. Models must not keep those bags in their state, copies of them are safe.
+             * @param chunk_size is the size in bytes of the blocks reserved by the arena
+             */
+            void use_step_arena(std::size_t chunk_size=cadmium::step_arena::default_chunk_size) {
+                _own_arena.reset(new cadmium::step_arena(chunk_size));
+                _arena = _own_arena.get();
+            }
+
+            /**
+             * @brief use_step_arena takes the memory of the steps from an arena owned by the caller, which must
+             * outlive the runs, so many runners run in the same thread can share it.
+             */
+            void use_step_arena(cadmium::step_arena& arena) noexcept {
+                _own_arena.reset();
+                _arena = &arena;
+            }
+
             /**
              * @brief runUntil starts the simulation and stops when the next event is scheduled after t.
              * @param t is the limit time for the simulation.
              * @return the TIME of the next event to happen when simulation stopped.
              */
             TIME runUntil(const TIME& t) {
-                LOGGER::template log<cadmium::logger::logger_info, std::string>("Starting run");
-                while (_next < t){
-                    LOGGER::template log<cadmium::logger::logger_global_time, TIME>(_next);
-                    top_coordinator.collect_outputs(_next);
-                    top_coordinator.advance_simulation(_next);
-                    _next = top_coordinator.next();
-                }
-                LOGGER::template log<cadmium::logger::logger_info, std::string>("Finished run");
-                return _next;
+                return runUntil(t, sink_outputs{this});
             }
 
             /**
-             * @brief runUntilPassivate starts the simulation and stops when there is no next internal event to happen.
+             * @brief runUntil runs as above, handing the messages in the output ports of the top model to on_output
+             * instead of the sink set by output_to.
+             * @param on_output is called as on_output(time, bags) for each step with outputs, the bags are only
+             * valid during the call.
              */
-            void runUntilPassivate() {
-                LOGGER::template log<cadmium::logger::logger_info, std::string>("Starting run");
-                while ( _next !=  std::numeric_limits<TIME>::infinity )
-                {
-                    LOGGER::template log<cadmium::logger::logger_global_time, TIME>(_next);
-                    top_coordinator.advanceSimulation( _next);
-                    _next = top_coordinator.next();
-                }
-                LOGGER::template log<cadmium::logger::logger_info, std::string>("Finished run");
+            template<typename OUTPUT_HANDLER>
+            TIME runUntil(const TIME& t, OUTPUT_HANDLER&& on_output) {
+                return run_steps([&t](const TIME& step, std::size_t) { return step < t; }, on_output);
+            }
+
+            /**
+             * @brief runUntilPassivate runs the simulation until no more events are scheduled and no injected
+             * inputs are waiting, models with a never ending activity keep it running forever.
+             * @return the TIME of the next event, infinity
+             */
+            TIME runUntilPassivate() {
+                return runUntilPassivate(sink_outputs{this});
+            }
+
+            template<typename OUTPUT_HANDLER>
+            TIME runUntilPassivate(OUTPUT_HANDLER&& on_output) {
+                return run_steps([](const TIME& step, std::size_t) { return !passive(step); }, on_output);
+            }
+
+            /**
+             * @brief runFor runs n_events steps of the simulation, or less if it passivates before.
+             * A step processes all the events scheduled at the same time, the injected inputs included.
+             * @return the TIME of the next event to happen when simulation stopped.
+             */
+            TIME runFor(std::size_t n_events) {
+                return runFor(n_events, sink_outputs{this});
+            }
+
+            template<typename OUTPUT_HANDLER>
+            TIME runFor(std::size_t n_events, OUTPUT_HANDLER&& on_output) {
+                return run_steps([n_events](const TIME& step, std::size_t done) { return done < n_events && !passive(step); }, on_output);
+            }
+
+            /**
+             * @brief runWhile runs the simulation while predicate(t) holds for the time t of the next step,
+             * the step making it false is not run. The simulation stops when it passivates too.
+             * @return the TIME of the next event to happen when simulation stopped.
+             */
+            template<typename PREDICATE>
+            TIME runWhile(PREDICATE&& predicate) {
+                return runWhile(predicate, sink_outputs{this});
+            }
+
+            template<typename PREDICATE, typename OUTPUT_HANDLER>
+            TIME runWhile(PREDICATE&& predicate, OUTPUT_HANDLER&& on_output) {
+                return run_steps([&predicate](const TIME& step, std::size_t) { return !passive(step) && predicate(step); }, on_output);
             }
         };
+
+        template <class TIME, template<class> class MODEL, typename LOGGER, template<typename> class FEL,
+                  template<template<typename> class, typename, typename, template<typename> class> class ENGINE>
+        constexpr char runner<TIME, MODEL, LOGGER, FEL, ENGINE>::checkpoint_magic[8];
     }
 }
 
@@ -56,9 +56,13 @@ namespace cadmium {
             //TODO: set boxes back to private
             in_bags_type _inbox;
             out_bags_type _outbox;
+            port_mask<in_bags_type> _inbox_dirty; //non empty ports in the inbox, set by whoever fills the inbox
+            port_mask<out_bags_type> _outbox_dirty; //non empty ports in the outbox
 
         public:
             using model_type=MODEL<TIME>;
+            //the boxes take memory from the step arena when installed
+            static constexpr bool uses_step_arena=bags_use_step_arena<in_bags_type>::value || bags_use_step_arena<out_bags_type>::value;
 
             /**
              * @brief simulator constructs by default
@@ -94,6 +98,27 @@ namespace cadmium {
                 return _next;
             }
 
+            /**
+             * @brief imminent tells if the model has an internal transition scheduled at t
+             */
+            bool imminent(const TIME& t) const noexcept{
+                return _next == t;
+            }
+
+            /**
+             * @brief has_pending_input tells if messages were introduced in the inbox for next advance_simulation
+             */
+            bool has_pending_input() const noexcept{
+                return _inbox_dirty.any();
+            }
+
+            /**
+             * @brief active tells if advancing the simulation to t would run a transition, otherwise it is a nop
+             */
+            bool active(const TIME& t) const noexcept{
+                return imminent(t) || has_pending_input();
+            }
+
             void collect_outputs(const TIME &t) {
                 auto log_info_collect = [](TIME t) -> std::string {
                      std::ostringstream oss;
@@ -108,9 +133,14 @@ namespace cadmium {
                 if (_next < t){
                     throw std::domain_error("Trying to obtain output when not internal event is scheduled");
                 } else if (_next == t) {
-                    _outbox = _model.output();
+                    //the output is moved into the bags of the outbox, keeping the memory they retained in last reset
+                    cadmium::reset_message_bags(_outbox);
+                    out_bags_type output = _model.output();
+                    cadmium::append_message_bags(_outbox, output);
+                    _outbox_dirty = cadmium::non_empty_ports(_outbox);
                 } else {
-                    _outbox = out_bags_type();
+                    cadmium::reset_message_bags(_outbox);
+                    _outbox_dirty.reset();
                 }
 
                 auto log_messages_collect = [](const out_bags_type& ob) -> std::string {
@@ -127,7 +157,7 @@ namespace cadmium {
             /**
              * @brief outbox keeps the output generated by the last call to collect_outputs
              */
-            out_bags_type outbox() const noexcept{
+            const out_bags_type& outbox() const noexcept{
                 return _outbox;
             }
 
@@ -135,8 +165,11 @@ namespace cadmium {
             /**
              * @brief inbox keeps the input introduced by upper level coordinator for running next advance_simulation
              */
-            void inbox(in_bags_type in) noexcept{
-                _inbox=in;
+            void inbox(in_bags_type in) {
+                //messages are moved into the bags of the inbox, keeping the memory they retained in last reset
+                cadmium::reset_message_bags(_inbox);
+                cadmium::append_message_bags(_inbox, in);
+                _inbox_dirty=cadmium::non_empty_ports(_inbox);
             }
 
             /**
@@ -154,6 +187,15 @@ namespace cadmium {
                      oss << to;
                      return oss.str();
                 };
+                if (t < _last) {
+                    throw std::domain_error("Event received for executing in the past of current simulation time");
+                } else if (_next < t) {
+                    throw std::domain_error("Event received for executing after next internal event");
+                } else if (!active(t)) {
+                    //no transition at t, just a nop is enough. And no _next or _last should be changed.
+                    return;
+                }
+
                 LOGGER::template log<cadmium::logger::logger_info, decltype(log_info_advance), TIME>(log_info_advance, _last, t);
 
                 auto log_local_time = [](const TIME& from, const TIME& to) -> std::string {
@@ -167,33 +209,22 @@ namespace cadmium {
                 };
                 LOGGER::template log<cadmium::logger::logger_local_time, decltype(log_local_time), TIME>(log_local_time, _last, t);
 
-                if (t < _last) {
-                    throw std::domain_error("Event received for executing in the past of current simulation time");
-                } else if (_next < t) {
-                    throw std::domain_error("Event received for executing after next internal event");
-                } else {
-                    if (!cadmium::engine::all_bags_empty(_inbox)) { //input available
-                        if (t == _next) { //confluence
-                            _model.confluence_transition(t - _last, _inbox);
-                        } else { //external
-                            _model.external_transition(t - _last, _inbox);
-                        }
-                        _last = t;
-                        _next = _last + _model.time_advance();
-                    } else { //no input available
-                        if (t != _next) {
-                            //throw std::domain_error("Trying to execute internal transition at wrong time");
-                            //for now, we iterate all models in place of using a FEL.
-                            //Then, it could reach the case nothing is there.
-                            //Just a nop is enough. And no _next or _last should be changed.
-                        } else {
-                            _model.internal_transition();
-                            _last = t;
-                            _next = _last + _model.time_advance();
-                        }
+                if (has_pending_input()) { //input available
+                    if (t == _next) { //confluence
+                        _model.confluence_transition(t - _last, _inbox);
+                    } else { //external
+                        _model.external_transition(t - _last, _inbox);
                     }
-                    _inbox = in_bags_type{};
+                } else { //no input available, then it is imminent
+                    _model.internal_transition();
                 }
+                _last = t;
+                _next = _last + _model.time_advance();
+                //messages were consumed, the boxes are emptied for next step keeping their memory
+                cadmium::reset_message_bags(_inbox);
+                cadmium::reset_message_bags(_outbox);
+                _inbox_dirty.reset();
+                _outbox_dirty.reset();
 
                 auto log_state = [](const typename model_type::state_type& s) -> std::string {
                     std::ostringstream oss;
@@ -206,6 +237,30 @@ namespace cadmium {
 
                 LOGGER::template log<cadmium::logger::logger_state, decltype(log_state), const typename model_type::state_type&>(log_state, _model.state);
             }
+
+            /**
+             * @brief save writes the state of the model, the times and the messages waiting in the inbox
+             * Members of the model out of its state are not saved.
+             */
+            void save(cadmium::checkpoint_writer& w) const {
+                w.write(_model.state);
+                w.write(_last);
+                w.write(_next);
+                w.write(_inbox);
+            }
+
+            /**
+             * @brief load restores what save wrote, in place of init
+             */
+            void load(cadmium::checkpoint_reader& r) {
+                r.read(_model.state);
+                r.read(_last);
+                r.read(_next);
+                r.read(_inbox);
+                _inbox_dirty = cadmium::non_empty_ports(_inbox);
+                cadmium::reset_message_bags(_outbox);
+                _outbox_dirty.reset();
+            }
     //TODO: use enable_if functions to give access to read state and messages in debug mode
         };
 
@@ -0,0 +1,583 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CADMIUM_PDEVS_TIME_WARP_RUNNER_HPP
+#define CADMIUM_PDEVS_TIME_WARP_RUNNER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <cadmium/engine/pdevs_coordinator.hpp>
+#include <cadmium/engine/pdevs_engine_helpers.hpp>
+#include <cadmium/engine/pdevs_flattening.hpp>
+#include <cadmium/engine/pdevs_parallel_coordinator.hpp>
+#include <cadmium/modeling/message_bag.hpp>
+#include <cadmium/logger/logger.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+namespace cadmium {
+    namespace engine {
+        /**
+         * @brief tw_log_buffer keeps the log records of the steps of a partition not committed yet
+         */
+        template<typename TIME>
+        struct tw_log_buffer {
+            TIME time; //time of the step running
+            std::vector<std::pair<TIME, std::function<void()>>> records;
+        };
+
+        //the buffer of the partition running in current thread, nullptr logs immediately
+        template<typename TIME>
+        tw_log_buffer<TIME>*& current_tw_log_buffer() noexcept {
+            static thread_local tw_log_buffer<TIME>* buffer=nullptr;
+            return buffer;
+        }
+
+        /**
+         * @brief time_warp_logger delays the records of LOGGER until the step logging them is committed,
+         * so the steps rolled back are not logged.
+         */
+        template<typename LOGGER, typename TIME>
+        struct time_warp_logger {
+            template<typename DECLARED_SOURCE, typename... PARAMs>
+            static void log(const PARAMs&... ps) {
+                if (std::is_same<LOGGER, cadmium::logger::not_logger>::value) {
+                    return;
+                }
+                tw_log_buffer<TIME>* buffer = current_tw_log_buffer<TIME>();
+                if (buffer == nullptr) {
+                    LOGGER::template log<DECLARED_SOURCE, PARAMs...>(ps...);
+                } else {
+                    buffer->records.emplace_back(buffer->time, [ps...]() { LOGGER::template log<DECLARED_SOURCE, PARAMs...>(ps...); });
+                }
+            }
+        };
+
+        /**
+         * @brief tw_message is a timestamped message between partitions, or the anti-message cancelling it
+         */
+        template<typename TIME, typename BAGS>
+        struct tw_message {
+            TIME time;
+            BAGS bags;
+            std::size_t sender;
+            unsigned long id; //unique for the sender
+            bool anti;
+        };
+
+        /**
+         * @brief The time_warp_runner class runs the submodels of the top coupled model in parallel, optimistically.
+         *
+         * Every submodel of the top model is a partition run in its own thread by a simulator or a coordinator.
+         * Partitions process their events as soon as they have them, without waiting for the others, and exchange
+         * timestamped messages by the ICs of the top model. When a message arrives in the past of a partition, a
+         * straggler, the partition rolls back: the engine is restored to its copy saved before the first step at or
+         * after the message time, the messages sent by the undone steps are cancelled by anti-messages, and the
+         * steps are run again.
+         *
+         * Global virtual time (GVT), the lowest time a rollback can reach, is computed every few steps by all the
+         * partitions together. Saved copies and messages before GVT are released, and the log records of the steps
+         * before GVT are sent to the logger, which must be parallel safe. The run ends when GVT reaches the limit time.
+         *
+         * No lookahead is needed. The states and messages of each model are the ones of the runner, but the messages
+         * sent between partitions at the same time are delivered in one step, and messages arriving to the same port
+         * from different partitions may be in different order in the bag. The output ports of the top model are not
+         * collected, as in the runner.
+         */
+        template <class TIME, template<class> class MODEL, typename LOGGER=cadmium::logger::not_logger, template<typename> class FEL=heap_fel>
+        class time_warp_runner {
+            static_assert(parallel_safe_logger<LOGGER>::value, "The logger is called from the threads of all partitions, it needs to be parallel safe");
+
+            using engines_logger=time_warp_logger<LOGGER, TIME>;
+            template<typename P>
+            using submodels_type=typename MODEL<TIME>::template models<P>;
+            using engines_type=typename coordinate_tuple<TIME, submodels_type, engines_logger, FEL>::type;
+            using ics=typename MODEL<TIME>::internal_couplings;
+            static constexpr std::size_t partitions_count=std::tuple_size<engines_type>::value;
+
+            template<std::size_t I>
+            using partition_engine=typename std::tuple_element<I, engines_type>::type;
+            template<std::size_t I>
+            using partition_bags=typename make_message_bags<typename partition_engine<I>::model_type::input_ports>::type;
+
+            struct sent_record {
+                std::size_t to;
+                unsigned long id;
+                TIME time;
+            };
+
+            //everything needed for undoing a step
+            template<typename ENGINE, typename MESSAGE>
+            struct step_record {
+                TIME time;
+                ENGINE before; //the engine as it was before the step
+                std::vector<MESSAGE> consumed;
+                std::vector<sent_record> sent;
+            };
+
+            template<typename ENGINE, typename BAGS>
+            struct partition {
+                using message_type=tw_message<TIME, BAGS>;
+                ENGINE engine;
+                //messages arriving, written by any partition
+                std::mutex mutex;
+                std::condition_variable changed;
+                unsigned long version=0;
+                std::vector<message_type> incoming;
+                //owned by the thread of the partition
+                std::vector<message_type> pending; //received and not processed
+                std::deque<step_record<ENGINE, message_type>> processed;
+                tw_log_buffer<TIME> log;
+                unsigned long next_id=0;
+                //messages of an undone step at the time rolled back to, they are sent again unchanged when redoing it
+                bool kept=false;
+                TIME kept_time;
+                std::vector<sent_record> kept_sent;
+            };
+
+            template<typename IS>
+            struct partitions_of;
+
+            template<std::size_t... Is>
+            struct partitions_of<std::index_sequence<Is...>> {
+                using type=std::tuple<partition<partition_engine<Is>, partition_bags<Is>>...>;
+            };
+            using partitions_type=typename partitions_of<std::make_index_sequence<partitions_count>>::type;
+
+            template<std::size_t I>
+            using message_of=tw_message<TIME, partition_bags<I>>;
+
+            partitions_type _partitions;
+            std::size_t _gvt_interval=64;
+            std::atomic<bool> _failed{false};
+            std::exception_ptr _error;
+            std::mutex _error_mutex;
+
+            //GVT rounds, all the partitions meet and the last one arriving computes GVT
+            std::mutex _gvt_mutex;
+            std::condition_variable _gvt_done;
+            std::atomic<bool> _gvt_requested{false};
+            std::size_t _gvt_arrived=0;
+            unsigned long _gvt_round=0;
+            std::vector<TIME> _local_mins;
+            TIME _gvt;
+
+            static constexpr TIME infinity() {
+                return std::numeric_limits<TIME>::infinity();
+            }
+
+            template<typename IC>
+            using ic_from=get_engine_index_by_model<typename IC::template from_model<TIME>, engines_type>;
+            template<typename IC>
+            using ic_to=get_engine_index_by_model<typename IC::template to_model<TIME>, engines_type>;
+
+            template<std::size_t J>
+            void deliver(message_of<J> m) {
+                auto& p=std::get<J>(_partitions);
+                {
+                    std::lock_guard<std::mutex> lock(p.mutex);
+                    p.incoming.push_back(std::move(m));
+                    ++p.version;
+                }
+                p.changed.notify_one();
+            }
+
+            //sends the messages following an IC, only for the ICs leaving the partition sending
+            template<bool LEAVING, typename DUMMY=void>
+            struct ic_sender {
+                template<std::size_t I, typename IC, typename OUT_BAGS>
+                static void send(time_warp_runner&, const TIME&, const OUT_BAGS&, std::vector<sent_record>&) {}
+            };
+
+            template<typename DUMMY>
+            struct ic_sender<true, DUMMY> {
+                template<std::size_t I, typename IC, typename OUT_BAGS>
+                static void send(time_warp_runner& r, const TIME& t, const OUT_BAGS& outbox, std::vector<sent_record>& sent) {
+                    constexpr std::size_t to=ic_to<IC>::value;
+                    const auto& from_messages=get_messages<typename IC::from_model_output_port>(outbox);
+                    if (from_messages.empty()) {
+                        return;
+                    }
+                    message_of<to> m{t, partition_bags<to>{}, I, std::get<I>(r._partitions).next_id++, false};
+                    auto& to_messages=get_messages<typename IC::to_model_input_port>(m.bags);
+                    to_messages.insert(to_messages.end(), from_messages.begin(), from_messages.end());
+                    sent.push_back(sent_record{to, m.id, t});
+                    r.template deliver<to>(std::move(m));
+                }
+            };
+
+            template<std::size_t I>
+            void send_outputs(const TIME& t, std::vector<sent_record>& sent) {
+                const auto& outbox=std::get<I>(_partitions).engine.outbox();
+                flat_for_each<ics>::apply([this, &t, &outbox, &sent](auto ic_tag) {
+                    using ic=typename decltype(ic_tag)::type;
+                    ic_sender<ic_from<ic>::value == I>::template send<I, ic>(*this, t, outbox, sent);
+                });
+            }
+
+            template<std::size_t J>
+            static void send_anti(time_warp_runner& r, std::size_t from, const sent_record& s) {
+                r.template deliver<J>(message_of<J>{s.time, partition_bags<J>{}, from, s.id, true});
+            }
+
+            template<std::size_t... Js>
+            void send_anti(std::size_t from, const sent_record& s, std::index_sequence<Js...>) {
+                using sender_type=void(*)(time_warp_runner&, std::size_t, const sent_record&);
+                static constexpr sender_type table[] = {&time_warp_runner::send_anti<Js>...};
+                table[s.to](*this, from, s);
+            }
+
+            template<std::size_t I>
+            void cancel(const std::vector<sent_record>& sent) {
+                for (const auto& s : sent) {
+                    send_anti(I, s, std::make_index_sequence<partitions_count>{});
+                }
+            }
+
+            //undoes the steps at t or later, the messages they consumed are pending again
+            template<std::size_t I>
+            void rollback(const TIME& t) {
+                auto& p=std::get<I>(_partitions);
+                if (p.kept && t < p.kept_time) {
+                    cancel<I>(p.kept_sent);
+                    p.kept = false;
+                }
+                while (!p.processed.empty() && !(p.processed.back().time < t)) {
+                    auto& step=p.processed.back();
+                    p.engine = std::move(step.before);
+                    for (auto& m : step.consumed) {
+                        p.pending.push_back(std::move(m));
+                    }
+                    bool earliest=(p.processed.size() == 1 || p.processed[p.processed.size() - 2].time < t);
+                    if (earliest && step.time == t) {
+                        //the output at t depends only on the state before t, which is restored as it was
+                        p.kept = true;
+                        p.kept_time = t;
+                        p.kept_sent = std::move(step.sent);
+                    } else {
+                        cancel<I>(step.sent);
+                    }
+                    p.processed.pop_back();
+                }
+                auto& records=p.log.records;
+                auto first_undone=std::find_if(records.begin(), records.end(), [&t](const auto& r) { return !(r.first < t); });
+                records.erase(first_undone, records.end());
+            }
+
+            template<typename MESSAGE>
+            static bool same_message(const MESSAGE& a, const MESSAGE& b) {
+                return a.sender == b.sender && a.id == b.id;
+            }
+
+            template<std::size_t I>
+            void receive(message_of<I>& m) {
+                auto& p=std::get<I>(_partitions);
+                bool straggler=(!p.processed.empty() && !(p.processed.back().time < m.time));
+                if (straggler || (p.kept && m.time < p.kept_time)) {
+                    rollback<I>(m.time);
+                }
+                if (!m.anti) {
+                    p.pending.push_back(std::move(m));
+                    return;
+                }
+                //the positive message is pending, after the rollback if it was consumed
+                auto it=std::find_if(p.pending.begin(), p.pending.end(), [&m](const message_of<I>& other) { return same_message(m, other) && !other.anti; });
+                if (it != p.pending.end()) {
+                    p.pending.erase(it);
+                }
+            }
+
+            template<std::size_t I>
+            void process_step(const TIME& t) {
+                auto& p=std::get<I>(_partitions);
+                p.processed.push_back(step_record<partition_engine<I>, message_of<I>>{t, p.engine, {}, {}});
+                auto& step=p.processed.back();
+                p.log.time = t;
+                if (p.kept && p.kept_time == t) {
+                    //redoing a step undone, its messages were not cancelled
+                    step.sent = std::move(p.kept_sent);
+                    p.kept = false;
+                    if (p.engine.next() == t) {
+                        p.engine.collect_outputs(t);
+                    }
+                } else if (p.engine.next() == t) {
+                    p.engine.collect_outputs(t);
+                    send_outputs<I>(t, step.sent);
+                }
+                partition_bags<I> inbox;
+                bool received=false;
+                for (auto it = p.pending.begin(); it != p.pending.end();) {
+                    if (it->time == t) {
+                        //the messages are kept for being consumed again after a rollback
+                        flat_for_each<typename partition_engine<I>::model_type::input_ports>::apply([&inbox, &it](auto port_tag) {
+                            using port=typename decltype(port_tag)::type;
+                            deliver_messages<false>::deliver(get_messages<port>(it->bags), get_messages<port>(inbox));
+                        });
+                        received = true;
+                        step.consumed.push_back(std::move(*it));
+                        it = p.pending.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+                if (received) {
+                    p.engine.inbox(std::move(inbox));
+                }
+                p.engine.advance_simulation(t);
+            }
+
+            //lowest time of the events of the partition, not counting the messages arriving
+            template<std::size_t I>
+            TIME local_min() {
+                auto& p=std::get<I>(_partitions);
+                TIME ret=p.engine.next();
+                for (const auto& m : p.pending) {
+                    ret = std::min(ret, m.time);
+                }
+                return ret;
+            }
+
+            template<std::size_t... Js>
+            TIME incoming_min(std::index_sequence<Js...>) {
+                TIME ret=infinity();
+                auto incoming_min_of=[](auto& p) {
+                    std::lock_guard<std::mutex> lock(p.mutex);
+                    TIME ret=std::numeric_limits<TIME>::infinity();
+                    for (const auto& m : p.incoming) {
+                        ret = std::min(ret, m.time);
+                    }
+                    return ret;
+                };
+                for (TIME m : std::initializer_list<TIME>{incoming_min_of(std::get<Js>(_partitions))...}) {
+                    ret = std::min(ret, m);
+                }
+                return ret;
+            }
+
+            template<std::size_t... Js>
+            void wake_all(std::index_sequence<Js...>) {
+                auto wake=[](auto& p) {
+                    std::lock_guard<std::mutex> lock(p.mutex);
+                    p.changed.notify_all();
+                };
+                int expand[] = {0, (wake(std::get<Js>(_partitions)), 0)...};
+                (void)expand;
+            }
+
+            void request_gvt() {
+                if (!_gvt_requested.exchange(true)) {
+                    wake_all(std::make_index_sequence<partitions_count>{});
+                }
+            }
+
+            //waits for all the partitions, the GVT computed is left in _gvt
+            void gvt_round(std::size_t i, TIME local) {
+                std::unique_lock<std::mutex> lock(_gvt_mutex);
+                unsigned long round=_gvt_round;
+                _local_mins[i] = local;
+                if (++_gvt_arrived == partitions_count) {
+                    //every partition is waiting, the messages not received yet are still in the mailboxes
+                    TIME gvt=incoming_min(std::make_index_sequence<partitions_count>{});
+                    for (TIME m : _local_mins) {
+                        gvt = std::min(gvt, m);
+                    }
+                    _gvt = gvt;
+                    _gvt_arrived = 0;
+                    _gvt_requested = false;
+                    ++_gvt_round;
+                    _gvt_done.notify_all();
+                } else {
+                    _gvt_done.wait(lock, [this, round]() { return _gvt_round != round || _failed; });
+                }
+            }
+
+            //releases the steps before GVT and logs them
+            template<std::size_t I>
+            void fossil_collect(const TIME& gvt) {
+                auto& p=std::get<I>(_partitions);
+                while (!p.processed.empty() && p.processed.front().time < gvt) {
+                    p.processed.pop_front();
+                }
+                auto& records=p.log.records;
+                auto first_kept=std::find_if(records.begin(), records.end(), [&gvt](const auto& r) { return !(r.first < gvt); });
+                current_tw_log_buffer<TIME>() = nullptr;
+                for (auto it = records.begin(); it != first_kept; ++it) {
+                    it->second();
+                }
+                current_tw_log_buffer<TIME>() = &p.log;
+                records.erase(records.begin(), first_kept);
+            }
+
+            template<std::size_t I>
+            void run_partition(const TIME& end) {
+                try {
+                    current_tw_log_buffer<TIME>() = &std::get<I>(_partitions).log;
+                    run_partition_impl<I>(end);
+                } catch (...) {
+                    {
+                        std::lock_guard<std::mutex> lock(_error_mutex);
+                        if (!_error) {
+                            _error = std::current_exception();
+                        }
+                    }
+                    _failed = true;
+                    {
+                        std::lock_guard<std::mutex> lock(_gvt_mutex);
+                        _gvt_done.notify_all();
+                    }
+                    wake_all(std::make_index_sequence<partitions_count>{});
+                }
+                current_tw_log_buffer<TIME>() = nullptr;
+            }
+
+            template<std::size_t I>
+            void run_partition_impl(const TIME& end) {
+                auto& p=std::get<I>(_partitions);
+                std::size_t steps=0; //since last GVT round
+                bool idle_requested=false;
+                std::vector<message_of<I>> arrived;
+                while (!_failed) {
+                    {
+                        std::lock_guard<std::mutex> lock(p.mutex);
+                        arrived.swap(p.incoming);
+                    }
+                    if (!arrived.empty()) {
+                        idle_requested = false;
+                    }
+                    for (auto& m : arrived) {
+                        receive<I>(m);
+                    }
+                    arrived.clear();
+
+                    if (_gvt_requested) {
+                        gvt_round(I, local_min<I>());
+                        steps = 0;
+                        if (_failed) {
+                            return;
+                        }
+                        fossil_collect<I>(_gvt);
+                        if (!(_gvt < end)) {
+                            return;
+                        }
+                        continue;
+                    }
+
+                    TIME t=local_min<I>();
+                    if (t < end) {
+                        process_step<I>(t);
+                        if (++steps >= _gvt_interval) {
+                            request_gvt();
+                        }
+                    } else if (!idle_requested) {
+                        //nothing to do until a message arrives, maybe everyone finished
+                        idle_requested = true;
+                        request_gvt();
+                    } else {
+                        std::unique_lock<std::mutex> lock(p.mutex);
+                        p.changed.wait(lock, [this, &p]() { return !p.incoming.empty() || _gvt_requested || _failed; });
+                    }
+                }
+            }
+
+            template<std::size_t... Is>
+            void run_partitions(const TIME& t, std::index_sequence<Is...>) {
+                std::vector<std::thread> threads;
+                int expand[] = {0, (threads.emplace_back(&time_warp_runner::run_partition<Is>, this, t), 0)...};
+                (void)expand;
+                for (auto& th : threads) {
+                    th.join();
+                }
+            }
+
+            template<std::size_t... Is>
+            void init_partitions(const TIME& init_time, std::index_sequence<Is...>) {
+                int expand[] = {0, (std::get<Is>(_partitions).engine.init(init_time), 0)...};
+                (void)expand;
+            }
+
+            template<std::size_t... Is>
+            TIME next(std::index_sequence<Is...>) {
+                TIME ret=infinity();
+                for (TIME n : std::initializer_list<TIME>{local_min<Is>()...}) {
+                    ret = std::min(ret, n);
+                }
+                return ret;
+            }
+
+        public:
+            /**
+             * @brief set the dynamic parameters for the simulation
+             * @param init_time is the initial time of the simulation.
+             */
+            explicit time_warp_runner(const TIME& init_time) : _gvt(init_time) {
+                LOGGER::template log<cadmium::logger::logger_global_time, TIME>(init_time);
+                LOGGER::template log<cadmium::logger::logger_info, std::string>("Preparing model");
+                init_partitions(init_time, std::make_index_sequence<partitions_count>{});
+                _local_mins.assign(partitions_count, init_time);
+            }
+
+            time_warp_runner(const time_warp_runner&) = delete;
+            time_warp_runner& operator=(const time_warp_runner&) = delete;
+
+            /**
+             * @brief gvt_interval sets the number of steps a partition runs between GVT rounds,
+             * lower values release memory sooner, higher values synchronize the partitions less often.
+             */
+            void gvt_interval(std::size_t steps) {
+                _gvt_interval = std::max<std::size_t>(steps, 1);
+            }
+
+            /**
+             * @brief runUntil runs every partition in its own thread until GVT reaches t.
+             * @param t is the limit time for the simulation.
+             * @return the TIME of the next event to happen when simulation stopped.
+             */
+            TIME runUntil(const TIME& t) {
+                LOGGER::template log<cadmium::logger::logger_info, std::string>("Starting run");
+                run_partitions(t, std::make_index_sequence<partitions_count>{});
+                if (_failed) {
+                    std::rethrow_exception(_error);
+                }
+                LOGGER::template log<cadmium::logger::logger_info, std::string>("Finished run");
+                return next(std::make_index_sequence<partitions_count>{});
+            }
+        };
+    }
+}
+
+#endif // CADMIUM_PDEVS_TIME_WARP_RUNNER_HPP
@@ -0,0 +1,136 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CADMIUM_SHARED_MEMORY_RING_HPP
+#define CADMIUM_SHARED_MEMORY_RING_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+namespace cadmium {
+    namespace engine {
+        /**
+         * @brief shared_memory_ring is a single producer single consumer queue of message bags living in memory
+         * shared by processes.
+         *
+         * The ring is constructed with placement new at the start of a block of bytes_for(capacity) bytes, the
+         * bytes keeping the messages follow the header. Each record is the count of messages followed by their
+         * bytes, so messages are required to be trivially copyable. Head and tail count the bytes written and read,
+         * they are lock free atomics, which work between processes.
+         */
+        class shared_memory_ring {
+            static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "Rings shared between processes need lock free atomics");
+
+            std::atomic<std::uint64_t> _head; //bytes written
+            std::atomic<std::uint64_t> _tail; //bytes read
+            std::uint64_t _capacity;
+
+            unsigned char* data() noexcept {
+                return reinterpret_cast<unsigned char*>(this + 1);
+            }
+
+            //copies into the ring at position pos, wrapping around the end
+            void write_at(std::uint64_t pos, const void* from, std::size_t size) noexcept {
+                std::size_t offset=pos % _capacity;
+                std::size_t first=std::min<std::size_t>(size, _capacity - offset);
+                std::memcpy(data() + offset, from, first);
+                std::memcpy(data(), static_cast<const unsigned char*>(from) + first, size - first);
+            }
+
+            void read_at(std::uint64_t pos, void* to, std::size_t size) noexcept {
+                std::size_t offset=pos % _capacity;
+                std::size_t first=std::min<std::size_t>(size, _capacity - offset);
+                std::memcpy(to, data() + offset, first);
+                std::memcpy(static_cast<unsigned char*>(to) + first, data(), size - first);
+            }
+
+        public:
+            /**
+             * @brief bytes_for tells the size of the block needed for a ring keeping capacity bytes of records
+             */
+            static constexpr std::size_t bytes_for(std::size_t capacity) noexcept {
+                return sizeof(shared_memory_ring) + (capacity + alignof(shared_memory_ring) - 1) / alignof(shared_memory_ring) * alignof(shared_memory_ring);
+            }
+
+            explicit shared_memory_ring(std::size_t capacity) noexcept : _head(0), _tail(0), _capacity(capacity) {}
+
+            shared_memory_ring(const shared_memory_ring&) = delete;
+            shared_memory_ring& operator=(const shared_memory_ring&) = delete;
+
+            bool empty() const noexcept {
+                return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+            }
+
+            /**
+             * @brief push writes the messages of a bag as a record
+             * @throw std::length_error if the record does not fit in the free space of the ring
+             */
+            template<typename BAG>
+            void push(const BAG& bag) {
+                using message_type=typename std::decay<decltype(*bag.begin())>::type;
+                static_assert(std::is_trivially_copyable<message_type>::value, "Messages crossing processes need to be trivially copyable");
+                std::uint64_t count=bag.size();
+                std::size_t size=sizeof(count) + count * sizeof(message_type);
+                std::uint64_t head=_head.load(std::memory_order_relaxed);
+                if (_capacity - (head - _tail.load(std::memory_order_acquire)) < size) {
+                    throw std::length_error("Messages do not fit in the shared memory ring, a larger capacity is needed");
+                }
+                write_at(head, &count, sizeof(count));
+                std::uint64_t pos=head + sizeof(count);
+                for (const auto& m : bag) {
+                    write_at(pos, &m, sizeof(message_type));
+                    pos += sizeof(message_type);
+                }
+                _head.store(pos, std::memory_order_release);
+            }
+
+            /**
+             * @brief pop reads the oldest record appending its messages to the bag, the ring must not be empty
+             */
+            template<typename BAG>
+            void pop(BAG& bag) {
+                using message_type=typename std::decay<decltype(*bag.begin())>::type;
+                std::uint64_t tail=_tail.load(std::memory_order_relaxed);
+                std::uint64_t count;
+                read_at(tail, &count, sizeof(count));
+                std::uint64_t pos=tail + sizeof(count);
+                for (std::uint64_t i = 0; i < count; ++i) {
+                    typename std::aligned_storage<sizeof(message_type), alignof(message_type)>::type m;
+                    read_at(pos, &m, sizeof(message_type));
+                    bag.push_back(*reinterpret_cast<const message_type*>(&m));
+                    pos += sizeof(message_type);
+                }
+                _tail.store(pos, std::memory_order_release);
+            }
+        };
+    }
+}
+
+#endif // CADMIUM_SHARED_MEMORY_RING_HPP
@@ -0,0 +1,273 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CADMIUM_TASK_SCHEDULER_HPP
+#define CADMIUM_TASK_SCHEDULER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cadmium {
+    namespace engine {
+        class task_scheduler;
+
+        /**
+         * @brief task_group counts the tasks spawned for a loop that are not finished yet
+         * and keeps the first exception thrown by them.
+         */
+        class task_group {
+            friend class task_scheduler;
+            std::atomic<std::size_t> _pending{0};
+            std::mutex _mutex;
+            std::exception_ptr _error;
+
+            void fail(std::exception_ptr e) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (!_error) {
+                    _error = e;
+                }
+            }
+        };
+
+        /**
+         * @brief task_scheduler runs tasks in a set of threads that steal work from each other
+         *
+         * Every thread has its own queue of tasks. Tasks spawned by a thread are pushed in its queue, the
+         * thread takes them back in LIFO order, and idle threads steal the oldest ones from other queues.
+         * Waiting for a group of tasks runs tasks too, so a task may spawn more tasks and wait for them,
+         * as coordinators do when their submodels are coupled models, without blocking a thread.
+         *
+         * Threads not belonging to the scheduler share a single queue, so only one of them at a time is
+         * expected to spawn tasks.
+         */
+        class task_scheduler {
+            struct task {
+                void (*run)(void*, std::size_t);
+                void* context;
+                std::size_t index;
+                task_group* group;
+            };
+
+            struct task_queue {
+                std::mutex mutex;
+                std::deque<task> tasks;
+            };
+
+            //queue 0 is used by threads outside the scheduler, queue i by the worker i
+            std::vector<std::unique_ptr<task_queue>> _queues;
+            std::vector<std::thread> _workers;
+            std::atomic<std::size_t> _queued{0}; //tasks waiting in any queue
+            std::atomic<std::size_t> _sleeping{0};
+            std::mutex _sleep_mutex;
+            std::condition_variable _wake;
+            bool _stop=false;
+
+            struct thread_identity {
+                const task_scheduler* scheduler;
+                std::size_t queue;
+            };
+
+            static thread_identity& identity() noexcept {
+                static thread_local thread_identity id{nullptr, 0};
+                return id;
+            }
+
+            std::size_t own_queue() const noexcept {
+                return identity().scheduler == this ? identity().queue : 0;
+            }
+
+            void push(std::size_t q, const task& tk) {
+                {
+                    std::lock_guard<std::mutex> lock(_queues[q]->mutex);
+                    _queues[q]->tasks.push_back(tk);
+                }
+                _queued.fetch_add(1);
+                if (_sleeping.load() > 0) {
+                    std::lock_guard<std::mutex> lock(_sleep_mutex);
+                    _wake.notify_one();
+                }
+            }
+
+            //newest task of the own queue, or the oldest task of another queue
+            bool pop(std::size_t q, task& tk) {
+                {
+                    std::lock_guard<std::mutex> lock(_queues[q]->mutex);
+                    if (!_queues[q]->tasks.empty()) {
+                        tk = _queues[q]->tasks.back();
+                        _queues[q]->tasks.pop_back();
+                        _queued.fetch_sub(1);
+                        return true;
+                    }
+                }
+                for (std::size_t i = 1; i < _queues.size(); ++i) {
+                    task_queue& victim = *_queues[(q + i) % _queues.size()];
+                    std::lock_guard<std::mutex> lock(victim.mutex);
+                    if (!victim.tasks.empty()) {
+                        tk = victim.tasks.front();
+                        victim.tasks.pop_front();
+                        _queued.fetch_sub(1);
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            static void execute(const task& tk) {
+                try {
+                    tk.run(tk.context, tk.index);
+                } catch (...) {
+                    tk.group->fail(std::current_exception());
+                }
+                tk.group->_pending.fetch_sub(1);
+            }
+
+            bool run_one(std::size_t q) {
+                task tk;
+                if (pop(q, tk)) {
+                    execute(tk);
+                    return true;
+                }
+                return false;
+            }
+
+            void work(std::size_t q) {
+                identity() = thread_identity{this, q};
+                while (true) {
+                    if (run_one(q)) {
+                        continue;
+                    }
+                    std::unique_lock<std::mutex> lock(_sleep_mutex);
+                    _sleeping.fetch_add(1);
+                    _wake.wait(lock, [this]() { return _stop || _queued.load() > 0; });
+                    _sleeping.fetch_sub(1);
+                    if (_stop) {
+                        return;
+                    }
+                }
+            }
+
+            template<typename F>
+            static void call(void* f, std::size_t i) {
+                (*static_cast<F*>(f))(i);
+            }
+
+        public:
+            /**
+             * @brief constructs the scheduler and starts its worker threads
+             * @param threads is the number of threads running tasks, including the thread spawning them
+             */
+            explicit task_scheduler(std::size_t threads=std::thread::hardware_concurrency()) {
+                std::size_t queues = threads > 0 ? threads : 1;
+                for (std::size_t i = 0; i < queues; ++i) {
+                    _queues.emplace_back(new task_queue());
+                }
+                for (std::size_t i = 1; i < queues; ++i) {
+                    _workers.emplace_back([this, i]() { work(i); });
+                }
+            }
+
+            task_scheduler(const task_scheduler&) = delete;
+            task_scheduler& operator=(const task_scheduler&) = delete;
+
+            ~task_scheduler() {
+                {
+                    std::lock_guard<std::mutex> lock(_sleep_mutex);
+                    _stop = true;
+                }
+                _wake.notify_all();
+                for (auto& w : _workers) {
+                    w.join();
+                }
+            }
+
+            /**
+             * @brief size tells the number of threads running tasks, including the one spawning them
+             */
+            std::size_t size() const noexcept {
+                return _queues.size();
+            }
+
+            /**
+             * @brief thread_index tells the index in [0, size()) of the thread calling it, threads out of the
+             * scheduler share the index 0
+             */
+            std::size_t thread_index() const noexcept {
+                return own_queue();
+            }
+
+            /**
+             * @brief for_each_index calls f(i) for every i in [0, n) as tasks and returns when all of them
+             * finished, running pending tasks while waiting.
+             * If any call throws, the remaining calls are run and the first exception is rethrown.
+             */
+            template<typename F>
+            void for_each_index(std::size_t n, F&& f) {
+                using function_type=typename std::remove_reference<F>::type;
+                if (n < 2 || _workers.empty()) { //nothing to share
+                    for (std::size_t i = 0; i < n; ++i) {
+                        f(i);
+                    }
+                    return;
+                }
+                std::size_t q = own_queue();
+                void* context = const_cast<void*>(static_cast<const void*>(&f));
+                task_group group;
+                group._pending.store(n);
+                //the last ones are pushed first, so the thread spawning them takes them in order
+                for (std::size_t i = n - 1; i > 0; --i) {
+                    push(q, task{&call<function_type>, context, i, &group});
+                }
+                execute(task{&call<function_type>, context, 0, &group});
+                while (group._pending.load() > 0) {
+                    if (!run_one(q)) {
+                        std::this_thread::yield();
+                    }
+                }
+                if (group._error) {
+                    std::rethrow_exception(group._error);
+                }
+            }
+        };
+
+        /**
+         * @brief current_task_scheduler is the scheduler used by the parallel engines initialized in current thread
+         * The top level engine installs its scheduler while initializing the subengines, so all the levels share it.
+         */
+        inline task_scheduler*& current_task_scheduler() noexcept {
+            static thread_local task_scheduler* scheduler=nullptr;
+            return scheduler;
+        }
+    }
+}
+
+#endif // CADMIUM_TASK_SCHEDULER_HPP
@@ -0,0 +1,322 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CADMIUM_BAG_POLICIES_HPP
+#define CADMIUM_BAG_POLICIES_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <boost/container/small_vector.hpp>
+#include <boost/container/static_vector.hpp>
+#include <cadmium/modeling/step_arena.hpp>
+
+/**
+ * Bag policies define the container used for keeping the messages of a port and how it is emptied
+ * between steps. Each policy provides:
+ * - container<T>: the type of the bag for messages of type T.
+ * - reset(b, retained_capacity): empties the bag, keeping memory for up to retained_capacity messages.
+ *
+ * The policy is selected per port by the second template parameter of in_port and out_port, ports
+ * not selecting one use counted_bag_policy for empty message types and CADMIUM_DEFAULT_BAG_POLICY
+ * otherwise, which can be defined before including cadmium headers to change the policy of all ports.
+ * Bags are part of the types of the models, so the policy can not be changed when running them.
+ */
+
+namespace cadmium {
+template<typename T>
+using bag=std::vector<T>;
+
+//bags created while a step_arena is installed take their memory from it
+template<typename T>
+using arena_bag=std::vector<T, bag_allocator<T>>;
+
+/**
+ * @brief reset_bag empties the bag keeping its memory for reuse, unless its capacity is larger than
+ * retained_capacity.
+ */
+template<typename T>
+void reset_bag(bag<T>& b, std::size_t retained_capacity){
+    if (b.capacity() > retained_capacity) {
+        bag<T>().swap(b);
+    } else {
+        b.clear();
+    }
+}
+
+/**
+ * @brief reset_bag for arena bags also drops memory belonging to a step_arena, which is released at
+ * the end of the step.
+ */
+template<typename T>
+void reset_bag(arena_bag<T>& b, std::size_t retained_capacity){
+    if (b.get_allocator().arena() != nullptr || b.capacity() > retained_capacity) {
+        b = arena_bag<T>{};
+    } else {
+        b.clear();
+    }
+}
+
+/**
+ * @brief vector_bag_policy keeps messages in a vector, it is the default for ports with non empty message types
+ */
+struct vector_bag_policy{
+    template<typename T>
+    using container=bag<T>;
+
+    template<typename T>
+    static void reset(container<T>& b, std::size_t retained_capacity){
+        reset_bag(b, retained_capacity);
+    }
+};
+
+/**
+ * @brief arena_vector_bag_policy keeps messages in a vector taking memory from the step_arena if installed
+ *
+ * Bags of these ports created during a step are released with the step, models must copy them, not move
+ * or swap them, to keep their messages in the state.
+ */
+struct arena_vector_bag_policy{
+    template<typename T>
+    using container=arena_bag<T>;
+
+    template<typename T>
+    static void reset(container<T>& b, std::size_t retained_capacity){
+        reset_bag(b, retained_capacity);
+    }
+};
+
+/**
+ * @brief small_vector_bag_policy keeps up to N messages inline in the bag, more messages go to the heap
+ */
+template<std::size_t N>
+struct small_vector_bag_policy{
+    template<typename T>
+    using container=boost::container::small_vector<T, N>;
+
+    template<typename T>
+    static void reset(container<T>& b, std::size_t retained_capacity){
+        if (b.capacity() > std::max(N, retained_capacity)) {
+            container<T>().swap(b);
+        } else {
+            b.clear();
+        }
+    }
+};
+
+/**
+ * @brief static_vector_bag_policy keeps up to N messages inline in the bag, never allocating
+ * Inserting more than N messages in the bag throws std::bad_alloc.
+ */
+template<std::size_t N>
+struct static_vector_bag_policy{
+    template<typename T>
+    using container=boost::container::static_vector<T, N>;
+
+    template<typename T>
+    static void reset(container<T>& b, std::size_t){
+        b.clear();
+    }
+};
+
+/**
+ * @brief counted_bag keeps only the number of messages, for message types without data members
+ *
+ * It provides the interface of a vector, iterating the bag gives as many messages as were inserted.
+ */
+template<typename T>
+class counted_bag {
+    static_assert(std::is_empty<T>::value, "counted_bag can hold only messages of empty types");
+    std::size_t _count=0;
+
+    static const T& message() noexcept {
+        static const T m{};
+        return m;
+    }
+
+public:
+    using value_type=T;
+    using size_type=std::size_t;
+    using difference_type=std::ptrdiff_t;
+    using reference=const T&;
+    using const_reference=const T&;
+
+    class const_iterator {
+        std::size_t _index;
+    public:
+        using iterator_category=std::random_access_iterator_tag;
+        using value_type=T;
+        using difference_type=std::ptrdiff_t;
+        using pointer=const T*;
+        using reference=const T&;
+
+        explicit const_iterator(std::size_t index=0) noexcept : _index(index) {}
+
+        reference operator*() const noexcept { return message(); }
+        pointer operator->() const noexcept { return &message(); }
+        reference operator[](difference_type) const noexcept { return message(); }
+
+        const_iterator& operator++() noexcept { ++_index; return *this; }
+        const_iterator operator++(int) noexcept { const_iterator ret=*this; ++_index; return ret; }
+        const_iterator& operator--() noexcept { --_index; return *this; }
+        const_iterator operator--(int) noexcept { const_iterator ret=*this; --_index; return ret; }
+        const_iterator& operator+=(difference_type n) noexcept { _index += n; return *this; }
+        const_iterator& operator-=(difference_type n) noexcept { _index -= n; return *this; }
+        const_iterator operator+(difference_type n) const noexcept { return const_iterator(_index + n); }
+        const_iterator operator-(difference_type n) const noexcept { return const_iterator(_index - n); }
+        difference_type operator-(const const_iterator& o) const noexcept {
+            return static_cast<difference_type>(_index) - static_cast<difference_type>(o._index);
+        }
+
+        bool operator==(const const_iterator& o) const noexcept { return _index == o._index; }
+        bool operator!=(const const_iterator& o) const noexcept { return _index != o._index; }
+        bool operator<(const const_iterator& o) const noexcept { return _index < o._index; }
+        bool operator>(const const_iterator& o) const noexcept { return _index > o._index; }
+        bool operator<=(const const_iterator& o) const noexcept { return _index <= o._index; }
+        bool operator>=(const const_iterator& o) const noexcept { return _index >= o._index; }
+    };
+    using iterator=const_iterator;
+
+    counted_bag() noexcept {}
+    counted_bag(std::initializer_list<T> l) noexcept : _count(l.size()) {}
+    explicit counted_bag(std::size_t n) noexcept : _count(n) {}
+
+    counted_bag& operator=(std::initializer_list<T> l) noexcept {
+        _count = l.size();
+        return *this;
+    }
+
+    const_iterator begin() const noexcept { return const_iterator(0); }
+    const_iterator end() const noexcept { return const_iterator(_count); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    std::size_t size() const noexcept { return _count; }
+    bool empty() const noexcept { return _count == 0; }
+    std::size_t capacity() const noexcept { return std::numeric_limits<std::size_t>::max(); }
+    void reserve(std::size_t) noexcept {}
+    void clear() noexcept { _count = 0; }
+    void resize(std::size_t n) noexcept { _count = n; }
+
+    const T& front() const noexcept { return message(); }
+    const T& back() const noexcept { return message(); }
+    const T& operator[](std::size_t) const noexcept { return message(); }
+    const T& at(std::size_t i) const {
+        if (i >= _count) {
+            throw std::out_of_range("Accessing a message out of the bag");
+        }
+        return message();
+    }
+
+    void push_back(const T&) noexcept { ++_count; }
+    template<typename... Args>
+    const T& emplace_back(Args&&...) noexcept { ++_count; return message(); }
+    void pop_back() noexcept { --_count; }
+
+    template<typename IT>
+    const_iterator insert(const_iterator pos, IT first, IT last) {
+        _count += std::distance(first, last);
+        return pos;
+    }
+
+    const_iterator insert(const_iterator pos, const T&) noexcept {
+        ++_count;
+        return pos;
+    }
+
+    void swap(counted_bag& other) noexcept {
+        std::swap(_count, other._count);
+    }
+
+    bool operator==(const counted_bag& other) const noexcept { return _count == other._count; }
+    bool operator!=(const counted_bag& other) const noexcept { return _count != other._count; }
+};
+
+/**
+ * @brief counted_bag_policy keeps the bags of messages of empty types as a counter, never allocating
+ * It is the policy used by default for ports with empty message types.
+ */
+struct counted_bag_policy{
+    template<typename T>
+    using container=counted_bag<T>;
+
+    template<typename T>
+    static void reset(container<T>& b, std::size_t){
+        b.clear();
+    }
+};
+
+/**
+ * @brief deque_bag_policy keeps messages in a deque, for ports receiving large bursts of messages
+ */
+struct deque_bag_policy{
+    template<typename T>
+    using container=std::deque<T>;
+
+    template<typename T>
+    static void reset(container<T>& b, std::size_t retained_capacity){
+        if (b.size() > retained_capacity) {
+            container<T>().swap(b);
+        } else {
+            b.clear();
+        }
+    }
+};
+}
+
+#ifndef CADMIUM_DEFAULT_BAG_POLICY
+#define CADMIUM_DEFAULT_BAG_POLICY cadmium::vector_bag_policy
+#endif
+
+namespace cadmium {
+/**
+ * @brief default_bag_policy is the policy of ports not selecting one, it is resolved by message type:
+ * empty message types use counted_bag_policy, others use CADMIUM_DEFAULT_BAG_POLICY.
+ */
+struct default_bag_policy{};
+
+template<typename POLICY, typename MSG>
+struct resolve_bag_policy{
+    using type=POLICY;
+};
+
+template<typename MSG>
+struct resolve_bag_policy<default_bag_policy, MSG>{
+    using type=typename std::conditional<std::is_empty<MSG>::value && std::is_trivially_copyable<MSG>::value
+                                         && std::is_default_constructible<MSG>::value,
+                                         counted_bag_policy,
+                                         CADMIUM_DEFAULT_BAG_POLICY>::type;
+};
+}
+
+#endif // CADMIUM_BAG_POLICIES_HPP
@@ -0,0 +1,195 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CADMIUM_CHECKPOINT_HPP
+#define CADMIUM_CHECKPOINT_HPP
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <cadmium/modeling/message_bag.hpp>
+
+namespace cadmium {
+    class checkpoint_writer;
+    class checkpoint_reader;
+
+    /**
+     * @brief checkpoint_serializer writes and reads values of type T in simulation snapshots.
+     *
+     * Trivially copyable types are written as their bytes, tuples and pairs element by element, and
+     * containers with push_back (vectors, deques, strings, bags) as their size followed by their elements.
+     * Model states of other types need a specialization providing:
+     *   static void save(checkpoint_writer&, const T&);
+     *   static void load(checkpoint_reader&, T&);
+     *
+     * Snapshots use the native layout of the types, they are meant to be read by the same build.
+     */
+    template<typename T, typename ENABLE=void>
+    struct checkpoint_serializer {
+        static_assert(std::is_same<ENABLE, int>::value, "The type is not serializable in a checkpoint, specialize cadmium::checkpoint_serializer for it");
+    };
+
+    /**
+     * @brief checkpoint_writer writes a snapshot to a binary stream
+     */
+    class checkpoint_writer {
+        std::ostream& _os;
+    public:
+        explicit checkpoint_writer(std::ostream& os) noexcept : _os(os) {}
+
+        void write_bytes(const void* data, std::size_t size) {
+            _os.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+            if (!_os) {
+                throw std::runtime_error("Failed writing the checkpoint");
+            }
+        }
+
+        template<typename T>
+        void write(const T& value) {
+            checkpoint_serializer<T>::save(*this, value);
+        }
+    };
+
+    /**
+     * @brief checkpoint_reader reads a snapshot from a binary stream
+     */
+    class checkpoint_reader {
+        std::istream& _is;
+    public:
+        explicit checkpoint_reader(std::istream& is) noexcept : _is(is) {}
+
+        void read_bytes(void* data, std::size_t size) {
+            _is.read(static_cast<char*>(data), static_cast<std::streamsize>(size));
+            if (static_cast<std::size_t>(_is.gcount()) != size) {
+                throw std::domain_error("Checkpoint ended before all the simulation state was read");
+            }
+        }
+
+        template<typename T>
+        void read(T& value) {
+            checkpoint_serializer<T>::load(*this, value);
+        }
+    };
+
+    template<typename... Ts>
+    using checkpoint_void_t=void;
+
+    template<typename T, typename ENABLE=void>
+    struct is_checkpoint_sequence : std::false_type {};
+
+    template<typename T>
+    struct is_checkpoint_sequence<T, checkpoint_void_t<
+        typename T::value_type,
+        decltype(std::declval<const T&>().size()),
+        decltype(std::declval<const T&>().begin()),
+        decltype(std::declval<T&>().push_back(std::declval<typename T::value_type>()))>> : std::true_type {};
+
+    template<typename T>
+    struct checkpoint_serializer<T, typename std::enable_if<std::is_trivially_copyable<T>::value>::type> {
+        static void save(checkpoint_writer& w, const T& value) {
+            w.write_bytes(&value, sizeof(T));
+        }
+
+        static void load(checkpoint_reader& r, T& value) {
+            r.read_bytes(&value, sizeof(T));
+        }
+    };
+
+    template<typename T>
+    struct checkpoint_serializer<T, typename std::enable_if<!std::is_trivially_copyable<T>::value && is_checkpoint_sequence<T>::value>::type> {
+        static void save(checkpoint_writer& w, const T& values) {
+            w.write(static_cast<std::uint64_t>(values.size()));
+            for (const auto& v : values) {
+                w.write(v);
+            }
+        }
+
+        static void load(checkpoint_reader& r, T& values) {
+            std::uint64_t size;
+            r.read(size);
+            values = T{};
+            for (std::uint64_t i = 0; i < size; ++i) {
+                typename T::value_type v;
+                r.read(v);
+                values.push_back(std::move(v));
+            }
+        }
+    };
+
+    template<typename... Ts>
+    struct checkpoint_serializer<std::tuple<Ts...>, typename std::enable_if<!std::is_trivially_copyable<std::tuple<Ts...>>::value>::type> {
+        template<std::size_t... Is>
+        static void save(checkpoint_writer& w, const std::tuple<Ts...>& values, std::index_sequence<Is...>) {
+            int expand[] = {0, (w.write(std::get<Is>(values)), 0)...};
+            (void)expand;
+        }
+
+        template<std::size_t... Is>
+        static void load(checkpoint_reader& r, std::tuple<Ts...>& values, std::index_sequence<Is...>) {
+            int expand[] = {0, (r.read(std::get<Is>(values)), 0)...};
+            (void)expand;
+        }
+
+        static void save(checkpoint_writer& w, const std::tuple<Ts...>& values) {
+            save(w, values, std::index_sequence_for<Ts...>{});
+        }
+
+        static void load(checkpoint_reader& r, std::tuple<Ts...>& values) {
+            load(r, values, std::index_sequence_for<Ts...>{});
+        }
+    };
+
+    template<typename FIRST, typename SECOND>
+    struct checkpoint_serializer<std::pair<FIRST, SECOND>, typename std::enable_if<!std::is_trivially_copyable<std::pair<FIRST, SECOND>>::value>::type> {
+        static void save(checkpoint_writer& w, const std::pair<FIRST, SECOND>& value) {
+            w.write(value.first);
+            w.write(value.second);
+        }
+
+        static void load(checkpoint_reader& r, std::pair<FIRST, SECOND>& value) {
+            r.read(value.first);
+            r.read(value.second);
+        }
+    };
+
+    template<typename PORT>
+    struct checkpoint_serializer<message_bag<PORT>, typename std::enable_if<!std::is_trivially_copyable<message_bag<PORT>>::value>::type> {
+        static void save(checkpoint_writer& w, const message_bag<PORT>& bag) {
+            w.write(bag.messages);
+        }
+
+        static void load(checkpoint_reader& r, message_bag<PORT>& bag) {
+            r.read(bag.messages);
+        }
+    };
+}
+
+#endif // CADMIUM_CHECKPOINT_HPP
@@ -0,0 +1,96 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CADMIUM_LOOKAHEAD_HPP
+#define CADMIUM_LOOKAHEAD_HPP
+
+#include <algorithm>
+#include <initializer_list>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/**
+ * The lookahead of a model is a lower bound of the time advance after any of its transitions,
+ * then an input received at time t can not cause an output before t + lookahead.
+ *
+ * Atomic models declare it by a static function:
+ *     static TIME lookahead();
+ * Models not declaring it have a zero lookahead.
+ * The lookahead of a coupled model is the lowest of its submodels.
+ */
+namespace cadmium {
+    namespace modeling {
+        template<typename TIME, typename MODEL, typename=void>
+        struct declares_lookahead : std::false_type{};
+
+        template<typename TIME, typename MODEL>
+        struct declares_lookahead<TIME, MODEL, decltype(void(TIME(MODEL::lookahead())))> : std::true_type{};
+
+        template<typename TIME, typename MODEL, typename=void>
+        struct is_coupled_for_lookahead : std::false_type{};
+
+        template<typename TIME, typename MODEL>
+        struct is_coupled_for_lookahead<TIME, MODEL, decltype(void(std::declval<typename MODEL::template models<TIME>>()))> : std::true_type{};
+
+        template<typename TIME, typename MODEL, bool COUPLED=is_coupled_for_lookahead<TIME, MODEL>::value, bool DECLARED=declares_lookahead<TIME, MODEL>::value>
+        struct model_lookahead {
+            static TIME value() {
+                return TIME{};
+            }
+        };
+
+        template<typename TIME, typename MODEL>
+        struct model_lookahead<TIME, MODEL, false, true> {
+            static TIME value() {
+                return MODEL::lookahead();
+            }
+        };
+
+        template<typename TIME, typename MODELS, typename IS=std::make_index_sequence<std::tuple_size<MODELS>::value>>
+        struct min_lookahead;
+
+        template<typename TIME, typename MODELS, std::size_t I, std::size_t... Is>
+        struct min_lookahead<TIME, MODELS, std::index_sequence<I, Is...>> {
+            static TIME value() {
+                TIME ret = model_lookahead<TIME, typename std::tuple_element<I, MODELS>::type>::value();
+                for (TIME l : std::initializer_list<TIME>{model_lookahead<TIME, typename std::tuple_element<Is, MODELS>::type>::value()...}) {
+                    ret = std::min(ret, l);
+                }
+                return ret;
+            }
+        };
+
+        template<typename TIME, typename MODEL, bool DECLARED>
+        struct model_lookahead<TIME, MODEL, true, DECLARED> {
+            static TIME value() {
+                return min_lookahead<TIME, typename MODEL::template models<TIME>>::value();
+            }
+        };
+    }
+}
+
+#endif // CADMIUM_LOOKAHEAD_HPP
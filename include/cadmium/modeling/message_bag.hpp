@@ -27,23 +27,64 @@
 #ifndef CADMIUM_MESSAGE_BAG_HPP
 #define CADMIUM_MESSAGE_BAG_HPP
 
-#include <vector>
+#include <bitset>
+#include <cstddef>
+#include <iterator>
 #include <tuple>
+#include <utility>
+#include <type_traits>
+#include <cadmium/modeling/bag_policies.hpp>
+
+/**
+ * Number of messages a bag keeps room for when it is reset, bags that grew larger release their memory.
+ * It can be defined before including cadmium headers to change the default for all ports.
+ */
+#ifndef CADMIUM_BAG_RETAINED_CAPACITY
+#define CADMIUM_BAG_RETAINED_CAPACITY 64
+#endif
 
 namespace cadmium {
-template<typename T>
-using bag=std::vector<T>;
+/**
+ * @brief bag_retained_capacity is the capacity policy used when resetting the bag of a port
+ * It can be specialized for ports expecting bursts of messages.
+ */
+template<typename PORT>
+struct bag_retained_capacity{
+    static constexpr std::size_t value=CADMIUM_BAG_RETAINED_CAPACITY;
+};
+
+/**
+ * @brief bag_policy_of finds the bag policy of a port, ports not declaring one use the default
+ */
+template<typename PORT, typename=void>
+struct bag_policy_of{
+    using type=typename resolve_bag_policy<default_bag_policy, typename PORT::message_type>::type;
+};
+
+template<typename PORT>
+struct bag_policy_of<PORT, decltype(void(std::declval<typename PORT::bag_policy>()))>{
+    using type=typename resolve_bag_policy<typename PORT::bag_policy, typename PORT::message_type>::type;
+};
 
 template<typename PORT>
 struct message_bag{
     using port=PORT;
     using message_type=typename PORT::message_type;
+    using bag_policy=typename bag_policy_of<PORT>::type;
+    using bag_type=typename bag_policy::template container<message_type>;
 
-    bag<message_type> messages;
+    bag_type messages;
 
     message_bag(){}
 
     message_bag(std::initializer_list<message_type> l) : messages{l} {}
+
+    /**
+     * @brief reset removes all messages following the bag_retained_capacity policy of the port
+     */
+    void reset(){
+        bag_policy::reset(messages, bag_retained_capacity<PORT>::value);
+    }
 };
 
 template<typename... Ps>
@@ -57,13 +98,72 @@ struct make_message_bags{
 };
 
 
+//reset all the bags in a tuple of message_bags
+template<typename... Ps>
+void reset_message_bags(std::tuple<message_bag<Ps>...>& mbs){
+    int expand[] = {0, (std::get<message_bag<Ps>>(mbs).reset(), 0)...};
+    (void)expand;
+}
+
+//moves the messages of every bag in from to the end of the bag of the same port in to
+template<typename... Ps>
+void append_message_bags(std::tuple<message_bag<Ps>...>& to, std::tuple<message_bag<Ps>...>& from){
+    int expand[] = {0, (std::get<message_bag<Ps>>(to).messages.insert(std::get<message_bag<Ps>>(to).messages.end(),
+                                                                     std::make_move_iterator(std::get<message_bag<Ps>>(from).messages.begin()),
+                                                                     std::make_move_iterator(std::get<message_bag<Ps>>(from).messages.end())), 0)...};
+    (void)expand;
+}
+
+/**
+ * @brief port_mask has a bit for each bag in a tuple of message_bags, the bits set are the non empty bags
+ * Engines keep it together with their boxes, for checking emptiness in one test and skipping empty ports.
+ */
+template<typename BAGS>
+using port_mask=std::bitset<std::tuple_size<BAGS>::value>;
+
+//position of the bag of a port in a tuple of message_bags
+template<typename PORT, typename BAGS>
+struct port_index;
+
+template<typename PORT, typename... Bs>
+struct port_index<PORT, std::tuple<message_bag<PORT>, Bs...>> : std::integral_constant<std::size_t, 0>{};
+
+template<typename PORT, typename B, typename... Bs>
+struct port_index<PORT, std::tuple<B, Bs...>> : std::integral_constant<std::size_t, 1+port_index<PORT, std::tuple<Bs...>>::value>{};
+
+//tells if any bag in a tuple of message_bags takes its memory from the step arena
+template<typename BAGS>
+struct bags_use_step_arena;
+
+template<>
+struct bags_use_step_arena<std::tuple<>> : std::false_type{};
+
+template<typename P, typename... Ps>
+struct bags_use_step_arena<std::tuple<message_bag<P>, message_bag<Ps>...>>
+: std::integral_constant<bool, std::is_same<typename message_bag<P>::bag_policy, arena_vector_bag_policy>::value
+                               || bags_use_step_arena<std::tuple<message_bag<Ps>...>>::value>{};
+
+template<typename BAGS, std::size_t... Is>
+port_mask<BAGS> non_empty_ports_impl(const BAGS& mbs, std::index_sequence<Is...>){
+    port_mask<BAGS> ret;
+    int expand[] = {0, (ret.set(Is, !std::get<Is>(mbs).messages.empty()), 0)...};
+    (void)expand;
+    return ret;
+}
+
+//finds the port_mask of a tuple of message_bags checking every bag
+template<typename... Ps>
+port_mask<std::tuple<message_bag<Ps>...>> non_empty_ports(const std::tuple<message_bag<Ps>...>& mbs){
+    return non_empty_ports_impl(mbs, std::index_sequence_for<Ps...>{});
+}
+
 template<typename PORT, typename T>
-bag<typename message_bag<PORT>::message_type> & get_messages(T& mbs){
+typename message_bag<PORT>::bag_type & get_messages(T& mbs){
     return std::get<message_bag<PORT>>(mbs).messages;
 }
 
 template<typename PORT, typename T>
-const bag<typename message_bag<PORT>::message_type> & get_messages(const T& mbs){
+const typename message_bag<PORT>::bag_type & get_messages(const T& mbs){
     return std::get<message_bag<PORT>>(mbs).messages;
 }
 
@@ -27,19 +27,24 @@
 #ifndef CADMIUM_PORTS_HPP
 #define CADMIUM_PORTS_HPP
 
+#include <cadmium/modeling/bag_policies.hpp>
+
 namespace cadmium {
 
 enum class port_kind { in, out };
 
-template<typename MSG>
+//BAG_POLICY selects the container keeping the messages of the port, see bag_policies.hpp
+template<typename MSG, typename BAG_POLICY=default_bag_policy>
 struct out_port {
     using message_type=MSG;
+    using bag_policy=BAG_POLICY;
     static constexpr port_kind kind=port_kind::out;
 };
 
-template<typename MSG>
+template<typename MSG, typename BAG_POLICY=default_bag_policy>
 struct in_port {
     using message_type=MSG;
+    using bag_policy=BAG_POLICY;
     static constexpr port_kind kind=port_kind::in;
 };
 
@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CADMIUM_REPLICATION_HPP
+#define CADMIUM_REPLICATION_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cadmium {
+    /**
+     * @brief replication identifies the run of a model among many runs of the same model, as the ones of an ensemble.
+     *
+     * Models are default constructed by the engines, the ones needing a random seed or other per run parameter
+     * read current_replication() in their constructor.
+     */
+    struct replication {
+        std::size_t index;
+        std::uint64_t seed;
+    };
+
+    /**
+     * @brief replication_seed derives the seed of a replication from the seed of the ensemble, the seeds of
+     * consecutive indexes are unrelated (splitmix64).
+     */
+    inline std::uint64_t replication_seed(std::uint64_t ensemble_seed, std::size_t index) noexcept {
+        std::uint64_t z = ensemble_seed + (static_cast<std::uint64_t>(index) + 1) * 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    /**
+     * @brief current_replication is the replication of the models constructed in current thread
+     */
+    inline replication& current_replication() noexcept {
+        static thread_local replication current{0, 0};
+        return current;
+    }
+
+    /**
+     * @brief replication_scope sets the current replication while it is alive
+     */
+    class replication_scope {
+        replication _previous;
+    public:
+        explicit replication_scope(const replication& r) noexcept : _previous(current_replication()) {
+            current_replication() = r;
+        }
+
+        ~replication_scope() {
+            current_replication() = _previous;
+        }
+
+        replication_scope(const replication_scope&) = delete;
+        replication_scope& operator=(const replication_scope&) = delete;
+    };
+}
+
+#endif // CADMIUM_REPLICATION_HPP
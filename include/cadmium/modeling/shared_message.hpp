@@ -0,0 +1,115 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CADMIUM_SHARED_MESSAGE_HPP
+#define CADMIUM_SHARED_MESSAGE_HPP
+
+#include <memory>
+#include <utility>
+#include <ostream>
+#include <cadmium/modeling/ports.hpp>
+
+namespace cadmium {
+    /**
+     * @brief shared_message is a handle to an immutable message shared by all the bags receiving it
+     *
+     * Ports declared with shared_message<T> as message type have their payload allocated once when the
+     * message is created by the output function. Routing the message to multiple destinations copies
+     * only the handle, every receiver reads the same object.
+     * The payload can not be modified after creation, models receiving it need to copy it for changing it.
+     *
+     * @param T the type of the payload
+     */
+    template<typename T>
+    class shared_message {
+        std::shared_ptr<const T> _payload;
+
+    public:
+        using value_type=T;
+
+        //payload is allocated from the value received
+        shared_message(const T& v) : _payload(std::make_shared<const T>(v)) {}
+        shared_message(T&& v) : _payload(std::make_shared<const T>(std::move(v))) {}
+        //payload already allocated
+        explicit shared_message(std::shared_ptr<const T> p) noexcept : _payload(std::move(p)) {}
+
+        const T& get() const noexcept {
+            return *_payload;
+        }
+
+        const T& operator*() const noexcept {
+            return *_payload;
+        }
+
+        const T* operator->() const noexcept {
+            return _payload.get();
+        }
+
+        operator const T&() const noexcept {
+            return *_payload;
+        }
+
+        /**
+         * @brief use_count tells how many bags are holding the payload
+         */
+        long use_count() const noexcept {
+            return _payload.use_count();
+        }
+    };
+
+    /**
+     * @brief make_shared_message builds the payload in place
+     */
+    template<typename T, typename... Args>
+    shared_message<T> make_shared_message(Args&&... args) {
+        return shared_message<T>(std::make_shared<const T>(std::forward<Args>(args)...));
+    }
+
+    template<typename T>
+    bool operator==(const shared_message<T>& lhs, const shared_message<T>& rhs) {
+        return lhs.get() == rhs.get();
+    }
+
+    template<typename T>
+    bool operator!=(const shared_message<T>& lhs, const shared_message<T>& rhs) {
+        return !(lhs == rhs);
+    }
+
+    //messages are displayed by their payload, if the payload can be displayed
+    template<typename T>
+    auto operator<<(std::ostream& os, const shared_message<T>& m) -> decltype(os << m.get()) {
+        return os << m.get();
+    }
+
+    //ports sharing their messages between all receivers
+    template<typename MSG>
+    using shared_out_port=out_port<shared_message<MSG>>;
+
+    template<typename MSG>
+    using shared_in_port=in_port<shared_message<MSG>>;
+}
+
+#endif // CADMIUM_SHARED_MESSAGE_HPP
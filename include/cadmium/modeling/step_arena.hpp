@@ -0,0 +1,202 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CADMIUM_STEP_ARENA_HPP
+#define CADMIUM_STEP_ARENA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+#include <type_traits>
+
+namespace cadmium {
+    /**
+     * @brief step_arena is a monotonic buffer for allocating the messages of a simulation step
+     *
+     * Memory is obtained in chunks and handed out by bumping an offset, deallocation is a nop.
+     * The release function makes all the memory available again in O(1), the chunks are kept for
+     * being reused in next step, so after the first steps no more memory is requested to the system.
+     */
+    class step_arena {
+        struct chunk {
+            std::unique_ptr<unsigned char[]> data;
+            std::size_t size;
+        };
+
+        std::vector<chunk> _chunks;
+        std::size_t _chunk_size;
+        std::size_t _current=0; //chunk in use
+        std::size_t _offset=0; //first free byte in the chunk in use
+
+        //takes the request from the chunk in use aligning its address, nullptr if it does not fit
+        void* fit(std::size_t bytes, std::size_t alignment) noexcept {
+            chunk& c = _chunks[_current];
+            void* p = c.data.get() + _offset;
+            std::size_t space = c.size - _offset;
+            if (!std::align(alignment, bytes, p, space)) {
+                return nullptr;
+            }
+            _offset = c.size - space + bytes;
+            return p;
+        }
+
+    public:
+        static constexpr std::size_t default_chunk_size=64*1024;
+
+        explicit step_arena(std::size_t chunk_size=default_chunk_size) : _chunk_size(chunk_size) {}
+
+        step_arena(const step_arena&) = delete;
+        step_arena& operator=(const step_arena&) = delete;
+
+        void* allocate(std::size_t bytes, std::size_t alignment) {
+            while (_current < _chunks.size()) {
+                if (void* p = fit(bytes, alignment)) {
+                    return p;
+                }
+                ++_current;
+                _offset = 0;
+            }
+            //no chunk can hold the request, a new one is added at the end with room for aligning it
+            std::size_t size = std::max(_chunk_size, bytes + alignment);
+            _chunks.push_back(chunk{std::unique_ptr<unsigned char[]>(new unsigned char[size]), size});
+            _current = _chunks.size() - 1;
+            return fit(bytes, alignment);
+        }
+
+        /**
+         * @brief release makes all the memory allocated from the arena available again
+         * Everything allocated before the release can not be used after it.
+         */
+        void release() noexcept {
+            _current = 0;
+            _offset = 0;
+        }
+
+        /**
+         * @brief capacity tells the bytes reserved from the system for the arena
+         */
+        std::size_t capacity() const noexcept {
+            std::size_t ret = 0;
+            for (const auto& c : _chunks) {
+                ret += c.size;
+            }
+            return ret;
+        }
+    };
+
+    /**
+     * @brief current_step_arena is the arena used by the bags created in current thread
+     * When no arena is installed (nullptr) the bags are allocated in the heap.
+     */
+    inline step_arena*& current_step_arena() noexcept {
+        static thread_local step_arena* arena=nullptr;
+        return arena;
+    }
+
+    /**
+     * @brief step_arena_scope installs an arena for the bags created while it is alive and releases
+     * the arena when destroyed.
+     */
+    class step_arena_scope {
+        step_arena* _arena;
+        step_arena* _previous;
+    public:
+        explicit step_arena_scope(step_arena* arena) noexcept : _arena(arena), _previous(current_step_arena()) {
+            current_step_arena() = arena;
+        }
+
+        ~step_arena_scope() {
+            current_step_arena() = _previous;
+            if (_arena) {
+                _arena->release();
+            }
+        }
+
+        step_arena_scope(const step_arena_scope&) = delete;
+        step_arena_scope& operator=(const step_arena_scope&) = delete;
+    };
+
+    /**
+     * @brief bag_allocator takes memory from the arena installed at the time the bag was created,
+     * or from the heap if there was none.
+     *
+     * Copies of a bag are allocated in the heap, so messages can be kept after the step ends by copying
+     * the bag. Assigning and swapping bags moves the allocator with the memory.
+     */
+    template<typename T>
+    class bag_allocator {
+        template<typename U> friend class bag_allocator;
+        step_arena* _arena;
+
+    public:
+        using value_type=T;
+        using propagate_on_container_copy_assignment=std::false_type;
+        using propagate_on_container_move_assignment=std::true_type;
+        using propagate_on_container_swap=std::true_type;
+
+        bag_allocator() noexcept : _arena(current_step_arena()) {}
+
+        explicit bag_allocator(step_arena* arena) noexcept : _arena(arena) {}
+
+        template<typename U>
+        bag_allocator(const bag_allocator<U>& other) noexcept : _arena(other._arena) {}
+
+        T* allocate(std::size_t n) {
+            if (_arena) {
+                return static_cast<T*>(_arena->allocate(n * sizeof(T), alignof(T)));
+            }
+            return std::allocator<T>().allocate(n);
+        }
+
+        void deallocate(T* p, std::size_t n) noexcept {
+            if (!_arena) {
+                std::allocator<T>().deallocate(p, n);
+            } //memory in arenas is released all together
+        }
+
+        bag_allocator select_on_container_copy_construction() const noexcept {
+            return bag_allocator(nullptr);
+        }
+
+        step_arena* arena() const noexcept {
+            return _arena;
+        }
+
+        template<typename U>
+        bool operator==(const bag_allocator<U>& other) const noexcept {
+            return _arena == other._arena;
+        }
+
+        template<typename U>
+        bool operator!=(const bag_allocator<U>& other) const noexcept {
+            return _arena != other._arena;
+        }
+    };
+}
+
+#endif // CADMIUM_STEP_ARENA_HPP
@@ -0,0 +1,206 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CADMIUM_TIME_HPP
+#define CADMIUM_TIME_HPP
+
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <ratio>
+#include <stdexcept>
+#include <type_traits>
+
+/**
+ * Time types counting ticks in an int64
+ *
+ * Comparing and adding integers is exact and cheap, so simultaneous events are found by == without rounding errors
+ * and every thread or partition computes the same times. The largest count is reserved for infinity, which
+ * absorbs additions and saturates overflows, as the engines and basic models expect from
+ * std::numeric_limits<TIME>::infinity().
+ * Values are built from seconds, integers are converted exactly and floating point values are rounded to the
+ * nearest tick, so models written for float time work unchanged.
+ */
+namespace cadmium {
+    namespace time {
+        /**
+         * @brief ticks counts time in ticks of RESOLUTION seconds, by default nanoseconds
+         */
+        template<typename RESOLUTION=std::nano>
+        class ticks {
+            static_assert(RESOLUTION::num > 0 && RESOLUTION::den > 0, "The resolution of ticks needs to be positive");
+
+            std::int64_t _count;
+
+            static constexpr std::int64_t infinite_count=std::numeric_limits<std::int64_t>::max();
+            static constexpr std::int64_t max_count=infinite_count - 1;
+            static constexpr std::int64_t min_count=-max_count;
+
+            struct count_tag {};
+
+            constexpr ticks(std::int64_t count, count_tag) noexcept : _count(count) {}
+
+            //counts out of the finite range saturate to infinity, or to the lowest finite count
+            static constexpr ticks saturated(long double count) noexcept {
+                return count >= static_cast<long double>(infinite_count) ? ticks(infinite_count, count_tag{})
+                     : count <= static_cast<long double>(min_count) ? ticks(min_count, count_tag{})
+                     : ticks(static_cast<std::int64_t>(count < 0 ? count - 0.5L : count + 0.5L), count_tag{});
+            }
+
+        public:
+            using rep=std::int64_t;
+            using period=RESOLUTION;
+
+            /**
+             * @brief the default value is zero, as models expect from TIME{}
+             */
+            constexpr ticks() noexcept : _count(0) {}
+
+            /**
+             * @brief ticks converts whole seconds exactly, saturating to infinity if out of range
+             */
+            template<typename INTEGER, typename=typename std::enable_if<std::is_integral<INTEGER>::value>::type>
+            constexpr ticks(INTEGER seconds) noexcept
+            : ticks(RESOLUTION::num == 1 && static_cast<long double>(seconds) * RESOLUTION::den < static_cast<long double>(infinite_count)
+                    && static_cast<long double>(seconds) * RESOLUTION::den > static_cast<long double>(min_count)
+                    ? ticks(static_cast<std::int64_t>(seconds) * RESOLUTION::den, count_tag{})
+                    : saturated(static_cast<long double>(seconds) * RESOLUTION::den / RESOLUTION::num)) {}
+
+            /**
+             * @brief ticks rounds seconds to the nearest tick, infinity is kept and NaN is rejected
+             */
+            constexpr ticks(double seconds)
+            : ticks(seconds != seconds ? throw std::domain_error("Times can not be NaN")
+                    : saturated(static_cast<long double>(seconds) * RESOLUTION::den / RESOLUTION::num)) {}
+
+            /**
+             * @brief from_count builds a time of count ticks
+             */
+            static constexpr ticks from_count(std::int64_t count) noexcept {
+                return count == std::numeric_limits<std::int64_t>::min() ? ticks(min_count, count_tag{}) : ticks(count, count_tag{});
+            }
+
+            static constexpr ticks infinity() noexcept {
+                return ticks(infinite_count, count_tag{});
+            }
+
+            constexpr std::int64_t count() const noexcept {
+                return _count;
+            }
+
+            constexpr bool is_infinity() const noexcept {
+                return _count == infinite_count;
+            }
+
+            /**
+             * @brief converts to seconds
+             */
+            explicit constexpr operator double() const noexcept {
+                return is_infinity() ? std::numeric_limits<double>::infinity()
+                                     : static_cast<double>(static_cast<long double>(_count) * RESOLUTION::num / RESOLUTION::den);
+            }
+
+            ticks& operator+=(const ticks& o) noexcept {
+                if (is_infinity() || o.is_infinity() || (o._count > 0 && _count > max_count - o._count)) {
+                    _count = infinite_count;
+                } else if (o._count < 0 && _count < min_count - o._count) {
+                    _count = min_count;
+                } else {
+                    _count += o._count;
+                }
+                return *this;
+            }
+
+            /**
+             * @brief subtracting from infinity gives infinity, subtracting infinity is an error
+             */
+            ticks& operator-=(const ticks& o) {
+                if (o.is_infinity()) {
+                    throw std::domain_error("Subtracting an infinite time");
+                }
+                return *this += ticks(-o._count, count_tag{});
+            }
+
+            friend ticks operator+(ticks a, const ticks& b) noexcept {
+                return a += b;
+            }
+
+            friend ticks operator-(ticks a, const ticks& b) {
+                return a -= b;
+            }
+
+            friend constexpr bool operator==(const ticks& a, const ticks& b) noexcept { return a._count == b._count; }
+            friend constexpr bool operator!=(const ticks& a, const ticks& b) noexcept { return a._count != b._count; }
+            friend constexpr bool operator<(const ticks& a, const ticks& b) noexcept { return a._count < b._count; }
+            friend constexpr bool operator>(const ticks& a, const ticks& b) noexcept { return a._count > b._count; }
+            friend constexpr bool operator<=(const ticks& a, const ticks& b) noexcept { return a._count <= b._count; }
+            friend constexpr bool operator>=(const ticks& a, const ticks& b) noexcept { return a._count >= b._count; }
+
+            /**
+             * @brief times are printed in seconds
+             */
+            friend std::ostream& operator<<(std::ostream& os, const ticks& t) {
+                return os << static_cast<double>(t);
+            }
+        };
+
+        template<int FRACTION_BITS>
+        struct fixed_point_resolution {
+            static_assert(FRACTION_BITS >= 0 && FRACTION_BITS < 63, "The denominator of the resolution must fit in an int64");
+            using type=std::ratio<1, (std::int64_t(1) << FRACTION_BITS)>;
+        };
+
+        /**
+         * @brief fixed_point is a time with FRACTION_BITS binary digits after the point of the seconds
+         */
+        template<int FRACTION_BITS>
+        using fixed_point=ticks<typename fixed_point_resolution<FRACTION_BITS>::type>;
+    }
+}
+
+namespace std {
+    template<typename RESOLUTION>
+    class numeric_limits<cadmium::time::ticks<RESOLUTION>> : public numeric_limits<std::int64_t> {
+        using ticks=cadmium::time::ticks<RESOLUTION>;
+    public:
+        static constexpr bool is_integer=false;
+        static constexpr bool has_infinity=true;
+        static constexpr bool is_modulo=false;
+
+        //as for floating point types, min is the smallest positive value
+        static constexpr ticks min() noexcept { return epsilon(); }
+        static constexpr ticks lowest() noexcept { return ticks::from_count(-numeric_limits<std::int64_t>::max() + 1); }
+        static constexpr ticks max() noexcept { return ticks::from_count(numeric_limits<std::int64_t>::max() - 1); }
+        static constexpr ticks epsilon() noexcept { return ticks::from_count(1); }
+        static constexpr ticks round_error() noexcept { return ticks::from_count(0); }
+        static constexpr ticks infinity() noexcept { return ticks::infinity(); }
+        static constexpr ticks quiet_NaN() noexcept { return ticks::from_count(0); }
+        static constexpr ticks signaling_NaN() noexcept { return ticks::from_count(0); }
+        static constexpr ticks denorm_min() noexcept { return min(); }
+    };
+}
+
+#endif // CADMIUM_TIME_HPP
@@ -0,0 +1,207 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <cadmium/logger/tuple_to_ostream.hpp>
+#include <cadmium/basic_model/accumulator.hpp>
+#include <cadmium/engine/event_trace.hpp>
+#include <cadmium/engine/pdevs_runner.hpp>
+
+/**
+ * This test checks binary traces of input events are read back and replayed into runners
+ */
+
+namespace {
+    //a trace file removed at the end of the test
+    struct temporary_trace {
+        std::string path;
+
+        temporary_trace() {
+            char name[]="/tmp/cadmium_trace_XXXXXX";
+            int fd=mkstemp(name);
+            BOOST_REQUIRE(fd >= 0);
+            close(fd);
+            path=name;
+        }
+
+        ~temporary_trace() {
+            unlink(path.c_str());
+        }
+    };
+}
+
+BOOST_AUTO_TEST_SUITE( event_trace_test_suite )
+
+template<typename TIME>
+using test_accumulator=cadmium::basic_models::accumulator<int, TIME>;
+using test_accumulator_defs=cadmium::basic_models::accumulator_defs<int>;
+using accumulator_ports=test_accumulator<float>::input_ports;
+using reset_tick=test_accumulator_defs::reset_tick;
+
+BOOST_AUTO_TEST_CASE( records_are_read_in_steps_test ){
+    temporary_trace file;
+    {
+        cadmium::engine::trace_writer<float, accumulator_ports> w(file.path);
+        w.write<test_accumulator_defs::add>(1.0f, 1);
+        w.write<test_accumulator_defs::add>(1.0f, 2);
+        w.write<test_accumulator_defs::reset>(1.0f, reset_tick{});
+        w.write<test_accumulator_defs::add>(2.5f, 3);
+        w.close();
+    }
+    cadmium::engine::trace_reader<float, accumulator_ports> r(file.path);
+    for (int pass = 0; pass < 2; ++pass) {
+        BOOST_REQUIRE(!r.done());
+        BOOST_CHECK_EQUAL(r.next_time(), 1.0f);
+        cadmium::make_message_bags<accumulator_ports>::type bags;
+        r.read_step(bags);
+        auto& adds = cadmium::get_messages<test_accumulator_defs::add>(bags);
+        BOOST_CHECK((std::vector<int>(adds.begin(), adds.end()) == std::vector<int>{1, 2}));
+        BOOST_CHECK_EQUAL(cadmium::get_messages<test_accumulator_defs::reset>(bags).size(), 1);
+        BOOST_CHECK_EQUAL(r.next_time(), 2.5f);
+        r.read_step(bags);
+        BOOST_CHECK((std::vector<int>(adds.begin(), adds.end()) == std::vector<int>{1, 2, 3}));
+        BOOST_CHECK(r.done());
+        r.rewind();
+    }
+}
+
+BOOST_AUTO_TEST_CASE( malformed_traces_are_rejected_test ){
+    temporary_trace file;
+    {
+        cadmium::engine::trace_writer<float, accumulator_ports> w(file.path);
+        w.write<test_accumulator_defs::add>(2.0f, 1);
+        w.write<test_accumulator_defs::add>(1.0f, 2);
+        w.close();
+    }
+    //another model
+    using other_ports=std::tuple<test_accumulator_defs::add>;
+    BOOST_CHECK_THROW((cadmium::engine::trace_reader<float, other_ports>(file.path)), std::domain_error);
+    BOOST_CHECK_THROW((cadmium::engine::trace_reader<double, accumulator_ports>(file.path)), std::domain_error);
+    {
+        //records out of order
+        cadmium::engine::trace_reader<float, accumulator_ports> r(file.path);
+        cadmium::make_message_bags<accumulator_ports>::type bags;
+        BOOST_CHECK_THROW(r.read_step(bags), std::domain_error);
+    }
+    //a record cut
+    BOOST_REQUIRE_EQUAL(truncate(file.path.c_str(), 16 + 8 + 2), 0);
+    {
+        cadmium::engine::trace_reader<float, accumulator_ports> r(file.path);
+        cadmium::make_message_bags<accumulator_ports>::type bags;
+        BOOST_CHECK_THROW(r.read_step(bags), std::domain_error);
+    }
+    BOOST_CHECK_THROW((cadmium::engine::trace_reader<float, accumulator_ports>(file.path + ".missing")), std::system_error);
+}
+
+BOOST_AUTO_TEST_CASE( runner_replays_a_trace_test ){
+    temporary_trace file;
+    {
+        cadmium::engine::trace_writer<float, accumulator_ports> w(file.path);
+        for (int i = 1; i <= 1000; ++i) {
+            w.write<test_accumulator_defs::add>(static_cast<float>(i), i);
+            if (i % 100 == 0) {
+                w.write<test_accumulator_defs::reset>(i + 0.5f, reset_tick{});
+            }
+        }
+        w.close();
+    }
+    cadmium::engine::trace_reader<float, accumulator_ports> trace(file.path);
+    cadmium::engine::runner<float, test_accumulator, cadmium::logger::not_logger> r{0.0f};
+    r.replay(trace);
+    //trace and injected inputs are received together
+    r.inject<test_accumulator_defs::add>(50.0f, {1000});
+    std::vector<std::pair<float, int>> sums;
+    r.runUntilPassivate([&sums](const float& t, const std::tuple<cadmium::message_bag<test_accumulator_defs::sum>>& bags) {
+        sums.emplace_back(t, cadmium::get_messages<test_accumulator_defs::sum>(bags).at(0));
+    });
+    BOOST_REQUIRE_EQUAL(sums.size(), 10);
+    BOOST_CHECK_EQUAL(sums[0].first, 100.5f);
+    BOOST_CHECK_EQUAL(sums[0].second, 5050 + 1000);
+    BOOST_CHECK_EQUAL(sums[9].first, 1000.5f);
+    BOOST_CHECK_EQUAL(sums[9].second, 95050);
+    BOOST_CHECK(trace.done());
+}
+
+BOOST_AUTO_TEST_CASE( runner_outputs_go_to_the_sink_test ){
+    using sum_bags=std::tuple<cadmium::message_bag<test_accumulator_defs::sum>>;
+    using runner_type=cadmium::engine::runner<float, test_accumulator, cadmium::logger::not_logger>;
+    runner_type r{0.0f};
+    std::vector<std::pair<float, int>> sums;
+    r.output_to([&sums](const float& t, const sum_bags& bags) {
+        sums.emplace_back(t, cadmium::get_messages<test_accumulator_defs::sum>(bags).at(0));
+    });
+    r.inject<test_accumulator_defs::add>(1.0f, {3});
+    r.inject<test_accumulator_defs::reset>(2.0f, {reset_tick{}});
+    r.inject<test_accumulator_defs::reset>(4.0f, {reset_tick{}});
+    r.runUntil(3.0f);
+    //the reset and the output of the sum are two steps at time 4
+    r.runFor(2);
+    //a handler given to the run takes the place of the sink
+    int handled = 0;
+    r.inject<test_accumulator_defs::reset>(6.0f, {reset_tick{}});
+    r.runUntilPassivate([&handled](const float&, const sum_bags&) { ++handled; });
+    BOOST_CHECK((sums == std::vector<std::pair<float, int>>{{2.0f, 3}, {4.0f, 0}}));
+    BOOST_CHECK_EQUAL(handled, 1);
+}
+
+BOOST_AUTO_TEST_CASE( runner_outputs_are_written_to_a_trace_test ){
+    using output_ports=test_accumulator<float>::output_ports;
+    temporary_trace file;
+    {
+        cadmium::engine::trace_writer<float, output_ports> w(file.path, 64);
+        cadmium::engine::runner<float, test_accumulator, cadmium::logger::not_logger> r{0.0f};
+        r.output_to(w);
+        for (int i = 1; i <= 100; ++i) {
+            r.inject<test_accumulator_defs::add>(static_cast<float>(i), {i});
+            r.inject<test_accumulator_defs::reset>(i + 0.5f, {reset_tick{}});
+        }
+        r.runUntilPassivate();
+        w.close();
+    }
+    //the trace of outputs can be read back as any other
+    cadmium::engine::trace_reader<float, output_ports> trace(file.path);
+    int steps = 0;
+    while (!trace.done()) {
+        ++steps;
+        BOOST_CHECK_EQUAL(trace.next_time(), steps + 0.5f);
+        cadmium::make_message_bags<output_ports>::type bags;
+        trace.read_step(bags);
+        auto& sums = cadmium::get_messages<test_accumulator_defs::sum>(bags);
+        BOOST_REQUIRE_EQUAL(sums.size(), 1);
+        BOOST_CHECK_EQUAL(sums[0], steps);
+    }
+    BOOST_CHECK_EQUAL(steps, 100);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
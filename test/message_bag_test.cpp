@@ -0,0 +1,185 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/message_bag.hpp>
+#include <cadmium/modeling/step_arena.hpp>
+#include <cadmium/modeling/coupled_model.hpp>
+#include <cadmium/basic_model/generator.hpp>
+#include <cadmium/engine/pdevs_coordinator.hpp>
+
+/**
+ * This test is for resetting message bags
+ */
+struct small_port : public cadmium::in_port<int>{};
+struct burst_port : public cadmium::in_port<int>{};
+struct inline_port : public cadmium::in_port<int, cadmium::small_vector_bag_policy<2>>{};
+struct fixed_port : public cadmium::in_port<int, cadmium::static_vector_bag_policy<4>>{};
+struct deque_port : public cadmium::in_port<int, cadmium::deque_bag_policy>{};
+struct tick{};
+struct tick_port : public cadmium::in_port<tick>{};
+struct stored_tick_port : public cadmium::in_port<tick, cadmium::vector_bag_policy>{};
+
+namespace cadmium {
+    template<>
+    struct bag_retained_capacity<burst_port>{
+        static constexpr std::size_t value=1024;
+    };
+}
+
+BOOST_AUTO_TEST_SUITE( message_bag_test_suite )
+
+BOOST_AUTO_TEST_CASE( reset_keeps_capacity_up_to_the_cap_test ){
+    cadmium::bag<int> b{1, 2, 3};
+    auto capacity = b.capacity();
+    cadmium::reset_bag(b, 10);
+    BOOST_CHECK(b.empty());
+    BOOST_CHECK_EQUAL(b.capacity(), capacity);
+
+    //a burst larger than the cap releases the memory
+    b.resize(11);
+    cadmium::reset_bag(b, 10);
+    BOOST_CHECK(b.empty());
+    BOOST_CHECK_EQUAL(b.capacity(), 0);
+}
+
+BOOST_AUTO_TEST_CASE( reset_releases_arena_memory_test ){
+    cadmium::step_arena arena;
+    cadmium::step_arena_scope scope(&arena);
+    cadmium::arena_bag<int> b{1, 2, 3};
+    cadmium::reset_bag(b, 10);
+    BOOST_CHECK(b.empty());
+    BOOST_CHECK_EQUAL(b.capacity(), 0);
+}
+
+BOOST_AUTO_TEST_CASE( reset_message_bags_uses_the_port_policy_test ){
+    std::tuple<cadmium::message_bag<small_port>, cadmium::message_bag<burst_port>> mbs;
+    cadmium::get_messages<small_port>(mbs).resize(CADMIUM_BAG_RETAINED_CAPACITY + 1);
+    cadmium::get_messages<burst_port>(mbs).resize(CADMIUM_BAG_RETAINED_CAPACITY + 1);
+    cadmium::reset_message_bags(mbs);
+    BOOST_CHECK(cadmium::get_messages<small_port>(mbs).empty());
+    BOOST_CHECK(cadmium::get_messages<burst_port>(mbs).empty());
+    BOOST_CHECK_EQUAL(cadmium::get_messages<small_port>(mbs).capacity(), 0);
+    BOOST_CHECK(cadmium::get_messages<burst_port>(mbs).capacity() > CADMIUM_BAG_RETAINED_CAPACITY);
+}
+
+BOOST_AUTO_TEST_CASE( ports_select_the_container_of_their_bags_test ){
+    using mbs_type=cadmium::make_message_bags<std::tuple<small_port, inline_port, fixed_port, deque_port>>::type;
+    BOOST_CHECK((std::is_same<cadmium::message_bag<small_port>::bag_type, cadmium::bag<int>>::value));
+    BOOST_CHECK((std::is_same<cadmium::message_bag<inline_port>::bag_type, boost::container::small_vector<int, 2>>::value));
+    BOOST_CHECK((std::is_same<cadmium::message_bag<fixed_port>::bag_type, boost::container::static_vector<int, 4>>::value));
+    BOOST_CHECK((std::is_same<cadmium::message_bag<deque_port>::bag_type, std::deque<int>>::value));
+
+    mbs_type mbs;
+    cadmium::get_messages<inline_port>(mbs) = {1, 2};
+    cadmium::get_messages<fixed_port>(mbs) = {1, 2, 3, 4};
+    cadmium::get_messages<deque_port>(mbs) = {1, 2, 3};
+    cadmium::reset_message_bags(mbs);
+    BOOST_CHECK(cadmium::get_messages<inline_port>(mbs).empty());
+    BOOST_CHECK_EQUAL(cadmium::get_messages<inline_port>(mbs).capacity(), 2);
+    BOOST_CHECK(cadmium::get_messages<fixed_port>(mbs).empty());
+    BOOST_CHECK(cadmium::get_messages<deque_port>(mbs).empty());
+}
+
+//routing between ports using different containers
+struct inline_out : public cadmium::out_port<float, cadmium::small_vector_bag_policy<1>>{};
+struct deque_out : public cadmium::out_port<float, cadmium::deque_bag_policy>{};
+
+template<typename TIME>
+struct float_generator : public cadmium::basic_models::generator<float, TIME> {
+    float period() const override {
+        return 1.0f;
+    }
+    float output_message() const override {
+        return 5.0f;
+    }
+};
+
+using generator_out=cadmium::basic_models::generator_defs<float>::out;
+using mixed_eocs=std::tuple<
+cadmium::modeling::EOC<float_generator, generator_out, inline_out>,
+cadmium::modeling::EOC<float_generator, generator_out, deque_out>
+>;
+template<typename TIME>
+using mixed_bags_model=cadmium::modeling::coupled_model<TIME, std::tuple<>, std::tuple<inline_out, deque_out>, cadmium::modeling::models_tuple<float_generator>, std::tuple<>, mixed_eocs, std::tuple<>>;
+
+BOOST_AUTO_TEST_CASE( messages_are_routed_between_different_containers_test ){
+    cadmium::engine::coordinator<mixed_bags_model, float, cadmium::logger::not_logger, cadmium::engine::heap_fel> cc;
+    cc.init(0);
+    cc.collect_outputs(1.0f);
+    BOOST_REQUIRE_EQUAL(cadmium::get_messages<inline_out>(cc.outbox()).size(), 1);
+    BOOST_CHECK_EQUAL(cadmium::get_messages<inline_out>(cc.outbox()).at(0), 5.0f);
+    BOOST_REQUIRE_EQUAL(cadmium::get_messages<deque_out>(cc.outbox()).size(), 1);
+    BOOST_CHECK_EQUAL(cadmium::get_messages<deque_out>(cc.outbox()).at(0), 5.0f);
+}
+
+BOOST_AUTO_TEST_CASE( ports_of_empty_messages_only_count_them_test ){
+    BOOST_CHECK((std::is_same<cadmium::message_bag<tick_port>::bag_type, cadmium::counted_bag<tick>>::value));
+    //selecting a policy explicitly overrides the counting
+    BOOST_CHECK((std::is_same<cadmium::message_bag<stored_tick_port>::bag_type, cadmium::bag<tick>>::value));
+
+    std::tuple<cadmium::message_bag<tick_port>> mbs;
+    auto& ticks = cadmium::get_messages<tick_port>(mbs);
+    BOOST_CHECK(ticks.empty());
+    ticks.emplace_back();
+    ticks.push_back(tick{});
+    BOOST_CHECK_EQUAL(ticks.size(), 2);
+    int iterated = 0;
+    for (const auto& t : ticks) {
+        (void)t;
+        ++iterated;
+    }
+    BOOST_CHECK_EQUAL(iterated, 2);
+    BOOST_CHECK_THROW(ticks.at(2), std::out_of_range);
+
+    //appending ticks from another bag
+    cadmium::counted_bag<tick> more{tick{}, tick{}, tick{}};
+    ticks.insert(ticks.end(), more.begin(), more.end());
+    BOOST_CHECK_EQUAL(ticks.size(), 5);
+
+    cadmium::reset_message_bags(mbs);
+    BOOST_CHECK(ticks.empty());
+}
+
+BOOST_AUTO_TEST_CASE( port_mask_has_the_non_empty_ports_test ){
+    using mbs_type=cadmium::make_message_bags<std::tuple<small_port, tick_port, deque_port>>::type;
+    BOOST_CHECK_EQUAL((cadmium::port_index<small_port, mbs_type>::value), 0);
+    BOOST_CHECK_EQUAL((cadmium::port_index<deque_port, mbs_type>::value), 2);
+
+    mbs_type mbs;
+    BOOST_CHECK(cadmium::non_empty_ports(mbs).none());
+    cadmium::get_messages<tick_port>(mbs).emplace_back();
+    cadmium::get_messages<deque_port>(mbs) = {1};
+    auto mask = cadmium::non_empty_ports(mbs);
+    BOOST_CHECK(!mask.test(0));
+    BOOST_CHECK(mask.test(1));
+    BOOST_CHECK(mask.test(2));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,175 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <deque>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <cadmium/logger/tuple_to_ostream.hpp>
+#include <cadmium/basic_model/int_generator_one_sec.hpp>
+#include <cadmium/basic_model/reset_generator_five_sec.hpp>
+#include <cadmium/basic_model/accumulator.hpp>
+#include <cadmium/modeling/checkpoint.hpp>
+#include <cadmium/modeling/coupled_model.hpp>
+#include <cadmium/engine/pdevs_runner.hpp>
+
+/**
+ * This test checks runners restored from a checkpoint continue as the runner saved
+ */
+
+namespace {
+    std::ostringstream oss;
+
+    struct oss_sink_provider{
+        static std::ostream& sink(){
+            return oss;
+        }
+    };
+
+    //the lines logged since last call
+    std::string take_log(){
+        std::string ret = oss.str();
+        oss.str("");
+        return ret;
+    }
+
+    using log_states=cadmium::logger::logger<cadmium::logger::logger_state, cadmium::logger::verbatim_formatter, oss_sink_provider>;
+
+    template<typename T>
+    T round_trip(const T& value) {
+        std::stringstream ss;
+        cadmium::checkpoint_writer w(ss);
+        w.write(value);
+        cadmium::checkpoint_reader r(ss);
+        T ret;
+        r.read(ret);
+        return ret;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE( pdevs_checkpoint_test_suite )
+
+BOOST_AUTO_TEST_CASE( serializer_round_trip_test ){
+    BOOST_CHECK_EQUAL(round_trip(42), 42);
+    BOOST_CHECK_EQUAL(round_trip(2.5f), 2.5f);
+    BOOST_CHECK((round_trip(std::make_tuple(3, true, std::string("three"))) == std::make_tuple(3, true, std::string("three"))));
+    BOOST_CHECK((round_trip(std::make_pair(std::string("a"), 1.5)) == std::make_pair(std::string("a"), 1.5)));
+    std::vector<std::deque<std::string>> nested{{"x", "y"}, {}, {"z"}};
+    BOOST_CHECK(round_trip(nested) == nested);
+}
+
+BOOST_AUTO_TEST_CASE( reader_rejects_truncated_input_test ){
+    std::stringstream ss;
+    cadmium::checkpoint_writer w(ss);
+    w.write(std::vector<int>{1, 2, 3});
+    std::string bytes = ss.str();
+    std::istringstream truncated(bytes.substr(0, bytes.size() - 2));
+    cadmium::checkpoint_reader r(truncated);
+    std::vector<int> v;
+    BOOST_CHECK_THROW(r.read(v), std::domain_error);
+}
+
+template<typename TIME>
+using test_accumulator=cadmium::basic_models::accumulator<int, TIME>;
+using test_accumulator_defs=cadmium::basic_models::accumulator_defs<int>;
+
+//generators inside a coupled model feeding an accumulator
+struct generators_int_out : public cadmium::out_port<int>{};
+struct generators_reset_out : public cadmium::out_port<test_accumulator_defs::reset_tick>{};
+using generators_submodels=cadmium::modeling::models_tuple<cadmium::basic_models::reset_generator_five_sec, cadmium::basic_models::int_generator_one_sec>;
+using generators_eocs=std::tuple<
+cadmium::modeling::EOC<cadmium::basic_models::int_generator_one_sec, cadmium::basic_models::int_generator_one_sec_defs::out, generators_int_out>,
+cadmium::modeling::EOC<cadmium::basic_models::reset_generator_five_sec, cadmium::basic_models::reset_generator_five_sec_defs::out, generators_reset_out>
+>;
+template<typename TIME>
+using generators_model=cadmium::modeling::coupled_model<TIME, std::tuple<>, std::tuple<generators_int_out, generators_reset_out>, generators_submodels, std::tuple<>, generators_eocs, std::tuple<>>;
+
+struct top_out : public cadmium::out_port<int>{};
+using top_submodels=cadmium::modeling::models_tuple<generators_model, test_accumulator>;
+using top_eocs=std::tuple<
+cadmium::modeling::EOC<test_accumulator, test_accumulator_defs::sum, top_out>
+>;
+using top_ics=std::tuple<
+cadmium::modeling::IC<generators_model, generators_int_out, test_accumulator, test_accumulator_defs::add>,
+cadmium::modeling::IC<generators_model, generators_reset_out, test_accumulator, test_accumulator_defs::reset>
+>;
+template<typename TIME>
+using top_model=cadmium::modeling::coupled_model<TIME, std::tuple<>, std::tuple<top_out>, top_submodels, std::tuple<>, top_eocs, top_ics>;
+
+template<template<template<typename> class, typename, typename, template<typename> class> class ENGINE>
+void check_restored_runner_continues(){
+    using runner_type=cadmium::engine::runner<float, top_model, log_states, cadmium::engine::heap_fel, ENGINE>;
+    runner_type original{0.0f};
+    original.runUntil(12.5f);
+    std::stringstream snapshot;
+    original.save(snapshot);
+    std::string saved = snapshot.str();
+    take_log();
+
+    float original_next = original.runUntil(30.0f);
+    std::string original_log = take_log();
+    BOOST_REQUIRE(!original_log.empty());
+
+    //many runners can be restored from the same snapshot
+    for (int i = 0; i < 2; ++i) {
+        std::istringstream is(saved);
+        runner_type restored{is};
+        BOOST_CHECK_EQUAL(restored.runUntil(30.0f), original_next);
+        BOOST_CHECK_EQUAL(take_log(), original_log);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( restored_coordinator_continues_test ){
+    check_restored_runner_continues<cadmium::engine::coordinator>();
+}
+
+BOOST_AUTO_TEST_CASE( restored_flat_coordinator_continues_test ){
+    check_restored_runner_continues<cadmium::engine::flat_coordinator>();
+}
+
+BOOST_AUTO_TEST_CASE( restore_rejects_other_engines_test ){
+    cadmium::engine::runner<float, top_model, log_states> original{0.0f};
+    original.runUntil(3.0f);
+    std::stringstream snapshot;
+    original.save(snapshot);
+    std::string saved = snapshot.str();
+    take_log();
+
+    std::istringstream for_flat(saved);
+    using flat_runner=cadmium::engine::runner<float, top_model, log_states, cadmium::engine::heap_fel, cadmium::engine::flat_coordinator>;
+    BOOST_CHECK_THROW(flat_runner{for_flat}, std::domain_error);
+
+    std::istringstream truncated(saved.substr(0, saved.size() / 2));
+    using same_runner=cadmium::engine::runner<float, top_model, log_states>;
+    BOOST_CHECK_THROW(same_runner{truncated}, std::domain_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,240 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <cadmium/logger/tuple_to_ostream.hpp>
+#include <cadmium/basic_model/int_generator_one_sec.hpp>
+#include <cadmium/basic_model/reset_generator_five_sec.hpp>
+#include <cadmium/basic_model/accumulator.hpp>
+#include <cadmium/modeling/coupled_model.hpp>
+#include <cadmium/modeling/lookahead.hpp>
+#include <cadmium/engine/pdevs_runner.hpp>
+#include <cadmium/engine/pdevs_conservative_runner.hpp>
+
+/**
+ * This test checks the conservative runner gives the states of the runner
+ */
+
+namespace {
+    //every thread logs to its own stream, so the logger can be used from many threads
+    std::mutex streams_mutex;
+    std::vector<std::shared_ptr<std::ostringstream>> streams;
+
+    struct per_thread_sink_provider{
+        static std::ostream& sink(){
+            thread_local std::shared_ptr<std::ostringstream> stream=[]() {
+                auto s = std::make_shared<std::ostringstream>();
+                std::lock_guard<std::mutex> lock(streams_mutex);
+                streams.push_back(s);
+                return s;
+            }();
+            return *stream;
+        }
+    };
+
+    //the lines logged by all threads since last call, sorted
+    std::vector<std::string> take_logged_lines(){
+        std::vector<std::string> lines;
+        std::lock_guard<std::mutex> lock(streams_mutex);
+        for (auto& s : streams) {
+            std::istringstream iss(s->str());
+            for (std::string line; std::getline(iss, line);) {
+                lines.push_back(line);
+            }
+            s->str("");
+        }
+        std::sort(lines.begin(), lines.end());
+        return lines;
+    }
+
+    using log_states_per_thread=cadmium::logger::logger<cadmium::logger::logger_state, cadmium::logger::verbatim_formatter, per_thread_sink_provider>;
+}
+
+namespace cadmium {
+    namespace engine {
+        template<>
+        struct parallel_safe_logger<log_states_per_thread> : std::true_type{};
+    }
+}
+
+BOOST_AUTO_TEST_SUITE( pdevs_conservative_runner_test_suite )
+
+template<typename TIME>
+using test_accumulator=cadmium::basic_models::accumulator<int, TIME>;
+using test_accumulator_defs=cadmium::basic_models::accumulator_defs<int>;
+
+//generators feeding an accumulator, each submodel in a partition
+struct g2a_out : public cadmium::out_port<int>{};
+using g2a_submodels=cadmium::modeling::models_tuple<cadmium::basic_models::reset_generator_five_sec, cadmium::basic_models::int_generator_one_sec, test_accumulator>;
+using g2a_eocs=std::tuple<
+cadmium::modeling::EOC<test_accumulator, test_accumulator_defs::sum, g2a_out>
+>;
+using g2a_ics=std::tuple<
+cadmium::modeling::IC<cadmium::basic_models::int_generator_one_sec, cadmium::basic_models::int_generator_one_sec_defs::out, test_accumulator, test_accumulator_defs::add>,
+cadmium::modeling::IC<cadmium::basic_models::reset_generator_five_sec, cadmium::basic_models::reset_generator_five_sec_defs::out, test_accumulator, test_accumulator_defs::reset>
+>;
+template<typename TIME>
+using g2a_model=cadmium::modeling::coupled_model<TIME, std::tuple<>, std::tuple<g2a_out>, g2a_submodels, std::tuple<>, g2a_eocs, g2a_ics>;
+
+//relays hold the sum of the messages received for a while and send it incremented
+struct relay_defs{
+    struct in : public cadmium::in_port<int>{};
+    struct out : public cadmium::out_port<int>{};
+};
+
+template<int ID, typename TIME>
+class blind_relay {
+public:
+    using state_type=int; //negative when passive
+    state_type state = (ID == 0 ? 0 : -1);
+
+    using input_ports=std::tuple<relay_defs::in>;
+    using output_ports=std::tuple<relay_defs::out>;
+
+    void internal_transition() {
+        state = -1;
+    }
+
+    void external_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {
+        state = std::max(state, 0);
+        for (auto m : cadmium::get_messages<relay_defs::in>(mbs)) {
+            state += m;
+        }
+    }
+
+    void confluence_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {
+        internal_transition();
+        external_transition(TIME{}, std::move(mbs));
+    }
+
+    typename cadmium::make_message_bags<output_ports>::type output() const {
+        typename cadmium::make_message_bags<output_ports>::type bags;
+        cadmium::get_messages<relay_defs::out>(bags).push_back(state + 1);
+        return bags;
+    }
+
+    TIME time_advance() const {
+        if (state < 0) {
+            return std::numeric_limits<TIME>::infinity();
+        }
+        return ID == 0 ? TIME{1} : TIME{0.5};
+    }
+};
+
+template<int ID, typename TIME>
+class relay : public blind_relay<ID, TIME> {
+public:
+    static TIME lookahead() {
+        return 0.5;
+    }
+};
+
+template<typename TIME>
+using relay_0=relay<0, TIME>;
+template<typename TIME>
+using relay_1=relay<1, TIME>;
+
+//two relays passing a message around, a generator sends messages to one of them too
+using ring_submodels=cadmium::modeling::models_tuple<relay_0, relay_1, cadmium::basic_models::int_generator_one_sec>;
+using ring_ics=std::tuple<
+cadmium::modeling::IC<relay_0, relay_defs::out, relay_1, relay_defs::in>,
+cadmium::modeling::IC<relay_1, relay_defs::out, relay_0, relay_defs::in>,
+cadmium::modeling::IC<cadmium::basic_models::int_generator_one_sec, cadmium::basic_models::int_generator_one_sec_defs::out, relay_1, relay_defs::in>
+>;
+template<typename TIME>
+using ring_model=cadmium::modeling::coupled_model<TIME, std::tuple<>, std::tuple<>, ring_submodels, std::tuple<>, std::tuple<>, ring_ics>;
+
+template<typename TIME>
+using blind_relay_0=blind_relay<0, TIME>;
+template<typename TIME>
+using blind_relay_1=blind_relay<1, TIME>;
+using blind_ring_submodels=cadmium::modeling::models_tuple<blind_relay_0, blind_relay_1>;
+using blind_ring_ics=std::tuple<
+cadmium::modeling::IC<blind_relay_0, relay_defs::out, blind_relay_1, relay_defs::in>,
+cadmium::modeling::IC<blind_relay_1, relay_defs::out, blind_relay_0, relay_defs::in>
+>;
+template<typename TIME>
+using blind_ring_model=cadmium::modeling::coupled_model<TIME, std::tuple<>, std::tuple<>, blind_ring_submodels, std::tuple<>, std::tuple<>, blind_ring_ics>;
+
+BOOST_AUTO_TEST_CASE( lookahead_of_models_test ){
+    BOOST_CHECK_EQUAL((cadmium::modeling::model_lookahead<float, relay_0<float>>::value()), 0.5f);
+    BOOST_CHECK_EQUAL((cadmium::modeling::model_lookahead<float, blind_relay_0<float>>::value()), 0.0f);
+    BOOST_CHECK_EQUAL((cadmium::modeling::model_lookahead<float, ring_model<float>>::value()), 0.0f);
+    using relays=cadmium::modeling::models_tuple<relay_0, relay_1>;
+    using relays_model=cadmium::modeling::coupled_model<float, std::tuple<>, std::tuple<>, relays, std::tuple<>, std::tuple<>, std::tuple<>>;
+    BOOST_CHECK_EQUAL((cadmium::modeling::model_lookahead<float, relays_model>::value()), 0.5f);
+}
+
+template<template<typename> class MODEL>
+void check_same_states_for(float until){
+    take_logged_lines();
+    cadmium::engine::runner<float, MODEL, log_states_per_thread> sequential{0.0f};
+    float sequential_next = sequential.runUntil(until);
+    std::vector<std::string> sequential_lines = take_logged_lines();
+    BOOST_REQUIRE(!sequential_lines.empty());
+
+    cadmium::engine::conservative_runner<float, MODEL, log_states_per_thread> conservative{0.0f};
+    BOOST_CHECK_EQUAL(conservative.runUntil(until), sequential_next);
+    std::vector<std::string> conservative_lines = take_logged_lines();
+    BOOST_CHECK(sequential_lines == conservative_lines);
+}
+
+BOOST_AUTO_TEST_CASE( conservative_runner_without_cycles_test ){
+    check_same_states_for<g2a_model>(30.0f);
+}
+
+BOOST_AUTO_TEST_CASE( conservative_runner_with_lookahead_cycle_test ){
+    check_same_states_for<ring_model>(30.0f);
+}
+
+BOOST_AUTO_TEST_CASE( conservative_runner_continues_runs_test ){
+    take_logged_lines();
+    cadmium::engine::runner<float, ring_model, log_states_per_thread> sequential{0.0f};
+    float sequential_next = sequential.runUntil(20.0f);
+    std::vector<std::string> sequential_lines = take_logged_lines();
+
+    cadmium::engine::conservative_runner<float, ring_model, log_states_per_thread> conservative{0.0f};
+    conservative.runUntil(7.25f);
+    conservative.runUntil(12.0f);
+    BOOST_CHECK_EQUAL(conservative.runUntil(20.0f), sequential_next);
+    BOOST_CHECK(sequential_lines == take_logged_lines());
+}
+
+BOOST_AUTO_TEST_CASE( conservative_runner_rejects_cycles_without_lookahead_test ){
+    using blind_runner=cadmium::engine::conservative_runner<float, blind_ring_model>;
+    BOOST_CHECK_THROW(blind_runner{0.0f}, std::domain_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -39,6 +39,7 @@
 #include <cadmium/concept/concept_helpers.hpp>
 #include <cadmium/engine/pdevs_engine_helpers.hpp>
 #include <cadmium/logger/logger.hpp>
+#include <cadmium/logger/common_loggers.hpp>
 
 
 /**
@@ -119,7 +120,7 @@ BOOST_AUTO_TEST_CASE( coordinated_generator_produces_right_output_test){
     //check the right output is generated when asking at next time
     cg.collect_outputs(1.0f);
     output_bags = cg.outbox();
-    BOOST_REQUIRE(!cadmium::engine::all_bags_empty(output_bags));
+    BOOST_REQUIRE(cadmium::non_empty_ports(output_bags).any());
     BOOST_CHECK_EQUAL(cadmium::get_messages<coupled_out_port>(output_bags).size(), 1); //only a tick happened.
 
     //second cycle, all same checks one second later produce same results
@@ -186,7 +187,7 @@ BOOST_AUTO_TEST_CASE( generators_send_to_accumulator_and_output_test ){
     cc.collect_outputs(5.0f);
     output_bags = cc.outbox();
 
-    BOOST_REQUIRE(!cadmium::engine::all_bags_empty(output_bags));
+    BOOST_REQUIRE(cadmium::non_empty_ports(output_bags).any());
     BOOST_CHECK_EQUAL(cadmium::get_messages<g2a_coupled_out_port>(output_bags).size(), 1); //only a sum happened.
     BOOST_CHECK_EQUAL(cadmium::get_messages<g2a_coupled_out_port>(output_bags).at(0), 5); //5 ticks of 1 were counted
     cc.advance_simulation(5.0f);
@@ -196,6 +197,159 @@ BOOST_AUTO_TEST_CASE( generators_send_to_accumulator_and_output_test ){
     BOOST_REQUIRE(cadmium::get_messages<g2a_coupled_out_port>(output_bags).empty());//was reset
 }
 
+//accumulator receiving its inputs from the coupled model input ports through EICs, nested in two levels
+struct eic_add_port : public cadmium::in_port<int>{};
+struct eic_reset_port : public cadmium::in_port<reset_tick>{};
+struct eic_sum_port : public cadmium::out_port<int>{};
+using eic_iports = std::tuple<eic_add_port, eic_reset_port>;
+using eic_oports = std::tuple<eic_sum_port>;
+using eic_submodels=cadmium::modeling::models_tuple<test_accumulator>;
+using eic_eics=std::tuple<
+cadmium::modeling::EIC<eic_add_port, test_accumulator, test_accumulator_defs::add>,
+cadmium::modeling::EIC<eic_reset_port, test_accumulator, test_accumulator_defs::reset>
+>;
+using eic_eocs=std::tuple<
+cadmium::modeling::EOC<test_accumulator, test_accumulator_defs::sum, eic_sum_port>
+>;
+template<typename TIME>
+using coupled_eic_accumulator=cadmium::modeling::coupled_model<TIME, eic_iports, eic_oports, eic_submodels, eic_eics, std::tuple<>, std::tuple<>>;
+template<typename TIME>
+using coupled_eic_eoc_accumulator=cadmium::modeling::coupled_model<TIME, eic_iports, eic_oports, eic_submodels, eic_eics, eic_eocs, std::tuple<>>;
+
+using nested_submodels=cadmium::modeling::models_tuple<coupled_eic_accumulator, coupled_eic_eoc_accumulator>;
+using nested_eics=std::tuple<
+cadmium::modeling::EIC<eic_add_port, coupled_eic_eoc_accumulator, eic_add_port>,
+cadmium::modeling::EIC<eic_reset_port, coupled_eic_eoc_accumulator, eic_reset_port>
+>;
+using nested_eocs=std::tuple<
+cadmium::modeling::EOC<coupled_eic_eoc_accumulator, eic_sum_port, eic_sum_port>
+>;
+template<typename TIME>
+using nested_eic_accumulator=cadmium::modeling::coupled_model<TIME, eic_iports, eic_oports, nested_submodels, nested_eics, nested_eocs, std::tuple<>>;
+
+template<typename TIME>
+using linear_fel=cadmium::engine::linear_fel<TIME>;
+template<typename TIME>
+using heap_fel=cadmium::engine::heap_fel<TIME>;
+
+template<template<typename> class FEL>
+void check_messages_routed_by_eic_are_delivered_once(){
+    using input_bags=typename cadmium::make_message_bags<nested_eic_accumulator<float>::input_ports>::type;
+    cadmium::engine::coordinator<nested_eic_accumulator, float, cadmium::logger::not_logger, FEL> cc;
+    cc.init(0);
+    input_bags in;
+    BOOST_CHECK_EQUAL(std::numeric_limits<float>::infinity(), cc.next());
+
+    //external input is accumulated without producing output
+    cadmium::get_messages<eic_add_port>(in) = {1, 2, 3};
+    cc.inbox(in);
+    cc.advance_simulation(1.0f);
+    BOOST_CHECK_EQUAL(std::numeric_limits<float>::infinity(), cc.next());
+
+    //a reset schedules the output of the accumulated value
+    in = input_bags{};
+    cadmium::get_messages<eic_reset_port>(in).emplace_back();
+    cc.inbox(in);
+    cc.advance_simulation(2.0f);
+    BOOST_CHECK_EQUAL(2.0f, cc.next());
+    cc.collect_outputs(2.0f);
+    auto output_bags = cc.outbox();
+    BOOST_REQUIRE_EQUAL(cadmium::get_messages<eic_sum_port>(output_bags).size(), 1);
+    BOOST_CHECK_EQUAL(cadmium::get_messages<eic_sum_port>(output_bags).at(0), 6);
+    cc.advance_simulation(2.0f);
+    BOOST_CHECK_EQUAL(std::numeric_limits<float>::infinity(), cc.next());
+
+    //the messages introduced before are not delivered again
+    in = input_bags{};
+    cadmium::get_messages<eic_reset_port>(in).emplace_back();
+    cc.inbox(in);
+    cc.advance_simulation(3.0f);
+    BOOST_CHECK_EQUAL(3.0f, cc.next());
+    cc.collect_outputs(3.0f);
+    output_bags = cc.outbox();
+    BOOST_REQUIRE_EQUAL(cadmium::get_messages<eic_sum_port>(output_bags).size(), 1);
+    BOOST_CHECK_EQUAL(cadmium::get_messages<eic_sum_port>(output_bags).at(0), 0);
+}
+
+BOOST_AUTO_TEST_CASE( messages_routed_by_eic_are_delivered_once_using_linear_fel_test ){
+    check_messages_routed_by_eic_are_delivered_once<linear_fel>();
+}
+
+BOOST_AUTO_TEST_CASE( messages_routed_by_eic_are_delivered_once_using_heap_fel_test ){
+    check_messages_routed_by_eic_are_delivered_once<heap_fel>();
+}
+
+//only imminent subengines and subengines receiving messages are asked for output and advanced
+namespace {
+    std::ostringstream oss;
+
+    struct oss_test_sink_provider{
+        static std::ostream& sink(){
+            return oss;
+        }
+    };
+}
+
+BOOST_AUTO_TEST_CASE( coordinator_only_advances_active_subengines_test ){
+    oss.str("");
+    using log_info_to_oss=cadmium::logger::logger<cadmium::logger::logger_info, cadmium::logger::verbatim_formatter, oss_test_sink_provider>;
+    cadmium::engine::coordinator<coupled_g2a_model, float, log_info_to_oss> cc;
+    cc.init(0);
+    oss.str("");
+    cc.collect_outputs(1.0f);
+    cc.advance_simulation(1.0f);
+
+    //the int generator is imminent and the accumulator receives its output, the reset generator is idle
+    std::string log = oss.str();
+    BOOST_CHECK(log.find(boost::typeindex::type_id<cadmium::basic_models::int_generator_one_sec<float>>().pretty_name() + " collecting output") != std::string::npos);
+    BOOST_CHECK(log.find(boost::typeindex::type_id<cadmium::basic_models::reset_generator_five_sec<float>>().pretty_name()) == std::string::npos);
+    BOOST_CHECK(log.find(boost::typeindex::type_id<test_accumulator<float>>().pretty_name() + " collecting output") == std::string::npos);
+    BOOST_CHECK(log.find(boost::typeindex::type_id<test_accumulator<float>>().pretty_name() + " advancing simulation") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE( coordinator_skips_idle_subtrees_test ){
+    oss.str("");
+    using log_info_to_oss=cadmium::logger::logger<cadmium::logger::logger_info, cadmium::logger::verbatim_formatter, oss_test_sink_provider>;
+    cadmium::engine::coordinator<nested_eic_accumulator, float, log_info_to_oss> cc;
+    cc.init(0);
+    BOOST_CHECK(!cc.imminent(1.0f));
+    BOOST_CHECK(!cc.has_pending_input());
+    BOOST_CHECK(!cc.active(1.0f));
+
+    //advancing without input nor imminent submodels does not reach any submodel
+    oss.str("");
+    cc.advance_simulation(1.0f);
+    BOOST_CHECK(oss.str().empty());
+
+    //input is routed only to the subtree connected by the EICs
+    typename cadmium::make_message_bags<nested_eic_accumulator<float>::input_ports>::type in;
+    cadmium::get_messages<eic_add_port>(in) = {1};
+    cc.inbox(in);
+    BOOST_CHECK(cc.has_pending_input());
+    BOOST_CHECK(cc.active(2.0f));
+    cc.advance_simulation(2.0f);
+    std::string log = oss.str();
+    BOOST_CHECK(log.find(boost::typeindex::type_id<coupled_eic_eoc_accumulator<float>>().pretty_name() + " advancing simulation") != std::string::npos);
+    BOOST_CHECK(log.find(boost::typeindex::type_id<coupled_eic_accumulator<float>>().pretty_name()) == std::string::npos);
+    BOOST_CHECK(!cc.has_pending_input());
+}
+
+BOOST_AUTO_TEST_CASE( coordinator_tracks_non_empty_ports_test ){
+    cadmium::engine::coordinator<coupled_generator, float, cadmium::logger::not_logger> cc;
+    cc.init(0);
+    BOOST_CHECK(cc._outbox_dirty.none());
+    //no output before the generator is imminent
+    cc.collect_outputs(0.5f);
+    BOOST_CHECK(cc._outbox_dirty.none());
+    //the port receiving the tick by EOC is set
+    cc.collect_outputs(1.0f);
+    BOOST_CHECK(cc._outbox_dirty.test(0));
+    cc.advance_simulation(1.0f);
+    BOOST_CHECK(cc._outbox_dirty.none());
+    BOOST_CHECK(!cc.has_pending_input());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 
+
@@ -32,6 +32,7 @@
 #include <cadmium/engine/pdevs_coordinator.hpp>
 #include <cadmium/basic_model/generator.hpp>
 #include <cadmium/engine/pdevs_engine_helpers.hpp>
+#include <cadmium/modeling/coupled_model.hpp>
 
 /**
   * This test is for some common helper functions used by coordinators and simulators
@@ -92,5 +93,70 @@ BOOST_AUTO_TEST_CASE(get_engine_by_model_two_elements_get_last_test){
     auto eng_b=cadmium::engine::get_engine_by_model<floating_generator_b<float>, tuple_sim_gens>(st);
 }
 
+//Messages counting the copies done while being routed
+struct counted_message{
+    static int copies;
+    int value;
+    counted_message(int v) : value(v) {}
+    counted_message(const counted_message& other) : value(other.value) { ++copies; }
+    counted_message(counted_message&& other) noexcept : value(other.value) {}
+    counted_message& operator=(const counted_message& other) { value = other.value; ++copies; return *this; }
+    counted_message& operator=(counted_message&& other) noexcept { value = other.value; return *this; }
+};
+int counted_message::copies = 0;
+
+BOOST_AUTO_TEST_CASE(deliver_messages_to_single_destination_moves_test){
+    counted_message::copies = 0;
+    std::vector<counted_message> from{1, 2};
+    std::vector<counted_message> to;
+    counted_message::copies = 0;
+    cadmium::engine::deliver_messages<true>::deliver(from, to);
+    BOOST_CHECK(from.empty());
+    BOOST_REQUIRE_EQUAL(to.size(), 2);
+    BOOST_CHECK_EQUAL(to.at(1).value, 2);
+
+    //appending to a non empty destination moves each message
+    from = {3};
+    counted_message::copies = 0;
+    cadmium::engine::deliver_messages<true>::deliver(from, to);
+    BOOST_CHECK(from.empty());
+    BOOST_REQUIRE_EQUAL(to.size(), 3);
+    BOOST_CHECK_EQUAL(to.at(2).value, 3);
+    BOOST_CHECK_EQUAL(counted_message::copies, 0);
+}
+
+BOOST_AUTO_TEST_CASE(deliver_messages_to_multiple_destinations_copies_test){
+    std::vector<counted_message> from{1, 2};
+    std::vector<counted_message> to_a, to_b;
+    counted_message::copies = 0;
+    cadmium::engine::deliver_messages<false>::deliver(from, to_a);
+    cadmium::engine::deliver_messages<false>::deliver(from, to_b);
+    BOOST_CHECK_EQUAL(from.size(), 2);
+    BOOST_CHECK_EQUAL(to_a.size(), 2);
+    BOOST_CHECK_EQUAL(to_b.size(), 2);
+    BOOST_CHECK_EQUAL(counted_message::copies, 4);
+}
+
+//Definition of couplings from the generators for counting the destinations of their output
+struct coupled_out_port : public cadmium::out_port<float>{};
+struct coupled_in_port : public cadmium::in_port<float>{};
+using gens_ics=std::tuple<
+cadmium::modeling::IC<floating_generator_a, floating_generator_defs::out, floating_accumulator, floating_accumulator_defs::add>
+>;
+using gens_eocs=std::tuple<
+cadmium::modeling::EOC<floating_generator_a, floating_generator_defs::out, coupled_out_port>,
+cadmium::modeling::EOC<floating_generator_b, floating_generator_defs::out, coupled_out_port>
+>;
+using gens_eics=std::tuple<
+cadmium::modeling::EIC<coupled_in_port, floating_accumulator, floating_accumulator_defs::add>
+>;
+BOOST_AUTO_TEST_CASE(count_destinations_from_port_test){
+    constexpr std::size_t from_a=cadmium::engine::count_destinations_from_port<float, floating_generator_a<float>, floating_generator_defs::out, gens_ics, gens_eocs>::value;
+    constexpr std::size_t from_b=cadmium::engine::count_destinations_from_port<float, floating_generator_b<float>, floating_generator_defs::out, gens_ics, gens_eocs>::value;
+    constexpr std::size_t from_in=cadmium::engine::count_destinations_from_input_port<coupled_in_port, gens_eics>::value;
+    BOOST_CHECK_EQUAL(from_a, 2);
+    BOOST_CHECK_EQUAL(from_b, 1);
+    BOOST_CHECK_EQUAL(from_in, 1);
+}
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,173 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <cadmium/modeling/coupled_model.hpp>
+#include <cadmium/modeling/replication.hpp>
+#include <cadmium/engine/pdevs_runner.hpp>
+#include <cadmium/engine/pdevs_ensemble.hpp>
+
+/**
+ * This test checks the replications of an ensemble are seeded by their index and independent of the threads
+ */
+
+BOOST_AUTO_TEST_SUITE( pdevs_ensemble_test_suite )
+
+//outputs a random number every second, seeded by the replication
+struct random_generator_defs{
+    struct out : public cadmium::out_port<std::uint64_t>{};
+};
+
+template<typename TIME>
+class random_generator {
+    std::mt19937_64 _generator{cadmium::current_replication().seed};
+public:
+    using state_type=std::uint64_t;
+    state_type state = _generator();
+
+    using input_ports=std::tuple<>;
+    using output_ports=std::tuple<random_generator_defs::out>;
+
+    void internal_transition() {
+        state = _generator();
+    }
+
+    void external_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {
+        throw std::logic_error("External transition called in a model with no input ports");
+    }
+
+    void confluence_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {
+        throw std::logic_error("Confluence transition called in a model with no input ports");
+    }
+
+    typename cadmium::make_message_bags<output_ports>::type output() const {
+        typename cadmium::make_message_bags<output_ports>::type bags;
+        cadmium::get_messages<random_generator_defs::out>(bags).push_back(state % 1000);
+        return bags;
+    }
+
+    TIME time_advance() const {
+        return TIME{1};
+    }
+};
+
+struct top_out : public cadmium::out_port<std::uint64_t>{};
+using top_submodels=cadmium::modeling::models_tuple<random_generator>;
+using top_eocs=std::tuple<
+cadmium::modeling::EOC<random_generator, random_generator_defs::out, top_out>
+>;
+template<typename TIME>
+using top_model=cadmium::modeling::coupled_model<TIME, std::tuple<>, std::tuple<top_out>, top_submodels, std::tuple<>, top_eocs, std::tuple<>>;
+
+using test_ensemble=cadmium::engine::ensemble<float, top_model>;
+
+//the sum of the outputs of the top model until time 20
+struct sum_outputs {
+    std::uint64_t operator()(const cadmium::replication&, test_ensemble::runner_type& runner) const {
+        std::uint64_t sum = 0;
+        runner.runUntil(20.0f, [&sum](float, const auto& bags) {
+            for (auto m : cadmium::get_messages<top_out>(bags)) {
+                sum += m;
+            }
+        });
+        return sum;
+    }
+};
+
+BOOST_AUTO_TEST_CASE( runner_hands_top_outputs_test ){
+    cadmium::engine::runner<float, top_model, cadmium::logger::not_logger> runner{0.0f};
+    std::vector<float> times;
+    runner.runUntil(5.0f, [&times](float t, const auto& bags) {
+        BOOST_CHECK_EQUAL(cadmium::get_messages<top_out>(bags).size(), 1u);
+        times.push_back(t);
+    });
+    BOOST_CHECK((times == std::vector<float>{1.0f, 2.0f, 3.0f, 4.0f}));
+}
+
+BOOST_AUTO_TEST_CASE( ensemble_results_do_not_depend_on_threads_test ){
+    test_ensemble sequential{1, 42};
+    test_ensemble parallel{4, 42};
+    parallel.use_step_arenas();
+    std::vector<std::uint64_t> sequential_sums = sequential.run(50, 0.0f, sum_outputs{});
+    std::vector<std::uint64_t> parallel_sums = parallel.run(50, 0.0f, sum_outputs{});
+    BOOST_CHECK(sequential_sums == parallel_sums);
+
+    //every replication is the run of a runner with the seed of the replication
+    for (std::size_t i : {0u, 17u, 49u}) {
+        cadmium::replication_scope scope(parallel.replication_of(i));
+        test_ensemble::runner_type runner{0.0f};
+        BOOST_CHECK_EQUAL(sum_outputs{}(parallel.replication_of(i), runner), parallel_sums[i]);
+    }
+    BOOST_CHECK(sequential_sums[0] != sequential_sums[1]);
+    BOOST_CHECK_EQUAL(parallel.replication_of(3).index, 3u);
+
+    test_ensemble other_seed{4, 43};
+    BOOST_CHECK(other_seed.run(50, 0.0f, sum_outputs{}) != parallel_sums);
+}
+
+BOOST_AUTO_TEST_CASE( ensemble_reduce_test ){
+    test_ensemble e{4, 7};
+    std::vector<std::uint64_t> sums = e.run(20, 0.0f, sum_outputs{});
+    std::uint64_t total = e.reduce(20, 0.0f, sum_outputs{}, std::uint64_t{0}, [](std::uint64_t a, std::uint64_t b) { return a + b; });
+    BOOST_CHECK_EQUAL(total, std::accumulate(sums.begin(), sums.end(), std::uint64_t{0}));
+}
+
+BOOST_AUTO_TEST_CASE( ensemble_rethrows_failures_test ){
+    test_ensemble e{4};
+    auto failing = [](const cadmium::replication& r, test_ensemble::runner_type& runner) {
+        if (r.index == 5) {
+            throw std::domain_error("replication 5 failed");
+        }
+        return runner.runUntil(3.0f);
+    };
+    BOOST_CHECK_THROW(e.run(10, 0.0f, failing), std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE( ensemble_lends_arenas_to_threads_out_of_the_scheduler_test ){
+    //both threads take the index 0 of the shared scheduler, only one of them may use its arena at a time
+    cadmium::engine::task_scheduler scheduler(2);
+    test_ensemble shared{scheduler, 42};
+    shared.use_step_arenas();
+    test_ensemble sequential{1, 42};
+    std::vector<std::uint64_t> expected = sequential.run(20, 0.0f, sum_outputs{});
+    std::vector<std::uint64_t> first, second;
+    std::thread t([&shared, &first]() { first = shared.run(20, 0.0f, sum_outputs{}); });
+    second = shared.run(20, 0.0f, sum_outputs{});
+    t.join();
+    BOOST_CHECK(first == expected);
+    BOOST_CHECK(second == expected);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,135 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#define BOOST_TEST_DYN_LINK
+#include <limits>
+#include <vector>
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include <boost/mpl/list.hpp>
+#include <cadmium/engine/pdevs_fel.hpp>
+
+/**
+  * This test suite checks the Future Event Lists used by coordinators for scheduling subengines
+  */
+BOOST_AUTO_TEST_SUITE( pdevs_fel_test_suite )
+
+using fel_types=boost::mpl::list<cadmium::engine::linear_fel<float>, cadmium::engine::heap_fel<float>>;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE( empty_fel_next_is_infinity_test, FEL, fel_types ){
+    FEL f;
+    f.init(std::vector<float>{});
+    BOOST_CHECK_EQUAL(std::numeric_limits<float>::infinity(), f.next());
+    std::vector<std::size_t> imminent;
+    f.imminent(0.0f, imminent);
+    BOOST_CHECK(imminent.empty());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE( next_is_lowest_time_test, FEL, fel_types ){
+    FEL f;
+    f.init(std::vector<float>{5.0f, 3.0f, std::numeric_limits<float>::infinity(), 4.0f, 3.0f});
+    BOOST_CHECK_EQUAL(3.0f, f.next());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE( imminent_lists_all_engines_scheduled_at_time_test, FEL, fel_types ){
+    FEL f;
+    f.init(std::vector<float>{5.0f, 3.0f, 7.0f, 4.0f, 3.0f, 3.0f});
+    std::vector<std::size_t> imminent;
+    f.imminent(3.0f, imminent);
+    std::sort(imminent.begin(), imminent.end());
+    BOOST_CHECK((imminent == std::vector<std::size_t>{1, 4, 5}));
+    imminent.clear();
+    f.imminent(4.0f, imminent);
+    BOOST_CHECK((imminent == std::vector<std::size_t>{3}));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE( update_reschedules_engines_test, FEL, fel_types ){
+    FEL f;
+    f.init(std::vector<float>{5.0f, 3.0f, 7.0f, 4.0f});
+    f.update(1, 8.0f);
+    BOOST_CHECK_EQUAL(4.0f, f.next());
+    f.update(3, std::numeric_limits<float>::infinity());
+    BOOST_CHECK_EQUAL(5.0f, f.next());
+    f.update(2, 1.0f);
+    BOOST_CHECK_EQUAL(1.0f, f.next());
+    std::vector<std::size_t> imminent;
+    f.imminent(1.0f, imminent);
+    BOOST_CHECK((imminent == std::vector<std::size_t>{2}));
+}
+
+BOOST_AUTO_TEST_CASE( heap_fel_matches_linear_fel_on_many_updates_test ){
+    cadmium::engine::linear_fel<float> lf;
+    cadmium::engine::heap_fel<float> hf;
+    std::vector<float> nexts;
+    for (int i = 0; i < 50; i++) {
+        nexts.push_back(static_cast<float>((i * 7) % 13));
+    }
+    lf.init(nexts);
+    hf.init(nexts);
+    for (int i = 0; i < 500; i++) {
+        std::size_t engine = (i * 31) % 50;
+        float next = static_cast<float>((i * 17) % 23);
+        lf.update(engine, next);
+        hf.update(engine, next);
+        BOOST_REQUIRE_EQUAL(lf.next(), hf.next());
+        std::vector<std::size_t> imminent_l, imminent_h;
+        lf.imminent(lf.next(), imminent_l);
+        hf.imminent(hf.next(), imminent_h);
+        std::sort(imminent_h.begin(), imminent_h.end());
+        BOOST_REQUIRE(imminent_l == imminent_h);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( active_set_lists_engines_once_from_last_to_first_test ){
+    cadmium::engine::active_set as;
+    as.init(5);
+    as.mark(1);
+    as.mark(3);
+    as.mark(1);
+    as.mark(0);
+    BOOST_CHECK((as.engines() == std::vector<std::size_t>{3, 1, 0}));
+    as.clear();
+    BOOST_CHECK(as.engines().empty());
+    as.mark(1);
+    BOOST_CHECK((as.engines() == std::vector<std::size_t>{1}));
+}
+
+BOOST_AUTO_TEST_CASE( active_set_merges_engines_marked_after_listing_test ){
+    cadmium::engine::active_set as;
+    as.init(8);
+    as.mark(2);
+    as.mark(6);
+    BOOST_CHECK((as.engines() == std::vector<std::size_t>{6, 2}));
+    as.mark(4);
+    as.mark(2);
+    as.mark(7);
+    as.mark(0);
+    BOOST_CHECK((as.engines() == std::vector<std::size_t>{7, 6, 4, 2, 0}));
+    BOOST_CHECK((as.engines() == std::vector<std::size_t>{7, 6, 4, 2, 0}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
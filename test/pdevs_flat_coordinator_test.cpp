@@ -0,0 +1,203 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <sstream>
+#include <limits>
+
+#include <cadmium/logger/tuple_to_ostream.hpp>
+#include <cadmium/basic_model/int_generator_one_sec.hpp>
+#include <cadmium/basic_model/reset_generator_five_sec.hpp>
+#include <cadmium/basic_model/accumulator.hpp>
+#include <cadmium/modeling/coupled_model.hpp>
+#include <cadmium/engine/pdevs_coordinator.hpp>
+#include <cadmium/engine/pdevs_flat_coordinator.hpp>
+#include <cadmium/engine/pdevs_runner.hpp>
+
+/**
+ * This test checks the flat coordinator behaves as the coordinator for the same models
+ */
+BOOST_AUTO_TEST_SUITE( pdevs_flat_coordinator_test_suite )
+
+template<typename TIME>
+using test_accumulator=cadmium::basic_models::accumulator<int, TIME>;
+using test_accumulator_defs=cadmium::basic_models::accumulator_defs<int>;
+using reset_tick=test_accumulator_defs::reset_tick;
+
+//generators connected to an accumulator, the generators are nested one level down
+struct gens_int_out : public cadmium::out_port<int>{};
+struct gens_reset_out : public cadmium::out_port<reset_tick>{};
+using gens_submodels=cadmium::modeling::models_tuple<cadmium::basic_models::reset_generator_five_sec, cadmium::basic_models::int_generator_one_sec>;
+using gens_eocs=std::tuple<
+cadmium::modeling::EOC<cadmium::basic_models::int_generator_one_sec, cadmium::basic_models::int_generator_one_sec_defs::out, gens_int_out>,
+cadmium::modeling::EOC<cadmium::basic_models::reset_generator_five_sec, cadmium::basic_models::reset_generator_five_sec_defs::out, gens_reset_out>
+>;
+template<typename TIME>
+using coupled_generators=cadmium::modeling::coupled_model<TIME, std::tuple<>, std::tuple<gens_int_out, gens_reset_out>, gens_submodels, std::tuple<>, gens_eocs, std::tuple<>>;
+
+struct g2a_out : public cadmium::out_port<int>{};
+struct g2a_int_out : public cadmium::out_port<int>{};
+using g2a_submodels=cadmium::modeling::models_tuple<test_accumulator, coupled_generators>;
+using g2a_eocs=std::tuple<
+cadmium::modeling::EOC<test_accumulator, test_accumulator_defs::sum, g2a_out>,
+cadmium::modeling::EOC<coupled_generators, gens_int_out, g2a_int_out>
+>;
+using g2a_ics=std::tuple<
+cadmium::modeling::IC<coupled_generators, gens_int_out, test_accumulator, test_accumulator_defs::add>,
+cadmium::modeling::IC<coupled_generators, gens_reset_out, test_accumulator, test_accumulator_defs::reset>
+>;
+template<typename TIME>
+using nested_g2a_model=cadmium::modeling::coupled_model<TIME, std::tuple<>, std::tuple<g2a_out, g2a_int_out>, g2a_submodels, std::tuple<>, g2a_eocs, g2a_ics>;
+
+//accumulators receiving from the top model input ports, the same atomic model is used in two coupled models
+struct eic_add_port : public cadmium::in_port<int>{};
+struct eic_reset_port : public cadmium::in_port<reset_tick>{};
+struct eic_sum_port : public cadmium::out_port<int>{};
+using eic_iports = std::tuple<eic_add_port, eic_reset_port>;
+using eic_oports = std::tuple<eic_sum_port>;
+using eic_submodels=cadmium::modeling::models_tuple<test_accumulator>;
+using eic_eics=std::tuple<
+cadmium::modeling::EIC<eic_add_port, test_accumulator, test_accumulator_defs::add>,
+cadmium::modeling::EIC<eic_reset_port, test_accumulator, test_accumulator_defs::reset>
+>;
+using eic_eocs=std::tuple<
+cadmium::modeling::EOC<test_accumulator, test_accumulator_defs::sum, eic_sum_port>
+>;
+template<typename TIME>
+using coupled_eic_accumulator=cadmium::modeling::coupled_model<TIME, eic_iports, eic_oports, eic_submodels, eic_eics, std::tuple<>, std::tuple<>>;
+template<typename TIME>
+using coupled_eic_eoc_accumulator=cadmium::modeling::coupled_model<TIME, eic_iports, eic_oports, eic_submodels, eic_eics, eic_eocs, std::tuple<>>;
+using nested_submodels=cadmium::modeling::models_tuple<coupled_eic_accumulator, coupled_eic_eoc_accumulator>;
+using nested_eics=std::tuple<
+cadmium::modeling::EIC<eic_add_port, coupled_eic_eoc_accumulator, eic_add_port>,
+cadmium::modeling::EIC<eic_reset_port, coupled_eic_eoc_accumulator, eic_reset_port>,
+cadmium::modeling::EIC<eic_add_port, coupled_eic_accumulator, eic_add_port>
+>;
+using nested_eocs=std::tuple<
+cadmium::modeling::EOC<coupled_eic_eoc_accumulator, eic_sum_port, eic_sum_port>
+>;
+template<typename TIME>
+using nested_eic_accumulator=cadmium::modeling::coupled_model<TIME, eic_iports, eic_oports, nested_submodels, nested_eics, nested_eocs, std::tuple<>>;
+
+BOOST_AUTO_TEST_CASE( flattening_finds_leaves_and_routes_test ){
+    using leaves=cadmium::engine::flat_leaves<float, nested_g2a_model<float>, std::tuple<>>::type;
+    BOOST_CHECK_EQUAL(std::tuple_size<leaves>::value, 3);
+    using int_generator_path=std::tuple_element<2, leaves>::type;
+    using int_generator_routes=cadmium::engine::flat_routes_from_leaf<float, nested_g2a_model<float>, int_generator_path, cadmium::basic_models::int_generator_one_sec_defs::out>::type;
+    //the int generator output goes to the accumulator and to the top model output
+    BOOST_CHECK((std::is_same<int_generator_routes, std::tuple<
+        cadmium::engine::flat_leaf_destination<std::tuple<std::integral_constant<std::size_t, 0>>, test_accumulator_defs::add>,
+        cadmium::engine::flat_top_destination<g2a_int_out>>>::value));
+
+    using inputs=cadmium::engine::flat_routes_from_input<float, nested_eic_accumulator<float>, eic_add_port>::type;
+    BOOST_CHECK_EQUAL(std::tuple_size<inputs>::value, 2);
+}
+
+template<typename BAGS>
+std::string printed(const BAGS& bags){
+    std::ostringstream oss;
+    cadmium::engine::print_messages_by_port(oss, bags);
+    return oss.str();
+}
+
+template<template<typename> class MODEL>
+void check_same_outputs_for(float until){
+    cadmium::engine::coordinator<MODEL, float, cadmium::logger::not_logger, cadmium::engine::heap_fel> cc;
+    cadmium::engine::flat_coordinator<MODEL, float, cadmium::logger::not_logger> fc;
+    cc.init(0);
+    fc.init(0);
+    BOOST_REQUIRE_EQUAL(cc.next(), fc.next());
+    while (cc.next() < until) {
+        float t = cc.next();
+        cc.collect_outputs(t);
+        fc.collect_outputs(t);
+        BOOST_CHECK_EQUAL(printed(cc.outbox()), printed(fc.outbox()));
+        cc.advance_simulation(t);
+        fc.advance_simulation(t);
+        BOOST_REQUIRE_EQUAL(cc.next(), fc.next());
+    }
+}
+
+BOOST_AUTO_TEST_CASE( flat_coordinator_produces_same_output_test ){
+    check_same_outputs_for<nested_g2a_model>(30.0f);
+}
+
+BOOST_AUTO_TEST_CASE( flat_coordinator_routes_input_to_all_destinations_test ){
+    using input_bags=typename cadmium::make_message_bags<eic_iports>::type;
+    cadmium::engine::coordinator<nested_eic_accumulator, float, cadmium::logger::not_logger, cadmium::engine::heap_fel> cc;
+    cadmium::engine::flat_coordinator<nested_eic_accumulator, float, cadmium::logger::not_logger> fc;
+    cc.init(0);
+    fc.init(0);
+    BOOST_CHECK_EQUAL(fc.next(), std::numeric_limits<float>::infinity());
+
+    input_bags in;
+    cadmium::get_messages<eic_add_port>(in) = {1, 2, 3};
+    cc.inbox(in);
+    fc.inbox(in);
+    cc.advance_simulation(1.0f);
+    fc.advance_simulation(1.0f);
+    BOOST_CHECK(!fc.has_pending_input());
+
+    in = input_bags{};
+    cadmium::get_messages<eic_reset_port>(in).emplace_back();
+    cc.inbox(in);
+    fc.inbox(in);
+    cc.advance_simulation(2.0f);
+    fc.advance_simulation(2.0f);
+    BOOST_REQUIRE_EQUAL(fc.next(), 2.0f);
+    BOOST_REQUIRE_EQUAL(cc.next(), fc.next());
+    cc.collect_outputs(2.0f);
+    fc.collect_outputs(2.0f);
+    BOOST_REQUIRE_EQUAL(cadmium::get_messages<eic_sum_port>(fc.outbox()).size(), 1);
+    BOOST_CHECK_EQUAL(cadmium::get_messages<eic_sum_port>(fc.outbox()).at(0), 6);
+    BOOST_CHECK_EQUAL(printed(cc.outbox()), printed(fc.outbox()));
+}
+
+namespace {
+    std::ostringstream oss;
+
+    struct oss_test_sink_provider{
+        static std::ostream& sink(){
+            return oss;
+        }
+    };
+}
+
+BOOST_AUTO_TEST_CASE( runner_with_flat_coordinator_logs_same_states_test ){
+    using log_states_to_oss=cadmium::logger::logger<cadmium::logger::logger_state, cadmium::logger::verbatim_formatter, oss_test_sink_provider>;
+    oss.str("");
+    cadmium::engine::runner<float, nested_g2a_model, log_states_to_oss> hierarchical{0.0};
+    hierarchical.runUntil(30.0);
+    std::string hierarchical_log = oss.str();
+
+    oss.str("");
+    cadmium::engine::runner<float, nested_g2a_model, log_states_to_oss, cadmium::engine::heap_fel, cadmium::engine::flat_coordinator> flat{0.0};
+    flat.runUntil(30.0);
+    BOOST_CHECK_EQUAL(oss.str(), hierarchical_log);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,274 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include <cadmium/logger/tuple_to_ostream.hpp>
+#include <cadmium/basic_model/int_generator_one_sec.hpp>
+#include <cadmium/basic_model/reset_generator_five_sec.hpp>
+#include <cadmium/basic_model/accumulator.hpp>
+#include <cadmium/modeling/coupled_model.hpp>
+#include <cadmium/engine/pdevs_runner.hpp>
+#include <cadmium/engine/pdevs_multiprocess_runner.hpp>
+
+/**
+ * This test checks the multiprocess runner gives the states of the runner, and the rings between processes
+ */
+
+namespace {
+    //every process logs to its own file in the directory of current check
+    std::string log_dir;
+
+    struct per_process_sink_provider{
+        static std::ostream& sink(){
+            static pid_t owner=0;
+            static std::string owner_dir;
+            static std::unique_ptr<std::ofstream> file;
+            if (owner != getpid() || owner_dir != log_dir) {
+                if (owner != getpid()) {
+                    file.release(); //the file of the parent process is not closed by the child
+                }
+                owner = getpid();
+                owner_dir = log_dir;
+                file.reset(new std::ofstream(log_dir + "/" + std::to_string(owner) + ".log"));
+            }
+            return *file;
+        }
+    };
+
+    void start_logging(){
+        char dir[]="/tmp/cadmium_multiprocess_XXXXXX";
+        BOOST_REQUIRE(mkdtemp(dir) != nullptr);
+        log_dir = dir;
+    }
+
+    //the lines logged by all processes since start_logging, sorted
+    std::vector<std::string> take_logged_lines(){
+        std::vector<std::string> lines;
+        DIR* dir=opendir(log_dir.c_str());
+        BOOST_REQUIRE(dir != nullptr);
+        while (dirent* entry=readdir(dir)) {
+            std::string name=entry->d_name;
+            if (name == "." || name == "..") {
+                continue;
+            }
+            std::string path=log_dir + "/" + name;
+            {
+                std::ifstream ifs(path);
+                for (std::string line; std::getline(ifs, line);) {
+                    lines.push_back(line);
+                }
+            }
+            unlink(path.c_str());
+        }
+        closedir(dir);
+        rmdir(log_dir.c_str());
+        std::sort(lines.begin(), lines.end());
+        return lines;
+    }
+
+    using log_states_per_process=cadmium::logger::logger<cadmium::logger::logger_state, cadmium::logger::verbatim_formatter, per_process_sink_provider>;
+}
+
+BOOST_AUTO_TEST_SUITE( pdevs_multiprocess_runner_test_suite )
+
+BOOST_AUTO_TEST_CASE( shared_memory_ring_wraps_around_test ){
+    using cadmium::engine::shared_memory_ring;
+    constexpr std::size_t capacity=64;
+    std::vector<unsigned char> memory(shared_memory_ring::bytes_for(capacity));
+    shared_memory_ring* ring=new (memory.data()) shared_memory_ring(capacity);
+    BOOST_CHECK(ring->empty());
+
+    //records of 8 bytes of count and 3 ints, the ring is 64 bytes long
+    for (int i = 0; i < 20; ++i) {
+        std::vector<int> sent{i, i + 1, i + 2};
+        ring->push(sent);
+        ring->push(sent);
+        std::vector<int> received;
+        ring->pop(received);
+        ring->pop(received);
+        BOOST_CHECK(ring->empty());
+        std::vector<int> expected{i, i + 1, i + 2, i, i + 1, i + 2};
+        BOOST_CHECK(received == expected);
+    }
+
+    std::vector<int> too_many(16);
+    BOOST_CHECK_THROW(ring->push(too_many), std::length_error);
+    BOOST_CHECK(ring->empty());
+}
+
+template<typename TIME>
+using test_accumulator=cadmium::basic_models::accumulator<int, TIME>;
+using test_accumulator_defs=cadmium::basic_models::accumulator_defs<int>;
+
+//generators feeding an accumulator, each submodel in a process
+struct g2a_out : public cadmium::out_port<int>{};
+using g2a_submodels=cadmium::modeling::models_tuple<cadmium::basic_models::reset_generator_five_sec, cadmium::basic_models::int_generator_one_sec, test_accumulator>;
+using g2a_eocs=std::tuple<
+cadmium::modeling::EOC<test_accumulator, test_accumulator_defs::sum, g2a_out>
+>;
+using g2a_ics=std::tuple<
+cadmium::modeling::IC<cadmium::basic_models::int_generator_one_sec, cadmium::basic_models::int_generator_one_sec_defs::out, test_accumulator, test_accumulator_defs::add>,
+cadmium::modeling::IC<cadmium::basic_models::reset_generator_five_sec, cadmium::basic_models::reset_generator_five_sec_defs::out, test_accumulator, test_accumulator_defs::reset>
+>;
+template<typename TIME>
+using g2a_model=cadmium::modeling::coupled_model<TIME, std::tuple<>, std::tuple<g2a_out>, g2a_submodels, std::tuple<>, g2a_eocs, g2a_ics>;
+
+//the same model with the generators inside a coupled model, so a partition is run by a coordinator
+struct generators_int_out : public cadmium::out_port<int>{};
+struct generators_reset_out : public cadmium::out_port<test_accumulator_defs::reset_tick>{};
+using generators_submodels=cadmium::modeling::models_tuple<cadmium::basic_models::reset_generator_five_sec, cadmium::basic_models::int_generator_one_sec>;
+using generators_eocs=std::tuple<
+cadmium::modeling::EOC<cadmium::basic_models::int_generator_one_sec, cadmium::basic_models::int_generator_one_sec_defs::out, generators_int_out>,
+cadmium::modeling::EOC<cadmium::basic_models::reset_generator_five_sec, cadmium::basic_models::reset_generator_five_sec_defs::out, generators_reset_out>
+>;
+template<typename TIME>
+using generators_model=cadmium::modeling::coupled_model<TIME, std::tuple<>, std::tuple<generators_int_out, generators_reset_out>, generators_submodels, std::tuple<>, generators_eocs, std::tuple<>>;
+
+using nested_submodels=cadmium::modeling::models_tuple<generators_model, test_accumulator>;
+using nested_eocs=std::tuple<
+cadmium::modeling::EOC<test_accumulator, test_accumulator_defs::sum, g2a_out>
+>;
+using nested_ics=std::tuple<
+cadmium::modeling::IC<generators_model, generators_int_out, test_accumulator, test_accumulator_defs::add>,
+cadmium::modeling::IC<generators_model, generators_reset_out, test_accumulator, test_accumulator_defs::reset>
+>;
+template<typename TIME>
+using nested_model=cadmium::modeling::coupled_model<TIME, std::tuple<>, std::tuple<g2a_out>, nested_submodels, std::tuple<>, nested_eocs, nested_ics>;
+
+template<template<typename> class MODEL>
+void check_same_states_for(float until){
+    start_logging();
+    cadmium::engine::runner<float, MODEL, log_states_per_process> sequential{0.0f};
+    float sequential_next = sequential.runUntil(until);
+    std::vector<std::string> sequential_lines = take_logged_lines();
+    BOOST_REQUIRE(!sequential_lines.empty());
+
+    start_logging();
+    float multiprocess_next;
+    {
+        cadmium::engine::multiprocess_runner<float, MODEL, log_states_per_process> multiprocess{0.0f};
+        multiprocess.runUntil(until / 2);
+        multiprocess_next = multiprocess.runUntil(until);
+    } //the processes end with the runner
+    BOOST_CHECK_EQUAL(multiprocess_next, sequential_next);
+    BOOST_CHECK(sequential_lines == take_logged_lines());
+}
+
+BOOST_AUTO_TEST_CASE( multiprocess_runner_atomic_partitions_test ){
+    check_same_states_for<g2a_model>(30.0f);
+}
+
+BOOST_AUTO_TEST_CASE( multiprocess_runner_coupled_partition_test ){
+    check_same_states_for<nested_model>(30.0f);
+}
+
+//throws when receiving a message
+struct faulty_defs{
+    struct in : public cadmium::in_port<int>{};
+};
+
+template<typename TIME>
+class faulty {
+public:
+    using state_type=int;
+    state_type state = 0;
+    using input_ports=std::tuple<faulty_defs::in>;
+    using output_ports=std::tuple<>;
+
+    void internal_transition() {}
+    void external_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {
+        throw std::logic_error("faulty model received a message");
+    }
+    void confluence_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {
+        external_transition(e, std::move(mbs));
+    }
+    typename cadmium::make_message_bags<output_ports>::type output() const {
+        return {};
+    }
+    TIME time_advance() const {
+        return std::numeric_limits<TIME>::infinity();
+    }
+};
+
+using faulty_submodels=cadmium::modeling::models_tuple<cadmium::basic_models::int_generator_one_sec, faulty>;
+using faulty_ics=std::tuple<
+cadmium::modeling::IC<cadmium::basic_models::int_generator_one_sec, cadmium::basic_models::int_generator_one_sec_defs::out, faulty, faulty_defs::in>
+>;
+template<typename TIME>
+using faulty_model=cadmium::modeling::coupled_model<TIME, std::tuple<>, std::tuple<>, faulty_submodels, std::tuple<>, std::tuple<>, faulty_ics>;
+
+BOOST_AUTO_TEST_CASE( multiprocess_runner_reports_failures_test ){
+    cadmium::engine::multiprocess_runner<float, faulty_model> multiprocess{0.0f};
+    BOOST_CHECK_EQUAL(multiprocess.runUntil(0.5f), 1.0f);
+    BOOST_CHECK_EXCEPTION(multiprocess.runUntil(10.0f), std::runtime_error, [](const std::runtime_error& e) {
+        return std::string(e.what()) == "faulty model received a message";
+    });
+    BOOST_CHECK_THROW(multiprocess.runUntil(10.0f), std::domain_error);
+}
+
+//its process is killed when receiving a message
+template<typename TIME>
+class dying : public faulty<TIME> {
+public:
+    void external_transition(TIME e, typename cadmium::make_message_bags<typename faulty<TIME>::input_ports>::type mbs) {
+        std::raise(SIGKILL);
+    }
+    void confluence_transition(TIME e, typename cadmium::make_message_bags<typename faulty<TIME>::input_ports>::type mbs) {
+        external_transition(e, std::move(mbs));
+    }
+};
+
+using dying_submodels=cadmium::modeling::models_tuple<cadmium::basic_models::int_generator_one_sec, dying>;
+using dying_ics=std::tuple<
+cadmium::modeling::IC<cadmium::basic_models::int_generator_one_sec, cadmium::basic_models::int_generator_one_sec_defs::out, dying, faulty_defs::in>
+>;
+template<typename TIME>
+using dying_model=cadmium::modeling::coupled_model<TIME, std::tuple<>, std::tuple<>, dying_submodels, std::tuple<>, std::tuple<>, dying_ics>;
+
+BOOST_AUTO_TEST_CASE( multiprocess_runner_reports_dead_partitions_test ){
+    cadmium::engine::multiprocess_runner<float, dying_model> multiprocess{0.0f};
+    BOOST_CHECK_EQUAL(multiprocess.runUntil(0.5f), 1.0f);
+    BOOST_CHECK_EXCEPTION(multiprocess.runUntil(10.0f), std::runtime_error, [](const std::runtime_error& e) {
+        return std::string(e.what()) == "The process of a partition ended unexpectedly, killed by signal " + std::to_string(SIGKILL);
+    });
+    BOOST_CHECK_THROW(multiprocess.runUntil(10.0f), std::domain_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
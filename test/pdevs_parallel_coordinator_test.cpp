@@ -0,0 +1,216 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <cadmium/logger/tuple_to_ostream.hpp>
+#include <cadmium/basic_model/int_generator_one_sec.hpp>
+#include <cadmium/basic_model/reset_generator_five_sec.hpp>
+#include <cadmium/basic_model/accumulator.hpp>
+#include <cadmium/modeling/coupled_model.hpp>
+#include <cadmium/engine/task_scheduler.hpp>
+#include <cadmium/engine/pdevs_coordinator.hpp>
+#include <cadmium/engine/pdevs_parallel_coordinator.hpp>
+#include <cadmium/engine/pdevs_runner.hpp>
+
+/**
+ * This test checks the parallel coordinator gives the results of the coordinator
+ */
+BOOST_AUTO_TEST_SUITE( pdevs_parallel_coordinator_test_suite )
+
+BOOST_AUTO_TEST_CASE( task_scheduler_runs_every_index_once_test ){
+    cadmium::engine::task_scheduler scheduler(4);
+    BOOST_CHECK_EQUAL(scheduler.size(), 4);
+    for (std::size_t n : {0, 1, 3, 100}) {
+        std::vector<std::atomic<int>> calls(n);
+        for (auto& c : calls) {
+            c.store(0);
+        }
+        scheduler.for_each_index(n, [&calls](std::size_t i) { ++calls[i]; });
+        for (auto& c : calls) {
+            BOOST_CHECK_EQUAL(c.load(), 1);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( task_scheduler_runs_nested_loops_test ){
+    cadmium::engine::task_scheduler scheduler(4);
+    std::vector<std::atomic<int>> calls(64);
+    for (auto& c : calls) {
+        c.store(0);
+    }
+    //an unbalanced tree of loops, as the one of a skewed model hierarchy
+    scheduler.for_each_index(4, [&scheduler, &calls](std::size_t i) {
+        if (i == 0) {
+            scheduler.for_each_index(8, [&scheduler, &calls](std::size_t j) {
+                scheduler.for_each_index(7, [&calls, j](std::size_t k) { ++calls[j * 7 + k]; });
+            });
+        } else {
+            ++calls[55 + i];
+        }
+    });
+    for (std::size_t i = 0; i < 59; ++i) {
+        BOOST_CHECK_EQUAL(calls[i].load(), 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( task_scheduler_rethrows_after_all_indexes_test ){
+    cadmium::engine::task_scheduler scheduler(3);
+    std::atomic<int> calls{0};
+    BOOST_CHECK_THROW(scheduler.for_each_index(10, [&calls](std::size_t i) {
+        ++calls;
+        if (i == 5) {
+            throw std::domain_error("failed");
+        }
+    }), std::domain_error);
+    BOOST_CHECK_EQUAL(calls.load(), 10);
+    //the scheduler is still usable after the exception
+    calls.store(0);
+    scheduler.for_each_index(10, [&calls](std::size_t) { ++calls; });
+    BOOST_CHECK_EQUAL(calls.load(), 10);
+}
+
+template<typename TIME>
+using test_accumulator=cadmium::basic_models::accumulator<int, TIME>;
+using test_accumulator_defs=cadmium::basic_models::accumulator_defs<int>;
+using reset_tick=test_accumulator_defs::reset_tick;
+
+//generators nested one level down, connected to an accumulator
+struct gens_int_out : public cadmium::out_port<int>{};
+struct gens_reset_out : public cadmium::out_port<reset_tick>{};
+using gens_submodels=cadmium::modeling::models_tuple<cadmium::basic_models::reset_generator_five_sec, cadmium::basic_models::int_generator_one_sec>;
+using gens_eocs=std::tuple<
+cadmium::modeling::EOC<cadmium::basic_models::int_generator_one_sec, cadmium::basic_models::int_generator_one_sec_defs::out, gens_int_out>,
+cadmium::modeling::EOC<cadmium::basic_models::reset_generator_five_sec, cadmium::basic_models::reset_generator_five_sec_defs::out, gens_reset_out>
+>;
+template<typename TIME>
+using coupled_generators=cadmium::modeling::coupled_model<TIME, std::tuple<>, std::tuple<gens_int_out, gens_reset_out>, gens_submodels, std::tuple<>, gens_eocs, std::tuple<>>;
+
+struct g2a_out : public cadmium::out_port<int>{};
+struct g2a_int_out : public cadmium::out_port<int>{};
+using g2a_submodels=cadmium::modeling::models_tuple<test_accumulator, coupled_generators>;
+using g2a_eocs=std::tuple<
+cadmium::modeling::EOC<test_accumulator, test_accumulator_defs::sum, g2a_out>,
+cadmium::modeling::EOC<coupled_generators, gens_int_out, g2a_int_out>
+>;
+using g2a_ics=std::tuple<
+cadmium::modeling::IC<coupled_generators, gens_int_out, test_accumulator, test_accumulator_defs::add>,
+cadmium::modeling::IC<coupled_generators, gens_reset_out, test_accumulator, test_accumulator_defs::reset>
+>;
+template<typename TIME>
+using nested_g2a_model=cadmium::modeling::coupled_model<TIME, std::tuple<>, std::tuple<g2a_out, g2a_int_out>, g2a_submodels, std::tuple<>, g2a_eocs, g2a_ics>;
+
+template<typename BAGS>
+std::string printed(const BAGS& bags){
+    std::ostringstream oss;
+    cadmium::engine::print_messages_by_port(oss, bags);
+    return oss.str();
+}
+
+BOOST_AUTO_TEST_CASE( parallel_coordinator_produces_same_output_test ){
+    cadmium::engine::coordinator<nested_g2a_model, float, cadmium::logger::not_logger, cadmium::engine::heap_fel> cc;
+    cadmium::engine::parallel_coordinator<nested_g2a_model, float, cadmium::logger::not_logger> pc(4);
+    cc.init(0);
+    pc.init(0);
+    BOOST_REQUIRE_EQUAL(cc.next(), pc.next());
+    while (cc.next() < 30.0f) {
+        float t = cc.next();
+        cc.collect_outputs(t);
+        pc.collect_outputs(t);
+        BOOST_CHECK_EQUAL(printed(cc.outbox()), printed(pc.outbox()));
+        cc.advance_simulation(t);
+        pc.advance_simulation(t);
+        BOOST_REQUIRE_EQUAL(cc.next(), pc.next());
+    }
+}
+
+BOOST_AUTO_TEST_CASE( parallel_coordinators_share_a_scheduler_test ){
+    cadmium::engine::task_scheduler scheduler(3);
+    cadmium::engine::coordinator<nested_g2a_model, float, cadmium::logger::not_logger, cadmium::engine::heap_fel> cc;
+    cadmium::engine::parallel_coordinator<nested_g2a_model, float, cadmium::logger::not_logger> first(scheduler);
+    cadmium::engine::parallel_coordinator<nested_g2a_model, float, cadmium::logger::not_logger> second(scheduler);
+    cc.init(0);
+    first.init(0);
+    second.init(0);
+    while (cc.next() < 12.0f) {
+        float t = cc.next();
+        cc.collect_outputs(t);
+        first.collect_outputs(t);
+        second.collect_outputs(t);
+        BOOST_CHECK_EQUAL(printed(cc.outbox()), printed(first.outbox()));
+        BOOST_CHECK_EQUAL(printed(cc.outbox()), printed(second.outbox()));
+        cc.advance_simulation(t);
+        first.advance_simulation(t);
+        second.advance_simulation(t);
+        BOOST_REQUIRE_EQUAL(cc.next(), first.next());
+        BOOST_REQUIRE_EQUAL(cc.next(), second.next());
+    }
+}
+
+namespace {
+    std::ostringstream oss;
+
+    struct oss_test_sink_provider{
+        static std::ostream& sink(){
+            return oss;
+        }
+    };
+}
+
+BOOST_AUTO_TEST_CASE( runner_with_parallel_coordinator_logs_same_states_test ){
+    //the state logger is not parallel safe, the log is kept in order by running sequentially
+    using log_states_to_oss=cadmium::logger::logger<cadmium::logger::logger_state, cadmium::logger::verbatim_formatter, oss_test_sink_provider>;
+    oss.str("");
+    cadmium::engine::runner<float, nested_g2a_model, log_states_to_oss> sequential{0.0};
+    sequential.runUntil(30.0);
+    std::string sequential_log = oss.str();
+
+    oss.str("");
+    cadmium::engine::runner<float, nested_g2a_model, log_states_to_oss, cadmium::engine::heap_fel, cadmium::engine::parallel_coordinator> parallel{0.0};
+    parallel.runUntil(30.0);
+    BOOST_CHECK_EQUAL(oss.str(), sequential_log);
+}
+
+BOOST_AUTO_TEST_CASE( runner_with_parallel_coordinator_reaches_same_time_test ){
+    cadmium::engine::runner<float, nested_g2a_model, cadmium::logger::not_logger> sequential{0.0};
+    cadmium::engine::runner<float, nested_g2a_model, cadmium::logger::not_logger, cadmium::engine::heap_fel, cadmium::engine::parallel_coordinator> parallel{0.0};
+    BOOST_CHECK_EQUAL(sequential.runUntil(100.0), parallel.runUntil(100.0));
+}
+
+BOOST_AUTO_TEST_CASE( default_bags_do_not_use_the_step_arena_test ){
+    //only ports using the arena bag policy force a sequential step while an arena is installed
+    using cc_type=cadmium::engine::coordinator<nested_g2a_model, float, cadmium::logger::not_logger, cadmium::engine::heap_fel>;
+    using pc_type=cadmium::engine::parallel_coordinator<nested_g2a_model, float, cadmium::logger::not_logger>;
+    BOOST_CHECK(!cc_type::uses_step_arena);
+    BOOST_CHECK(!pc_type::uses_step_arena);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
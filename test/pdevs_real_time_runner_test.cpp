@@ -0,0 +1,149 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <cadmium/logger/tuple_to_ostream.hpp>
+#include <cadmium/basic_model/int_generator_one_sec.hpp>
+#include <cadmium/basic_model/accumulator.hpp>
+#include <cadmium/modeling/coupled_model.hpp>
+#include <cadmium/engine/pdevs_real_time_runner.hpp>
+
+/**
+ * This test checks the real time runner follows the wall clock and receives events posted from other threads
+ */
+
+BOOST_AUTO_TEST_SUITE( pdevs_real_time_runner_test_suite )
+
+template<typename TIME>
+using test_accumulator=cadmium::basic_models::accumulator<int, TIME>;
+using test_accumulator_defs=cadmium::basic_models::accumulator_defs<int>;
+
+//a generator adding one every second to an accumulator, more can be added or a reset asked from outside
+struct top_add : public cadmium::in_port<int>{};
+struct top_reset : public cadmium::in_port<test_accumulator_defs::reset_tick>{};
+struct top_sum : public cadmium::out_port<int>{};
+using top_submodels=cadmium::modeling::models_tuple<cadmium::basic_models::int_generator_one_sec, test_accumulator>;
+using top_eics=std::tuple<
+cadmium::modeling::EIC<top_add, test_accumulator, test_accumulator_defs::add>,
+cadmium::modeling::EIC<top_reset, test_accumulator, test_accumulator_defs::reset>
+>;
+using top_eocs=std::tuple<
+cadmium::modeling::EOC<test_accumulator, test_accumulator_defs::sum, top_sum>
+>;
+using top_ics=std::tuple<
+cadmium::modeling::IC<cadmium::basic_models::int_generator_one_sec, cadmium::basic_models::int_generator_one_sec_defs::out, test_accumulator, test_accumulator_defs::add>
+>;
+template<typename TIME>
+using top_model=cadmium::modeling::coupled_model<TIME, std::tuple<top_add, top_reset>, std::tuple<top_sum>, top_submodels, top_eics, top_eocs, top_ics>;
+
+using clock_type=std::chrono::steady_clock;
+
+BOOST_AUTO_TEST_CASE( steps_follow_the_wall_clock_test ){
+    //a millisecond per simulated second
+    cadmium::engine::real_time_runner<float, top_model, cadmium::logger::not_logger> r{0.0f, 0.001};
+    auto start = clock_type::now();
+    BOOST_CHECK_EQUAL(r.runUntil(20.5f), 21.0f);
+    auto elapsed = clock_type::now() - start;
+    BOOST_CHECK(elapsed >= std::chrono::milliseconds(20));
+    BOOST_CHECK_EQUAL(r.stats().steps, 20);
+    BOOST_CHECK(r.stats().mean_lateness() <= r.stats().max_lateness);
+
+    //the next run starts from the wall clock time it is called, not catching up the pause
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    start = clock_type::now();
+    BOOST_CHECK_EQUAL(r.runUntil(30.5f), 31.0f);
+    elapsed = clock_type::now() - start;
+    BOOST_CHECK(elapsed >= std::chrono::milliseconds(10));
+    BOOST_CHECK_EQUAL(r.stats().steps, 30);
+}
+
+BOOST_AUTO_TEST_CASE( events_posted_from_other_threads_are_received_test ){
+    cadmium::engine::real_time_runner<float, top_model, cadmium::logger::not_logger> r{0.0f, 0.001};
+    std::vector<std::pair<float, int>> sums;
+    std::thread console([&r]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(15));
+        r.post<top_add>({100});
+        r.post<top_reset>({test_accumulator_defs::reset_tick{}});
+    });
+    r.runUntil(40.0f, [&sums](const float& t, const std::tuple<cadmium::message_bag<top_sum>>& bags) {
+        sums.emplace_back(t, cadmium::get_messages<top_sum>(bags).at(0));
+    });
+    console.join();
+    BOOST_REQUIRE_EQUAL(sums.size(), 1);
+    //the reset arrived after the 15th second, sums are output as soon as a reset is received
+    BOOST_CHECK(sums[0].first >= 15.0f);
+    BOOST_CHECK(sums[0].second >= 115);
+    BOOST_CHECK_EQUAL(sums[0].second - 100, static_cast<int>(sums[0].first));
+}
+
+template<typename TIME>
+using passive_accumulator=cadmium::basic_models::accumulator<int, TIME>;
+
+BOOST_AUTO_TEST_CASE( passive_models_wait_for_events_until_stopped_test ){
+    cadmium::engine::real_time_runner<float, passive_accumulator, cadmium::logger::not_logger> r{0.0f, 0.001};
+    std::vector<int> sums;
+    std::atomic<int> outputs{0};
+    std::thread console([&r, &outputs]() {
+        for (int i = 1; i <= 3; ++i) {
+            r.post<test_accumulator_defs::add>({i});
+            r.post<test_accumulator_defs::reset>({test_accumulator_defs::reset_tick{}});
+            //next messages are posted once the sum was output, so they are not merged in the same step
+            while (outputs.load() < i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        r.stop();
+    });
+    float next = r.runUntil(std::numeric_limits<float>::infinity(), [&sums, &outputs](const float&, const std::tuple<cadmium::message_bag<test_accumulator_defs::sum>>& bags) {
+        sums.push_back(cadmium::get_messages<test_accumulator_defs::sum>(bags).at(0));
+        ++outputs;
+    });
+    console.join();
+    BOOST_CHECK_EQUAL(next, std::numeric_limits<float>::infinity());
+    BOOST_CHECK((sums == std::vector<int>{1, 2, 3}));
+}
+
+BOOST_AUTO_TEST_CASE( events_posted_between_runs_are_received_when_the_next_run_starts_test ){
+    cadmium::engine::real_time_runner<float, passive_accumulator, cadmium::logger::not_logger> r{0.0f, 0.001};
+    BOOST_CHECK_EQUAL(r.runUntil(5.0f), std::numeric_limits<float>::infinity());
+    r.post<test_accumulator_defs::add>({7});
+    r.post<test_accumulator_defs::reset>({test_accumulator_defs::reset_tick{}});
+    std::vector<std::pair<float, int>> sums;
+    r.runUntil(10.0f, [&sums](const float& t, const std::tuple<cadmium::message_bag<test_accumulator_defs::sum>>& bags) {
+        sums.emplace_back(t, cadmium::get_messages<test_accumulator_defs::sum>(bags).at(0));
+    });
+    BOOST_REQUIRE_EQUAL(sums.size(), 1);
+    BOOST_CHECK_EQUAL(sums[0].second, 7);
+    BOOST_CHECK(sums[0].first < 10.0f);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
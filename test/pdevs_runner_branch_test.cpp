@@ -0,0 +1,170 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <vector>
+
+#include <unistd.h>
+
+#include <cadmium/logger/tuple_to_ostream.hpp>
+#include <cadmium/basic_model/int_generator_one_sec.hpp>
+#include <cadmium/basic_model/accumulator.hpp>
+#include <cadmium/modeling/coupled_model.hpp>
+#include <cadmium/engine/pdevs_runner.hpp>
+#include <cadmium/engine/pdevs_process_branch.hpp>
+
+/**
+ * This test checks inputs injected to the top model and branches forked from a runner
+ */
+
+BOOST_AUTO_TEST_SUITE( pdevs_runner_branch_test_suite )
+
+template<typename TIME>
+using test_accumulator=cadmium::basic_models::accumulator<int, TIME>;
+using test_accumulator_defs=cadmium::basic_models::accumulator_defs<int>;
+
+//a generator adding one every second to an accumulator, more can be added or a reset asked from outside
+struct top_add : public cadmium::in_port<int>{};
+struct top_reset : public cadmium::in_port<test_accumulator_defs::reset_tick>{};
+struct top_sum : public cadmium::out_port<int>{};
+using top_submodels=cadmium::modeling::models_tuple<cadmium::basic_models::int_generator_one_sec, test_accumulator>;
+using top_eics=std::tuple<
+cadmium::modeling::EIC<top_add, test_accumulator, test_accumulator_defs::add>,
+cadmium::modeling::EIC<top_reset, test_accumulator, test_accumulator_defs::reset>
+>;
+using top_eocs=std::tuple<
+cadmium::modeling::EOC<test_accumulator, test_accumulator_defs::sum, top_sum>
+>;
+using top_ics=std::tuple<
+cadmium::modeling::IC<cadmium::basic_models::int_generator_one_sec, cadmium::basic_models::int_generator_one_sec_defs::out, test_accumulator, test_accumulator_defs::add>
+>;
+template<typename TIME>
+using top_model=cadmium::modeling::coupled_model<TIME, std::tuple<top_add, top_reset>, std::tuple<top_sum>, top_submodels, top_eics, top_eocs, top_ics>;
+
+template<template<template<typename> class, typename, typename, template<typename> class> class ENGINE>
+using test_runner=cadmium::engine::runner<float, top_model, cadmium::logger::not_logger, cadmium::engine::heap_fel, ENGINE>;
+
+//the sums output until t, each with the time it was output
+template<typename RUNNER>
+std::vector<std::pair<float, int>> sums_until(RUNNER& r, float t) {
+    std::vector<std::pair<float, int>> sums;
+    r.runUntil(t, [&sums](const float& time, const typename cadmium::make_message_bags<std::tuple<top_sum>>::type& bags) {
+        for (int s : cadmium::get_messages<top_sum>(bags)) {
+            sums.emplace_back(time, s);
+        }
+    });
+    return sums;
+}
+
+BOOST_AUTO_TEST_CASE( injected_inputs_are_received_at_their_time_test ){
+    test_runner<cadmium::engine::coordinator> r{0.0f};
+    r.inject<top_add>(2.5f, {10, 20});
+    r.inject<top_reset>(3.5f, {test_accumulator_defs::reset_tick{}});
+    r.inject<top_add>(2.5f, std::vector<int>{5});
+    auto sums = sums_until(r, 10.0f);
+    //the generator added 1 at times 1, 2 and 3
+    BOOST_REQUIRE_EQUAL(sums.size(), 1);
+    BOOST_CHECK_EQUAL(sums[0].first, 3.5f);
+    BOOST_CHECK_EQUAL(sums[0].second, 38);
+}
+
+template<template<template<typename> class, typename, typename, template<typename> class> class ENGINE>
+void check_branches_are_independent() {
+    test_runner<ENGINE> r{0.0f};
+    r.template inject<top_reset>(6.5f, {test_accumulator_defs::reset_tick{}});
+    r.runUntil(4.2f);
+
+    std::vector<test_runner<ENGINE>> branches;
+    for (int i = 0; i < 3; ++i) {
+        branches.push_back(r.fork());
+        branches.back().template inject<top_add>(5.5f, {100 * i});
+    }
+    //the branch continues as a runner simulating the same prefix
+    for (int i = 0; i < 3; ++i) {
+        test_runner<ENGINE> replay{0.0f};
+        replay.template inject<top_reset>(6.5f, {test_accumulator_defs::reset_tick{}});
+        replay.template inject<top_add>(5.5f, {100 * i});
+        BOOST_CHECK((sums_until(branches[i], 20.0f) == sums_until(replay, 20.0f)));
+    }
+    auto sums = sums_until(r, 20.0f);
+    BOOST_REQUIRE_EQUAL(sums.size(), 1);
+    BOOST_CHECK_EQUAL(sums[0].second, 6);
+}
+
+BOOST_AUTO_TEST_CASE( coordinator_branches_are_independent_test ){
+    check_branches_are_independent<cadmium::engine::coordinator>();
+}
+
+BOOST_AUTO_TEST_CASE( flat_coordinator_branches_are_independent_test ){
+    check_branches_are_independent<cadmium::engine::flat_coordinator>();
+}
+
+BOOST_AUTO_TEST_CASE( parallel_coordinator_branches_are_independent_test ){
+    check_branches_are_independent<cadmium::engine::parallel_coordinator>();
+}
+
+BOOST_AUTO_TEST_CASE( process_branches_report_through_pipes_test ){
+    test_runner<cadmium::engine::coordinator> r{0.0f};
+    r.runUntil(4.2f);
+
+    int fds[2];
+    BOOST_REQUIRE_EQUAL(pipe(fds), 0);
+    std::vector<pid_t> pids;
+    for (int i = 0; i < 3; ++i) {
+        pids.push_back(cadmium::engine::fork_process_branch(r, [&fds, i](test_runner<cadmium::engine::coordinator>& branch) {
+            branch.inject<top_add>(5.5f, {100 * i});
+            branch.inject<top_reset>(6.5f, {test_accumulator_defs::reset_tick{}});
+            auto sums = sums_until(branch, 20.0f);
+            int result[2] = {i, sums.at(0).second};
+            if (write(fds[1], result, sizeof(result)) != sizeof(result)) {
+                throw std::runtime_error("short write");
+            }
+        }));
+    }
+    for (auto pid : pids) {
+        cadmium::engine::wait_process_branch(pid);
+    }
+    close(fds[1]);
+    std::vector<int> results(3, -1);
+    int result[2];
+    while (read(fds[0], result, sizeof(result)) == sizeof(result)) {
+        results.at(result[0]) = result[1];
+    }
+    close(fds[0]);
+    BOOST_CHECK((results == std::vector<int>{6, 106, 206}));
+
+    //the parent was not modified by the branches
+    r.inject<top_reset>(6.5f, {test_accumulator_defs::reset_tick{}});
+    BOOST_CHECK_EQUAL(sums_until(r, 20.0f).at(0).second, 6);
+
+    pid_t failing = cadmium::engine::fork_process_branch(r, [](test_runner<cadmium::engine::coordinator>&) {
+        throw std::logic_error("branch failure");
+    });
+    BOOST_CHECK_THROW(cadmium::engine::wait_process_branch(failing), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
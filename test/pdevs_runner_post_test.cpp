@@ -0,0 +1,128 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <cadmium/logger/tuple_to_ostream.hpp>
+#include <cadmium/basic_model/accumulator.hpp>
+#include <cadmium/engine/mpsc_queue.hpp>
+#include <cadmium/engine/pdevs_runner.hpp>
+
+/**
+ * This test checks inputs posted to a runner from other threads while it runs
+ */
+
+BOOST_AUTO_TEST_SUITE( pdevs_runner_post_test_suite )
+
+BOOST_AUTO_TEST_CASE( mpsc_queue_keeps_the_order_of_each_producer_test ){
+    cadmium::engine::mpsc_queue<std::pair<int, int>> q;
+    const int producers = 4;
+    const int values = 20000;
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&q, p, values]() {
+            for (int i = 0; i < values; ++i) {
+                q.push(std::make_pair(p, i));
+            }
+        });
+    }
+    std::vector<int> expected(producers, 0);
+    int popped = 0;
+    std::pair<int, int> v;
+    bool ordered = true;
+    while (popped < producers * values) {
+        if (q.pop(v)) {
+            ordered = ordered && v.second == expected[v.first];
+            ++expected[v.first];
+            ++popped;
+        }
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    BOOST_CHECK(ordered);
+    BOOST_CHECK(q.empty());
+    BOOST_CHECK(!q.pop(v));
+}
+
+template<typename TIME>
+using test_accumulator=cadmium::basic_models::accumulator<int, TIME>;
+using test_accumulator_defs=cadmium::basic_models::accumulator_defs<int>;
+using test_runner=cadmium::engine::runner<float, test_accumulator, cadmium::logger::not_logger>;
+using sum_bags=std::tuple<cadmium::message_bag<test_accumulator_defs::sum>>;
+
+BOOST_AUTO_TEST_CASE( posted_inputs_are_received_at_their_time_test ){
+    test_runner r{0.0f};
+    std::vector<std::pair<float, int>> sums;
+    auto record = [&sums](const float& t, const sum_bags& bags) {
+        sums.emplace_back(t, cadmium::get_messages<test_accumulator_defs::sum>(bags).at(0));
+    };
+    r.post<test_accumulator_defs::add>(1.0f, {1, 2});
+    r.post<test_accumulator_defs::reset>(3.0f, {test_accumulator_defs::reset_tick{}});
+    r.runUntil(5.0f, record);
+    //a late input is received as soon as the runner takes it
+    r.post<test_accumulator_defs::add>(2.0f, {7});
+    r.post<test_accumulator_defs::reset>(2.0f, {test_accumulator_defs::reset_tick{}});
+    r.runUntilPassivate(record);
+    BOOST_CHECK((sums == std::vector<std::pair<float, int>>{{3.0f, 3}, {3.0f, 7}}));
+}
+
+BOOST_AUTO_TEST_CASE( inputs_posted_while_running_are_all_received_test ){
+    test_runner r{0.0f};
+    const int producers = 4;
+    const int values = 10000;
+    std::atomic<int> finished{0};
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&r, &finished, values]() {
+            for (int i = 0; i < values; ++i) {
+                r.post<test_accumulator_defs::add>(static_cast<float>(i % 100) + 0.5f, {1});
+            }
+            ++finished;
+        });
+    }
+    //the simulation keeps running while inputs arrive
+    float until = 0.0f;
+    while (finished.load() < producers) {
+        until += 1.0f;
+        r.runUntil(until);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    int sum = 0;
+    r.post<test_accumulator_defs::reset>(2000.0f, {test_accumulator_defs::reset_tick{}});
+    r.runUntilPassivate([&sum](const float&, const sum_bags& bags) {
+        sum += cadmium::get_messages<test_accumulator_defs::sum>(bags).at(0);
+    });
+    BOOST_CHECK_EQUAL(sum, producers * values);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
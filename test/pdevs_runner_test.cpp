@@ -84,6 +84,73 @@ BOOST_AUTO_TEST_CASE( pdevs_runner_of_a_generator_in_a_coupled_for_a_minute_test
     BOOST_CHECK_EQUAL(60.0, next_to_end_time);
 }
 
+BOOST_AUTO_TEST_CASE( pdevs_runner_for_a_number_of_events_test){
+    cadmium::engine::runner<float, coupled_generator, cadmium::logger::not_logger> r{0.0};
+    BOOST_CHECK_EQUAL(6.0, r.runFor(5));
+    int ticks = 0;
+    BOOST_CHECK_EQUAL(9.0, r.runFor(3, [&ticks](const float&, const std::tuple<cadmium::message_bag<coupled_out_port>>& bags) {
+        ticks += cadmium::get_messages<coupled_out_port>(bags).size();
+    }));
+    BOOST_CHECK_EQUAL(3, ticks);
+    BOOST_CHECK_EQUAL(9.0, r.runFor(0));
+}
+
+BOOST_AUTO_TEST_CASE( pdevs_runner_while_a_predicate_holds_test){
+    cadmium::engine::runner<float, coupled_generator, cadmium::logger::not_logger> r{0.0};
+    BOOST_CHECK_EQUAL(5.0, r.runWhile([](const float& t) { return t < 4.5; }));
+    //the predicate can depend on the outputs seen
+    int ticks = 0;
+    BOOST_CHECK_EQUAL(12.0, r.runWhile([&ticks](const float&) { return ticks < 7; },
+        [&ticks](const float&, const std::tuple<cadmium::message_bag<coupled_out_port>>&) { ++ticks; }));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+//atomic models are run by the runner with no coordinator on top
+BOOST_AUTO_TEST_SUITE( pdevs_atomic_runner_test_suite )
+
+BOOST_AUTO_TEST_CASE( pdevs_runner_of_a_generator_for_a_minute_test){
+    cadmium::engine::runner<float, test_generator, cadmium::logger::not_logger> r{0.0};
+    int ticks = 0;
+    float next_to_end_time = r.runUntil(60.0, [&ticks](const float&, const std::tuple<cadmium::message_bag<out_port>>& bags) {
+        ticks += cadmium::get_messages<out_port>(bags).size();
+    });
+    BOOST_CHECK_EQUAL(60.0, next_to_end_time);
+    BOOST_CHECK_EQUAL(59, ticks);
+}
+
+template<typename TIME>
+using atomic_accumulator=cadmium::basic_models::accumulator<int, TIME>;
+using atomic_accumulator_defs=cadmium::basic_models::accumulator_defs<int>;
+
+BOOST_AUTO_TEST_CASE( pdevs_runner_of_an_accumulator_receives_injected_inputs_test){
+    cadmium::engine::runner<float, atomic_accumulator, cadmium::logger::not_logger> r{0.0};
+    r.inject<atomic_accumulator_defs::add>(1.0, {2, 3});
+    r.inject<atomic_accumulator_defs::reset>(2.0, {atomic_accumulator_defs::reset_tick{}});
+    r.inject<atomic_accumulator_defs::add>(4.0, {7});
+    r.inject<atomic_accumulator_defs::reset>(5.0, {atomic_accumulator_defs::reset_tick{}});
+    std::vector<std::pair<float, int>> sums;
+    r.runUntil(10.0, [&sums](const float& t, const std::tuple<cadmium::message_bag<atomic_accumulator_defs::sum>>& bags) {
+        for (int s : cadmium::get_messages<atomic_accumulator_defs::sum>(bags)) {
+            sums.emplace_back(t, s);
+        }
+    });
+    BOOST_CHECK((sums == std::vector<std::pair<float, int>>{{2.0f, 5}, {5.0f, 7}}));
+}
+
+BOOST_AUTO_TEST_CASE( pdevs_runner_of_an_accumulator_until_passivation_test){
+    cadmium::engine::runner<float, atomic_accumulator, cadmium::logger::not_logger> r{0.0};
+    BOOST_CHECK_EQUAL(std::numeric_limits<float>::infinity(), r.runUntilPassivate());
+    r.inject<atomic_accumulator_defs::add>(1.0, {2, 3});
+    r.inject<atomic_accumulator_defs::reset>(2.0, {atomic_accumulator_defs::reset_tick{}});
+    r.inject<atomic_accumulator_defs::reset>(7.0, {atomic_accumulator_defs::reset_tick{}});
+    std::vector<std::pair<float, int>> sums;
+    BOOST_CHECK_EQUAL(std::numeric_limits<float>::infinity(), r.runUntilPassivate([&sums](const float& t, const std::tuple<cadmium::message_bag<atomic_accumulator_defs::sum>>& bags) {
+        sums.emplace_back(t, cadmium::get_messages<atomic_accumulator_defs::sum>(bags).at(0));
+    }));
+    BOOST_CHECK((sums == std::vector<std::pair<float, int>>{{2.0f, 5}, {7.0f, 0}}));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE( loggers_sources_runner_test_suite )
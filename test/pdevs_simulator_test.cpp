@@ -58,7 +58,7 @@ BOOST_AUTO_TEST_CASE( accumulator_model_simulation_test )
     typename cadmium::make_message_bags<input_ports>::type input_bags=cadmium::make_message_bags<input_ports>::type{};
     typename cadmium::make_message_bags<input_ports>::type empty_input=cadmium::make_message_bags<input_ports>::type{};
     //insert values to add port and reset to empty
-    BOOST_REQUIRE_MESSAGE(cadmium::engine::all_bags_empty(input_bags), "Error initializing the bags used for the test");
+    BOOST_REQUIRE_MESSAGE(cadmium::non_empty_ports(input_bags).none(), "Error initializing the bags used for the test");
     cadmium::get_messages<int_accumulator_defs::add>(input_bags).assign(std::initializer_list<int>{1, 2, 3, 4});
     cadmium::get_messages<int_accumulator_defs::reset>(input_bags).clear();
 
@@ -77,7 +77,7 @@ BOOST_AUTO_TEST_CASE( accumulator_model_simulation_test )
     //out provides the accumulated result
     s.collect_outputs(4.0f);
     auto o = s.outbox();
-    BOOST_REQUIRE(!cadmium::engine::all_bags_empty(o));
+    BOOST_REQUIRE(cadmium::non_empty_ports(o).any());
     BOOST_REQUIRE(cadmium::get_messages<int_accumulator_defs::sum>(o).size() == 1);
     BOOST_CHECK(cadmium::get_messages<int_accumulator_defs::sum>(o).at(0) == 10);
     s.inbox(empty_input);
@@ -90,7 +90,7 @@ BOOST_AUTO_TEST_CASE( accumulator_model_simulation_test )
     BOOST_CHECK(s.next() == 5.0f);
     s.collect_outputs(5.0f);
     o = s.outbox();
-    BOOST_REQUIRE(!cadmium::engine::all_bags_empty(o));
+    BOOST_REQUIRE(cadmium::non_empty_ports(o).any());
     BOOST_REQUIRE(cadmium::get_messages<int_accumulator_defs::sum>(o).size() == 1);
     BOOST_CHECK(cadmium::get_messages<int_accumulator_defs::sum>(o).at(0) == 0);
     s.inbox(empty_input);
@@ -104,7 +104,7 @@ BOOST_AUTO_TEST_CASE( accumulator_model_simulation_test )
     BOOST_CHECK(s.next() == 6.0f);
     s.collect_outputs(6.0f);
     o = s.outbox();
-    BOOST_REQUIRE(!cadmium::engine::all_bags_empty(o));
+    BOOST_REQUIRE(cadmium::non_empty_ports(o).any());
     BOOST_REQUIRE(cadmium::get_messages<int_accumulator_defs::sum>(o).size() == 1);
     BOOST_CHECK(cadmium::get_messages<int_accumulator_defs::sum>(o).at(0) == 10);
     s.inbox(empty_input);
@@ -112,6 +112,33 @@ BOOST_AUTO_TEST_CASE( accumulator_model_simulation_test )
     BOOST_CHECK(s.next() == std::numeric_limits<float>::infinity());
 }
 
+BOOST_AUTO_TEST_CASE( accumulator_boxes_keep_their_memory_between_steps_test ){
+    using simulator_t=cadmium::engine::simulator<int_accumulator, float, cadmium::logger::not_logger>;
+    using in_bags_t=typename cadmium::make_message_bags<int_accumulator<float>::input_ports>::type;
+    simulator_t s;
+    s.init(0.0f);
+
+    const int* inbox_memory=nullptr;
+    const int* outbox_memory=nullptr;
+    for (int step = 1; step <= 3; ++step) {
+        in_bags_t input;
+        cadmium::get_messages<int_accumulator_defs::add>(input).assign(std::initializer_list<int>{1, 2, 3, 4});
+        cadmium::get_messages<int_accumulator_defs::reset>(input).emplace_back();
+        s.inbox(std::move(input));
+        const int* received=cadmium::get_messages<int_accumulator_defs::add>(s._inbox).data();
+        BOOST_CHECK(step == 1 || received == inbox_memory);
+        inbox_memory = received;
+        s.advance_simulation(float(step));
+
+        s.collect_outputs(float(step));
+        BOOST_REQUIRE_EQUAL(cadmium::get_messages<int_accumulator_defs::sum>(s.outbox()).size(), 1);
+        const int* sent=cadmium::get_messages<int_accumulator_defs::sum>(s.outbox()).data();
+        BOOST_CHECK(step == 1 || sent == outbox_memory);
+        outbox_memory = sent;
+        s.advance_simulation(float(step));
+    }
+}
+
 BOOST_AUTO_TEST_CASE( accumulator_simulation_throws_test ){
     //construct a simulator for an accumulator
     using simulator_t= cadmium::engine::simulator<int_accumulator, float, cadmium::logger::not_logger>;
@@ -146,6 +173,48 @@ BOOST_AUTO_TEST_CASE( accumulator_simulation_throws_test ){
     BOOST_CHECK(s.next()==std::numeric_limits<float>::infinity());
 }
 
+BOOST_AUTO_TEST_CASE( accumulator_simulation_reports_activity_test ){
+    using simulator_t= cadmium::engine::simulator<int_accumulator, float, cadmium::logger::not_logger>;
+    using input_ports=int_accumulator<float>::input_ports;
+    simulator_t s;
+    s.init(0.0f);
+    //passive and without input
+    BOOST_CHECK(!s.imminent(1.0f));
+    BOOST_CHECK(!s.has_pending_input());
+    BOOST_CHECK(!s.active(1.0f));
+
+    //advancing an idle simulator is a nop
+    s.advance_simulation(1.0f);
+    BOOST_CHECK(s.next() == std::numeric_limits<float>::infinity());
+
+    //receiving a reset makes it active
+    typename cadmium::make_message_bags<input_ports>::type input_bags;
+    cadmium::get_messages<int_accumulator_defs::reset>(input_bags).emplace_back();
+    s.inbox(input_bags);
+    BOOST_CHECK(s.has_pending_input());
+    BOOST_CHECK(s.active(2.0f));
+    s.advance_simulation(2.0f);
+    BOOST_CHECK(!s.has_pending_input());
+
+    //then it is imminent at the time of the reset
+    BOOST_CHECK(s.imminent(2.0f));
+    BOOST_CHECK(s.active(2.0f));
+}
+
+BOOST_AUTO_TEST_CASE( accumulator_simulation_keeps_inbox_memory_test ){
+    using simulator_t= cadmium::engine::simulator<int_accumulator, float, cadmium::logger::not_logger>;
+    simulator_t s;
+    s.init(0.0f);
+    typename cadmium::make_message_bags<int_accumulator<float>::input_ports>::type input_bags;
+    cadmium::get_messages<int_accumulator_defs::add>(input_bags) = {1, 2, 3};
+    auto capacity = cadmium::get_messages<int_accumulator_defs::add>(input_bags).capacity();
+    s.inbox(std::move(input_bags));
+    s.advance_simulation(1.0f);
+    //the inbox is emptied, but the memory is kept for next messages
+    BOOST_CHECK(cadmium::get_messages<int_accumulator_defs::add>(s._inbox).empty());
+    BOOST_CHECK_EQUAL(cadmium::get_messages<int_accumulator_defs::add>(s._inbox).capacity(), capacity);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE( pdevs_generator_suite )
@@ -176,7 +245,7 @@ BOOST_AUTO_TEST_CASE( generator_model_simulation_test )
     //collecting early output produces a "false output".
     s.collect_outputs(0.5f);
     auto out = s.outbox();
-    BOOST_REQUIRE(cadmium::engine::all_bags_empty(out)); // obtaining an empty bag of messages
+    BOOST_REQUIRE(cadmium::non_empty_ports(out).none()); // obtaining an empty bag of messages
     //collecting output
     s.collect_outputs(1.0f);
     out = s.outbox();
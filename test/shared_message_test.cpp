@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <cadmium/modeling/shared_message.hpp>
+#include <cadmium/modeling/coupled_model.hpp>
+#include <cadmium/basic_model/generator.hpp>
+#include <cadmium/engine/pdevs_coordinator.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+/**
+ * This test is for messages sharing a single payload between all their receivers
+ */
+BOOST_AUTO_TEST_SUITE( shared_message_test_suite )
+
+BOOST_AUTO_TEST_CASE( copies_of_shared_message_share_the_payload_test ){
+    cadmium::shared_message<std::vector<int>> m{std::vector<int>{1, 2, 3}};
+    auto c = m;
+    BOOST_CHECK_EQUAL(&m.get(), &c.get());
+    BOOST_CHECK_EQUAL(m.use_count(), 2);
+    BOOST_CHECK(m == c);
+    BOOST_CHECK_EQUAL(c->size(), 3);
+}
+
+BOOST_AUTO_TEST_CASE( make_shared_message_builds_payload_in_place_test ){
+    auto m = cadmium::make_shared_message<std::string>(3, 'a');
+    BOOST_CHECK_EQUAL(*m, "aaa");
+    std::ostringstream oss;
+    oss << m;
+    BOOST_CHECK_EQUAL(oss.str(), "aaa");
+}
+
+//a generator broadcasting a large payload to two output ports of the coupled model
+using payload=std::vector<int>;
+using shared_payload=cadmium::shared_message<payload>;
+template<typename TIME>
+using payload_generator_base=cadmium::basic_models::generator<shared_payload, TIME>;
+using payload_generator_defs=cadmium::basic_models::generator_defs<shared_payload>;
+
+template<typename TIME>
+struct payload_generator : public payload_generator_base<TIME> {
+    float period() const override {
+        return 1.0f;
+    }
+    shared_payload output_message() const override {
+        return payload(1000, 42);
+    }
+};
+
+struct first_out : public cadmium::shared_out_port<payload>{};
+struct second_out : public cadmium::shared_out_port<payload>{};
+using broadcast_eocs=std::tuple<
+cadmium::modeling::EOC<payload_generator, payload_generator_defs::out, first_out>,
+cadmium::modeling::EOC<payload_generator, payload_generator_defs::out, second_out>
+>;
+template<typename TIME>
+using broadcast_model=cadmium::modeling::coupled_model<TIME, std::tuple<>, std::tuple<first_out, second_out>, cadmium::modeling::models_tuple<payload_generator>, std::tuple<>, broadcast_eocs, std::tuple<>>;
+
+BOOST_AUTO_TEST_CASE( fan_out_of_shared_message_does_not_copy_payload_test ){
+    cadmium::engine::coordinator<broadcast_model, float, cadmium::logger::not_logger, cadmium::engine::heap_fel> cc;
+    cc.init(0);
+    cc.collect_outputs(1.0f);
+    auto& first = cadmium::get_messages<first_out>(cc.outbox());
+    auto& second = cadmium::get_messages<second_out>(cc.outbox());
+    BOOST_REQUIRE_EQUAL(first.size(), 1);
+    BOOST_REQUIRE_EQUAL(second.size(), 1);
+    BOOST_CHECK_EQUAL(&first.at(0).get(), &second.at(0).get());
+    BOOST_CHECK_EQUAL(first.at(0)->size(), 1000);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
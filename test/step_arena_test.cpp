@@ -0,0 +1,228 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <limits>
+#include <sstream>
+
+#include <cadmium/logger/tuple_to_ostream.hpp>
+#include <cadmium/modeling/step_arena.hpp>
+#include <cadmium/modeling/message_bag.hpp>
+#include <cadmium/modeling/coupled_model.hpp>
+#include <cadmium/basic_model/int_generator_one_sec.hpp>
+#include <cadmium/basic_model/reset_generator_five_sec.hpp>
+#include <cadmium/basic_model/accumulator.hpp>
+#include <cadmium/engine/pdevs_runner.hpp>
+
+/**
+ * This test is for the arena used for allocating the messages of a simulation step
+ */
+BOOST_AUTO_TEST_SUITE( step_arena_test_suite )
+
+BOOST_AUTO_TEST_CASE( arena_reuses_memory_after_release_test ){
+    cadmium::step_arena arena{1024};
+    void* first = arena.allocate(100, alignof(double));
+    void* second = arena.allocate(100, alignof(double));
+    BOOST_CHECK(first != second);
+    BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(second) % alignof(double), 0);
+    arena.release();
+    BOOST_CHECK_EQUAL(arena.allocate(100, alignof(double)), first);
+    BOOST_CHECK_EQUAL(arena.capacity(), 1024);
+}
+
+BOOST_AUTO_TEST_CASE( arena_grows_for_large_allocations_test ){
+    cadmium::step_arena arena{64};
+    arena.allocate(32, 1);
+    arena.allocate(1000, 8);
+    BOOST_CHECK(arena.capacity() >= 1064);
+    //after release the chunks are reused and no more memory is reserved
+    std::size_t reserved = arena.capacity();
+    arena.release();
+    arena.allocate(32, 1);
+    arena.allocate(1000, 8);
+    BOOST_CHECK_EQUAL(arena.capacity(), reserved);
+}
+
+namespace {
+    struct alignas(64) cache_line_message {
+        int value;
+    };
+}
+
+BOOST_AUTO_TEST_CASE( arena_aligns_over_aligned_messages_test ){
+    cadmium::step_arena arena{100};
+    for (int i = 0; i < 4; ++i) {
+        arena.allocate(3, 1);
+        void* p = arena.allocate(sizeof(cache_line_message), alignof(cache_line_message));
+        BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(p) % 64, 0);
+    }
+
+    cadmium::step_arena_scope scope(&arena);
+    cadmium::arena_bag<cache_line_message> b;
+    for (int i = 0; i < 10; ++i) {
+        b.push_back(cache_line_message{i});
+        BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(b.data()) % 64, 0);
+    }
+    BOOST_CHECK(b.get_allocator().arena() == &arena);
+    BOOST_CHECK_EQUAL(b.back().value, 9);
+}
+
+BOOST_AUTO_TEST_CASE( bags_use_the_arena_installed_at_creation_test ){
+    cadmium::step_arena arena;
+    cadmium::arena_bag<int> heap_bag;
+    BOOST_CHECK(heap_bag.get_allocator().arena() == nullptr);
+    cadmium::arena_bag<int> copy;
+    {
+        cadmium::step_arena_scope scope(&arena);
+        cadmium::arena_bag<int> in_arena{1, 2, 3};
+        BOOST_CHECK(in_arena.get_allocator().arena() == &arena);
+        //copies of a bag are taken out of the arena, so they can outlive the step
+        copy = cadmium::arena_bag<int>(in_arena);
+        BOOST_CHECK(copy.get_allocator().arena() == nullptr);
+    }
+    BOOST_CHECK(cadmium::current_step_arena() == nullptr);
+    BOOST_CHECK_EQUAL(copy.size(), 3);
+    BOOST_CHECK_EQUAL(copy.at(2), 3);
+}
+
+//running with an arena produces same results than running without it
+namespace {
+    std::ostringstream oss;
+
+    struct oss_test_sink_provider{
+        static std::ostream& sink(){
+            return oss;
+        }
+    };
+}
+
+template<typename TIME>
+using test_accumulator=cadmium::basic_models::accumulator<int, TIME>;
+using test_accumulator_defs=cadmium::basic_models::accumulator_defs<int>;
+struct g2a_coupled_out_port : public cadmium::out_port<int>{};
+using g2a_submodels=cadmium::modeling::models_tuple<test_accumulator, cadmium::basic_models::reset_generator_five_sec, cadmium::basic_models::int_generator_one_sec>;
+using g2a_eocs=std::tuple<
+cadmium::modeling::EOC<test_accumulator, test_accumulator_defs::sum, g2a_coupled_out_port>
+>;
+using g2a_ics=std::tuple<
+cadmium::modeling::IC<cadmium::basic_models::int_generator_one_sec, cadmium::basic_models::int_generator_one_sec_defs::out, test_accumulator, test_accumulator_defs::add>,
+cadmium::modeling::IC<cadmium::basic_models::reset_generator_five_sec, cadmium::basic_models::reset_generator_five_sec_defs::out, test_accumulator, test_accumulator_defs::reset>
+>;
+template<typename TIME>
+using coupled_g2a_model=cadmium::modeling::coupled_model<TIME, std::tuple<>, std::tuple<g2a_coupled_out_port>, g2a_submodels, std::tuple<>, g2a_eocs, g2a_ics>;
+
+BOOST_AUTO_TEST_CASE( runner_with_step_arena_produces_same_messages_test ){
+    using log_messages_to_oss=cadmium::logger::logger<cadmium::logger::logger_message_routing, cadmium::logger::verbatim_formatter, oss_test_sink_provider>;
+    oss.str("");
+    cadmium::engine::runner<float, coupled_g2a_model, log_messages_to_oss> heap_runner{0.0};
+    heap_runner.runUntil(20.0);
+    std::string heap_log = oss.str();
+
+    oss.str("");
+    cadmium::engine::runner<float, coupled_g2a_model, log_messages_to_oss> arena_runner{0.0};
+    arena_runner.use_step_arena(256);
+    arena_runner.runUntil(20.0);
+    BOOST_CHECK_EQUAL(oss.str(), heap_log);
+    BOOST_CHECK(cadmium::current_step_arena() == nullptr);
+}
+
+//models with ports taking the memory of their bags from the arena
+namespace {
+    struct arena_port_defs{
+        struct out : public cadmium::out_port<int, cadmium::arena_vector_bag_policy>{};
+        struct in : public cadmium::in_port<int, cadmium::arena_vector_bag_policy>{};
+    };
+
+    template<typename TIME>
+    struct arena_burst_generator {
+        using state_type=int;
+        state_type state=0;
+        using input_ports=std::tuple<>;
+        using output_ports=std::tuple<arena_port_defs::out>;
+
+        void internal_transition() { ++state; }
+        void external_transition(TIME, typename cadmium::make_message_bags<input_ports>::type) {}
+        void confluence_transition(TIME, typename cadmium::make_message_bags<input_ports>::type) {}
+
+        typename cadmium::make_message_bags<output_ports>::type output() const {
+            typename cadmium::make_message_bags<output_ports>::type bags;
+            for (int i = 0; i < 3; ++i) {
+                cadmium::get_messages<arena_port_defs::out>(bags).push_back(state + i);
+            }
+            return bags;
+        }
+
+        TIME time_advance() const { return TIME{1}; }
+    };
+
+    template<typename TIME>
+    struct arena_summing_receiver {
+        using state_type=int;
+        state_type state=0;
+        using input_ports=std::tuple<arena_port_defs::in>;
+        using output_ports=std::tuple<>;
+
+        void internal_transition() {}
+        void external_transition(TIME, typename cadmium::make_message_bags<input_ports>::type mbs) {
+            for (int m : cadmium::get_messages<arena_port_defs::in>(mbs)) {
+                state += m;
+            }
+        }
+        void confluence_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {
+            external_transition(e, std::move(mbs));
+        }
+
+        typename cadmium::make_message_bags<output_ports>::type output() const { return {}; }
+
+        TIME time_advance() const { return std::numeric_limits<TIME>::infinity(); }
+    };
+}
+
+using arena_ports_submodels=cadmium::modeling::models_tuple<arena_burst_generator, arena_summing_receiver>;
+using arena_ports_ics=std::tuple<
+cadmium::modeling::IC<arena_burst_generator, arena_port_defs::out, arena_summing_receiver, arena_port_defs::in>
+>;
+template<typename TIME>
+using arena_ports_model=cadmium::modeling::coupled_model<TIME, std::tuple<>, std::tuple<>, arena_ports_submodels, std::tuple<>, std::tuple<>, arena_ports_ics>;
+
+BOOST_AUTO_TEST_CASE( runner_allocates_bags_of_arena_ports_from_the_arena_test ){
+    using log_states_to_oss=cadmium::logger::logger<cadmium::logger::logger_state, cadmium::logger::verbatim_formatter, oss_test_sink_provider>;
+    oss.str("");
+    cadmium::engine::runner<float, arena_ports_model, log_states_to_oss> heap_runner{0.0};
+    heap_runner.runUntil(10.0);
+    std::string heap_log = oss.str();
+
+    oss.str("");
+    cadmium::step_arena arena{256};
+    cadmium::engine::runner<float, arena_ports_model, log_states_to_oss> arena_runner{0.0};
+    arena_runner.use_step_arena(arena);
+    arena_runner.runUntil(10.0);
+    BOOST_CHECK_EQUAL(oss.str(), heap_log);
+    BOOST_CHECK(arena.capacity() > 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
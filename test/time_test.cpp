@@ -0,0 +1,138 @@
+/**
+ * Copyright (c) 2013-2017, Damian Vicino
+ * Carleton University, Universite de Nice-Sophia Antipolis
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <limits>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include <cadmium/modeling/time.hpp>
+#include <cadmium/logger/tuple_to_ostream.hpp>
+#include <cadmium/basic_model/int_generator_one_sec.hpp>
+#include <cadmium/basic_model/reset_generator_five_sec.hpp>
+#include <cadmium/basic_model/accumulator.hpp>
+#include <cadmium/basic_model/passive.hpp>
+#include <cadmium/modeling/coupled_model.hpp>
+#include <cadmium/engine/pdevs_runner.hpp>
+
+/**
+ * This test checks the integer time types and runs models with them
+ */
+
+BOOST_AUTO_TEST_SUITE( time_test_suite )
+
+using millis=cadmium::time::ticks<std::milli>;
+using nanos=cadmium::time::ticks<>;
+
+BOOST_AUTO_TEST_CASE( seconds_are_converted_to_ticks_test ){
+    BOOST_CHECK_EQUAL(millis(1.5).count(), 1500);
+    BOOST_CHECK_EQUAL(millis(0.0004).count(), 0);
+    BOOST_CHECK_EQUAL(millis(-0.0016).count(), -2);
+    BOOST_CHECK_EQUAL(nanos(2).count(), 2000000000);
+    BOOST_CHECK_EQUAL(millis{}.count(), 0);
+    BOOST_CHECK_EQUAL(cadmium::time::fixed_point<16>(0.5).count(), 32768);
+    BOOST_CHECK_EQUAL(cadmium::time::ticks<std::ratio<60>>(120).count(), 2);
+    BOOST_CHECK_EQUAL(static_cast<double>(millis::from_count(2500)), 2.5);
+    BOOST_CHECK_THROW(millis(std::numeric_limits<double>::quiet_NaN()), std::domain_error);
+
+    std::ostringstream oss;
+    oss << millis(1.25) << " " << millis::infinity();
+    BOOST_CHECK_EQUAL(oss.str(), "1.25 inf");
+}
+
+BOOST_AUTO_TEST_CASE( infinity_saturates_test ){
+    const millis inf = std::numeric_limits<millis>::infinity();
+    BOOST_CHECK(std::numeric_limits<millis>::has_infinity);
+    BOOST_CHECK(inf == millis(std::numeric_limits<double>::infinity()));
+    BOOST_CHECK(inf + millis(5) == inf);
+    BOOST_CHECK(millis(5) + inf == inf);
+    BOOST_CHECK(inf - millis(5) == inf);
+    BOOST_CHECK(std::numeric_limits<millis>::max() + millis::from_count(1) == inf);
+    BOOST_CHECK(std::numeric_limits<millis>::max() < inf);
+    BOOST_CHECK(std::numeric_limits<millis>::lowest() - millis::from_count(1) == std::numeric_limits<millis>::lowest());
+    BOOST_CHECK(std::numeric_limits<millis>::min() == millis::from_count(1));
+    BOOST_CHECK(nanos(1e30) == std::numeric_limits<nanos>::infinity());
+    BOOST_CHECK(nanos(std::numeric_limits<std::int64_t>::max()) == std::numeric_limits<nanos>::infinity());
+    BOOST_CHECK_THROW(millis(5) - inf, std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE( sums_are_exact_test ){
+    millis t;
+    float f = 0;
+    for (int i = 0; i < 10000; ++i) {
+        t += millis(0.1);
+        f += 0.1f;
+    }
+    BOOST_CHECK(t == millis(1000));
+    BOOST_CHECK(f != 1000.0f);
+}
+
+template<typename TIME>
+using test_accumulator=cadmium::basic_models::accumulator<int, TIME>;
+using test_accumulator_defs=cadmium::basic_models::accumulator_defs<int>;
+
+struct g2a_out : public cadmium::out_port<int>{};
+using g2a_submodels=cadmium::modeling::models_tuple<test_accumulator, cadmium::basic_models::reset_generator_five_sec, cadmium::basic_models::int_generator_one_sec>;
+using g2a_eocs=std::tuple<
+cadmium::modeling::EOC<test_accumulator, test_accumulator_defs::sum, g2a_out>
+>;
+using g2a_ics=std::tuple<
+cadmium::modeling::IC<cadmium::basic_models::int_generator_one_sec, cadmium::basic_models::int_generator_one_sec_defs::out, test_accumulator, test_accumulator_defs::add>,
+cadmium::modeling::IC<cadmium::basic_models::reset_generator_five_sec, cadmium::basic_models::reset_generator_five_sec_defs::out , test_accumulator, test_accumulator_defs::reset>
+>;
+template<typename TIME>
+using g2a_model=cadmium::modeling::coupled_model<TIME, std::tuple<>, std::tuple<g2a_out>, g2a_submodels, std::tuple<>, g2a_eocs, g2a_ics>;
+
+template<typename TIME>
+std::vector<std::pair<double, int>> g2a_outputs(const TIME& until) {
+    cadmium::engine::runner<TIME, g2a_model, cadmium::logger::not_logger> r{TIME{}};
+    std::vector<std::pair<double, int>> outputs;
+    r.runUntil(until, [&outputs](const TIME& t, const std::tuple<cadmium::message_bag<g2a_out>>& bags) {
+        for (int s : cadmium::get_messages<g2a_out>(bags)) {
+            outputs.emplace_back(static_cast<double>(t), s);
+        }
+    });
+    return outputs;
+}
+
+BOOST_AUTO_TEST_CASE( models_run_with_integer_time_as_with_float_test ){
+    auto expected = g2a_outputs<float>(1000.0f);
+    BOOST_REQUIRE(!expected.empty());
+    BOOST_CHECK((g2a_outputs<millis>(1000) == expected));
+    BOOST_CHECK((g2a_outputs<cadmium::time::fixed_point<20>>(1000) == expected));
+}
+
+template<typename TIME>
+using test_passive=cadmium::basic_models::passive<int, TIME>;
+
+BOOST_AUTO_TEST_CASE( passive_models_passivate_with_integer_time_test ){
+    cadmium::engine::runner<millis, test_passive, cadmium::logger::not_logger> r{millis{}};
+    BOOST_CHECK(r.runUntilPassivate() == std::numeric_limits<millis>::infinity());
+}
+
+BOOST_AUTO_TEST_SUITE_END()